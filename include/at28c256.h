@@ -1,23 +1,85 @@
 #ifndef AT28C256_H
 #define AT28C256_H
 
+#include <chrono>
+#include <cstddef>
+#include <string>
+
 #include "bus.h"
 #include "memory.h"
 #include "types.h"
 
 class AT28C256 : public MEM_Module {
-   public:                   // Make memory public for debugging purposes
-    byte memory[32 * 1024];  // 32KB
+   public:         // Make memory public for debugging purposes
+    byte* memory;  // 32KB, points either at `storage` or at a mapped image
    private:
     Bus& bus;
 
+    byte storage[32 * 1024];  // Internal array
+    byte* backing = storage;  // Array used when no image is mapped (see `use_storage`)
+    byte* mapping = nullptr;  // Base of the mmap'd image (nullptr when not mapped)
+    size_t mapping_size = 0;  // Length of the mapping in bytes
+    bool writable = true;     // False for shared read-only images
+
+    // Write-back state for `RomMapping::PERSISTENT` images
+    bool persistent = false;                          // Writes land in a shared mapping of the image file
+    size_t dirty_lo = 32 * 1024;                      // Lowest offset written since the last sync
+    size_t dirty_hi = 0;                              // Highest offset written since the last sync
+    std::chrono::milliseconds sync_interval{0};       // Time between background syncs (0 = only on shutdown)
+    std::chrono::steady_clock::time_point last_sync;  // When the dirty range was last flushed
+
+    // Write cycle emulation (only active once a cycle counter is attached)
+    //
+    // A write opens a byte load window (tBLC). Further writes to the same
+    // 64 byte page within the window extend it, otherwise the internal
+    // write cycle (tWC) starts. While it runs the chip answers every read
+    // with DATA polling (I/O7 inverted) and toggle bit (I/O6) status.
+    enum class WritePhase : byte { IDLE, LOADING, WRITING };
+
+    uint64_t* cycle_counter = nullptr;    // Emulated clock, writes are instant without one
+    uint64_t byte_load_cycles = 150;      // tBLC in clock cycles (150us at 1MHz)
+    uint64_t write_cycles = 10000;        // tWC in clock cycles (10ms at 1MHz)
+    WritePhase phase = WritePhase::IDLE;  // Where the chip is in a write
+    byte page_buffer[64];                 // Bytes latched during the load phase
+    uint64_t page_mask = 0;               // Which bytes of `page_buffer` were loaded
+    word page_base = 0;                   // First address of the page being written
+    uint64_t load_deadline = 0;           // The load phase ends if no write arrives before this
+    uint64_t busy_until = 0;              // End of the internal write cycle
+    byte last_written = 0xFF;             // Last byte loaded, polled on I/O7
+    bool toggle = false;                  // I/O6, flips on every read while busy
+
+    // Store a byte into the array, honoring read-only images
+    void store(word addr, byte data);
+
+    // Accept a write from the CPU side (goes through the page buffer when timed)
+    void latch(word addr, byte data);
+
+    // Serve a read from the CPU side (status bits while a write cycle runs)
+    byte fetch(word addr);
+
+    // Write the loaded bytes of the page buffer into the array
+    void commit_page();
+
+    // Move the write state machine up to `now`
+    void advance(uint64_t now);
+
+    // Record a written range and kick off a sync when the interval is due
+    void mark_dirty(size_t lo, size_t hi);
+
    public:
-    AT28C256(Bus& bus) : bus(bus) {
-        // Initialize memory to 0xFF (unprogrammed state)
-        for (int i = 0; i < 32768; ++i) {
-            memory[i] = 0xFF;
-        }
-    }
+    // Creates an unprogrammed (all 0xFF) EEPROM
+    AT28C256(Bus& bus);
+
+    // Creates an EEPROM backed directly by an image file
+    //
+    // Note:
+    //  - Nothing is copied, pages are faulted in by the host on first access
+    //  - Throws `std::runtime_error` if the image can't be mapped
+    AT28C256(Bus& bus, const std::string& image_path, RomMapping mode = RomMapping::PRIVATE);
+
+    AT28C256(const AT28C256&) = delete;
+    AT28C256& operator=(const AT28C256&) = delete;
+    ~AT28C256();
 
     union {
         pinl_t PINS;  // Raw access to all pins at once
@@ -73,11 +135,83 @@ class AT28C256 : public MEM_Module {
     // Stop monitoring the bus
     void stop_monitoring();
 
+    // Back the chip with an image file instead of the internal array
+    //
+    // Note:
+    //  - `PRIVATE` keeps firmware writes local to this process (copy-on-write)
+    //  - `SHARED_READONLY` shares the page cache with every other instance
+    //    and silently drops writes, like a ROM with WE tied high
+    //  - `PERSISTENT` writes through to the file, so the contents survive
+    //    restarts like the real non-volatile chip. Missing or short files
+    //    are created / padded with 0xFF
+    //  - Other images shorter than 32KB are copied instead and padded with 0xFF
+    //  - After `use_storage` moved the contents out, images are copied into
+    //    that storage as well, and `PERSISTENT` fails
+    bool map_image(const std::string& path, RomMapping mode);
+
+    // Drop the mapped image and go back to an unprogrammed internal array
+    //
+    // Note: persistent images are synced to disk first
+    void unmap_image();
+
+    // Flush the pages written since the last sync of a persistent image
+    //
+    // Note:
+    //  - `wait` blocks until the data is on disk (MS_SYNC), otherwise the
+    //    write-back is only scheduled (MS_ASYNC)
+    //  - Writes are visible to other mappings of the file right away, this
+    //    only controls when they are guaranteed to be durable
+    bool sync(bool wait = true);
+
+    // Schedule an asynchronous sync at most every `interval` (0, the
+    // default, only syncs on `sync()` and on shutdown)
+    //
+    // Note: the interval is checked when the firmware writes, so the last
+    // writes of a burst wait for the next write after the interval, an
+    // explicit `sync()` or shutdown
+    void set_sync_interval(std::chrono::milliseconds interval);
+
+    // Keep the contents in `external` (32KB, e.g. a shared memory segment)
+    // instead of the internal array, nullptr goes back to the internal one
+    //
+    // Note:
+    //  - The current contents are copied over
+    //  - Fails (logged) while an image is mapped, move the storage first
+    //    and `map_image` copies the image into it
+    bool use_storage(byte* external);
+
+    // Whether the contents are an mmap'd image file
+    bool is_mapped() const { return mapping != nullptr; }
+
+    // Copy a block of bytes into the chip starting at `offset`
+    void load(const byte* data, size_t size, word offset);
+
+    // Whether firmware writes will land in memory
+    bool is_writable() const { return writable; }
+
+    // Drive the write cycle timing from an emulated cycle counter
+    // (usually `WDC65C02::cycles`) running at `clock_hz`
+    //
+    // Note:
+    //  - Page writes, the ~10ms busy period and DATA / toggle bit polling
+    //    are then modeled on the emulated clock, never with host sleeps
+    //  - Pass nullptr to go back to instant writes
+    void attach_cycle_counter(uint64_t* counter, double clock_hz = 1000000.0);
+
+    // Whether an internal write cycle is still in progress
+    bool is_busy();
+
     // Memory interface implementation
     word read_word(word addr) override;
     byte read_byte(byte addr) override;
     void write_word(word addr, word data) override;
     void write_byte(byte addr, byte data) override;
+    const byte* read_span(word offset, size_t& length) override;  // Not during a write cycle
+
+    // End of the byte load window or the write cycle, which lets the CPU's
+    // idle loop skip (`WDC65C02::set_idle_skip`) fast-forward firmware
+    // polling for write completion
+    uint64_t next_event() override;
 };
 
 #endif  // AT28C256 EEPROM interface
@@ -0,0 +1,104 @@
+#ifndef BANKED_MEMORY_H
+#define BANKED_MEMORY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "io_device.h"
+#include "memory.h"
+#include "types.h"
+
+// Large RAM or ROM that the CPU only sees through bank windows
+//
+// The boards with more than 64KB of memory page fixed size banks
+// (16KB by default) of a 512KB RAM or flash chip into windows of the
+// CPU address space. `BankedMemory` is the chip, `BankWindow` is one
+// window of the address space, and `BankRegister` is the latch the
+// firmware writes to select which bank each window shows.
+class BankedMemory {
+   private:
+    std::vector<byte> storage;
+    uint32_t bank_size;
+    bool writable;
+
+   public:
+    // Blank memory: RAM is cleared, ROM reads as erased flash (0xFF)
+    BankedMemory(uint32_t size = 512 * 1024, uint32_t bank_size = 16 * 1024, bool writable = true);
+
+    // ROM initialized from an image file, the image is padded with 0xFF
+    // up to a whole number of banks. Throws if the file can't be read.
+    BankedMemory(const std::string& image_path, uint32_t bank_size = 16 * 1024);
+
+    BankedMemory(const BankedMemory&) = delete;
+    BankedMemory& operator=(const BankedMemory&) = delete;
+
+    // Start of bank `n`, bank numbers wrap like the unused upper bits of
+    // a real bank latch
+    byte* bank(uint32_t n) { return storage.data() + (n % banks()) * bank_size; }
+
+    uint32_t banks() const { return storage.size() / bank_size; }
+    uint32_t get_bank_size() const { return bank_size; }
+    bool is_writable() const { return writable; }
+
+    // Copy a block into the memory at a linear offset
+    void load(const byte* data, size_t size, uint32_t offset = 0);
+};
+
+// A window of the address space showing one bank of a `BankedMemory`
+//
+// Switching banks only swaps the window's base pointer, so it costs the
+// same no matter how large the memory or the window is. The decoder's
+// page table keeps pointing at the window and never has to be rebuilt.
+class BankWindow : public MEM_Module {
+   private:
+    BankedMemory& memory;
+    byte* base;     // Start of the selected bank
+    word mask;      // Offset mask within a bank
+    byte selected;  // Selected bank number
+
+   public:
+    BankWindow(BankedMemory& memory, byte bank = 0);
+
+    // Show bank `n` in the window
+    void select(byte n) {
+        selected = n;
+        base = memory.bank(n);
+    }
+
+    byte selected_bank() const { return selected; }
+
+    // Memory interface implementation
+    word read_word(word addr) override { return base[addr & mask]; }
+    byte read_byte(byte addr) override { return base[addr & mask]; }
+    void write_word(word addr, word data) override {
+        if (memory.is_writable()) base[addr & mask] = data & 0xFF;
+    }
+    void write_byte(byte addr, byte data) override {
+        if (memory.is_writable()) base[addr & mask] = data;
+    }
+    const byte* read_span(word offset, size_t& length) override {
+        length = mask + 1 - (offset & mask);
+        return base + (offset & mask);
+    }
+    byte* write_span(word offset, size_t& length) override {
+        if (!memory.is_writable()) return nullptr;
+        length = mask + 1 - (offset & mask);
+        return base + (offset & mask);
+    }
+};
+
+// Bank select latches, register n selects the bank shown in window n
+class BankRegister : public IO_Device {
+   private:
+    std::vector<BankWindow*> windows;
+
+   public:
+    // Add a window, it is controlled by the next register
+    void add_window(BankWindow* window) { windows.push_back(window); }
+
+    byte io_read(word reg) override;
+    void io_write(word reg, byte data) override;
+};
+
+#endif  // BANKED_MEMORY_H
@@ -0,0 +1,95 @@
+#ifndef BATCH_CPU_H
+#define BATCH_CPU_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+// Runs many copies of one 65C02 machine in lockstep
+//
+// Meant for sweeping one ROM over many inputs: every lane has its own
+// registers and RAM (0 up to `ram_size`) and all lanes share a read-only
+// image above that. State is kept as structure of arrays, registers as
+// one array per register and RAM as one row of lanes per address, so an
+// instruction runs for a whole group of lanes with a few vector
+// operations on contiguous bytes.
+//
+// Lanes are processed in blocks of `BLOCK`. Within a block every lane at
+// the same PC in the shared image executes the instruction together,
+// lanes at other PCs form further groups in the same step, so divergent
+// lanes cost one pass per distinct PC. Code running from RAM, which may
+// differ per lane, runs one lane at a time.
+//
+// The instructions and cycle counts are those of `WDC65C02::step()`.
+// There are no devices and no interrupts: BRK, WAI and unimplemented
+// opcodes halt the lane.
+class BatchCPU {
+   public:
+    static constexpr int BLOCK = 32;  // Lanes per vector block
+
+    // One lane's registers, for setting up inputs and reading results
+    struct LaneState {
+        word PC = 0;
+        byte A = 0;
+        byte X = 0;
+        byte Y = 0;
+        byte SP = 0xFF;
+        byte FLAGS = 0x04;
+        uint64_t cycles = 0;
+        CPU_State state = CPU_State::RUNNING;
+    };
+
+   private:
+    int lane_count;     // Lanes in use
+    int stride;         // Lanes rounded up to whole blocks
+    uint32_t ram_size;  // Per lane RAM covers 0 to ram_size - 1
+
+    // Registers, one entry per lane (padding lanes are halted)
+    std::vector<word> PC;
+    std::vector<byte> A, X, Y, SP, FLAGS;
+    std::vector<uint64_t> cycles;
+    std::vector<byte> states;  // CPU_State values
+
+    std::vector<byte> ram;     // ram[addr * stride + lane]
+    std::vector<byte> shared;  // 64K image seen by every lane above the RAM
+
+    // One instruction for every running lane in `block`
+    void step_block(int block);
+
+    // Scalar path for instructions whose addresses or table lookups differ
+    // per lane
+    void step_lane(int lane, byte opcode, word operand);
+
+   public:
+    // `lanes` machines with `ram_size` bytes of RAM each (at most 64K)
+    BatchCPU(int lanes, uint32_t ram_size = 0x8000);
+
+    int lanes() const { return lane_count; }
+
+    // Copy `size` bytes to the shared image at `addr`
+    void load_shared(word addr, const byte* data, size_t size);
+
+    // Per lane memory access, RAM for the lane or the shared image
+    byte read(int lane, word addr) const;
+    void write(int lane, word addr, byte value);
+
+    LaneState lane(int lane) const;
+    void set_lane(int lane, const LaneState& state);
+
+    // Reset every lane: PC from the reset vector, SP 0xFF, I set
+    void reset();
+
+    // Execute one instruction on every running lane
+    void step();
+
+    // Step until no lane is running or `max_steps` steps have run,
+    // returns the number of steps
+    uint64_t run(uint64_t max_steps = UINT64_MAX);
+
+    // Lanes that haven't halted
+    int running_lanes() const;
+};
+
+#endif  // BATCH_CPU_H
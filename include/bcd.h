@@ -0,0 +1,49 @@
+#ifndef BCD_H
+#define BCD_H
+
+#include <array>
+#include <cstdint>
+
+#include "types.h"
+
+// ADC / SBC arithmetic
+//
+// Decimal mode results come from tables filled once at startup, one entry
+// per carry, accumulator and operand, so a BCD add or subtract is a single
+// load instead of the nibble corrections and their branches.
+// Binary mode is a handful of integer operations and is computed directly.
+//
+// The decimal results follow the 65C02: N and Z reflect the BCD result, C
+// is the decimal carry (ADC) or borrow (SBC), V is the 65C02's (from the
+// intermediate sum for ADC, as in binary mode for SBC), and operands that
+// aren't valid BCD give the values the chip gives.
+
+// Accumulator and flags after an ADC / SBC
+struct AluResult {
+    byte value;
+    byte flags;  // N, V, Z and C at their FLAGS positions, the other bits 0
+};
+
+constexpr byte ALU_FLAGS = 0xC3;  // N V - - - - Z C
+
+constexpr uint32_t DECIMAL_TABLE_SIZE = 0x20000;
+
+// Indexed by `decimal_index`
+extern const std::array<AluResult, DECIMAL_TABLE_SIZE> DECIMAL_ADC;
+extern const std::array<AluResult, DECIMAL_TABLE_SIZE> DECIMAL_SBC;
+
+constexpr uint32_t decimal_index(byte a, byte operand, bool carry) {
+    return (static_cast<uint32_t>(carry) << 16) | (a << 8) | operand;
+}
+
+constexpr AluResult binary_adc(byte a, byte operand, bool carry) {
+    unsigned sum = a + operand + carry;
+    byte value = sum & 0xFF;
+    bool overflow = (~(a ^ operand) & (a ^ value) & 0x80) != 0;
+    return {value, static_cast<byte>((value & 0x80) | (overflow << 6) | ((value == 0) << 1) | (sum > 0xFF))};
+}
+
+// Subtraction is addition of the complement, carry clear means borrow
+constexpr AluResult binary_sbc(byte a, byte operand, bool carry) { return binary_adc(a, ~operand, carry); }
+
+#endif  // BCD_H
@@ -1,13 +1,31 @@
 #ifndef BUS_H
 #define BUS_H
 
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
 #include <mutex>
 #include <vector>
 
+#include "metrics.h"
 #include "types.h"
 
+// A device that can take the bus from the CPU for whole bus cycles (DMA)
+//
+// Masters don't wait on the bus mutex. The CPU hands the bus over between
+// instructions through `Bus::arbitrate`, holding RDY low while the master
+// runs, and the master's cycles pass on the CPU's cycle counter.
+class BusMaster {
+   public:
+    // Whether the master wants the bus now
+    virtual bool bus_requested() = 0;
+
+    // Use the bus for at most `max_cycles` cycles, returns the cycles used
+    virtual uint32_t run_bus_cycles(uint32_t max_cycles) = 0;
+
+    virtual ~BusMaster() = default;
+};
+
 // The first 16-bits (`WORD_1`) will be reserved for the address lines
 // and like that the next 8-bits (`BYTE_3`) are for the data lines
 // the rest is flexible in use
@@ -23,6 +41,28 @@ class Bus {
     bool bus_in_use = false;                  // Flag indicating if bus is currently being used
     BusOwner current_owner = BusOwner::NONE;  // Current component owning the bus
 
+    // Masters that can take the bus from the CPU (see `add_master`)
+    struct Master {
+        BusMaster* master;
+        byte priority;   // Higher wins
+        uint32_t burst;  // Most cycles per grant
+    };
+    std::vector<Master> masters;  // Sorted by priority, highest first
+    size_t next_turn = 0;         // Round robin start among equal priorities
+
+    // Start of a wait for the bus, only read when metrics are on
+    static std::chrono::steady_clock::time_point wait_start() {
+        if (!metrics::enabled.load(std::memory_order_relaxed)) return std::chrono::steady_clock::time_point();
+        return std::chrono::steady_clock::now();
+    }
+
+    // Count a wait for the bus that began at `start`
+    static void record_wait(std::chrono::steady_clock::time_point start) {
+        if (!metrics::enabled.load(std::memory_order_relaxed)) return;
+        auto waited = std::chrono::steady_clock::now() - start;
+        metrics::record_bus_wait(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count());
+    }
+
    public:
     // Creates a variable width bus
     Bus(uint8_t width) : power(true), width(width) {}
@@ -156,13 +196,17 @@ class Bus {
 
     // Request exclusive access to the bus for a component
     bool request_bus(BusOwner owner, uint32_t timeout_ms = 100) {
+        auto start = wait_start();
         std::unique_lock<std::mutex> lock(bus_mutex);
         if (!bus_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() { return !bus_in_use; })) {
+            if (metrics::enabled.load(std::memory_order_relaxed)) metrics::add(metrics::BUS_TIMEOUTS);
             return false;  // Timeout occurred
         }
 
         bus_in_use = true;
         current_owner = owner;
+        lock.unlock();
+        record_wait(start);
         return true;
     }
 
@@ -176,20 +220,57 @@ class Bus {
         }
     }
 
-    // Perform a complete bus transaction atomically
+    // Perform a complete bus transaction as `owner`
+    //
+    // Waits until no other component holds the bus and keeps it for the
+    // whole of `operation`, which may use the bus accessors itself
     template <typename Func>
     auto atomic_bus_operation(BusOwner owner, Func operation) -> decltype(operation()) {
-        std::lock_guard<std::mutex> lock(bus_mutex);
+        auto start = wait_start();
+        {
+            std::unique_lock<std::mutex> lock(bus_mutex);
+            bus_cv.wait(lock, [this]() { return !bus_in_use; });
+            bus_in_use = true;
+            current_owner = owner;
+        }
+        record_wait(start);
+
+        // Released on the way out, exceptions included
+        struct Release {
+            Bus& bus;
+            BusOwner owner;
+            ~Release() { bus.release_bus(owner); }
+        } release{*this, owner};
+
         return operation();
     }
 
+    // Let `master` take the bus from the CPU
+    //
+    // Note:
+    //  - The pending master with the highest `priority` wins, masters of
+    //    equal priority take turns. The CPU ranks below every master
+    //  - A grant lasts at most `burst` cycles (0 for no limit). The CPU
+    //    runs an instruction between grants, so a short burst steals
+    //    cycles from a running program instead of stopping it
+    void add_master(BusMaster* master, byte priority, uint32_t burst = 0);
+
+    bool has_masters() const { return !masters.empty(); }
+
+    // Give the bus to the master that wins arbitration, if any wants it,
+    // and return the cycles it used (0 when the CPU keeps the bus)
+    //
+    // Note: called by the CPU between instructions, on its own thread
+    uint32_t arbitrate();
+
     Bus& operator=(const Bus& other) {
         if (this != &other) {
             std::lock_guard<std::mutex> lock(bus_mutex);
             this->power = other.power;
             this->width = other.width;
-            this->lines = other.lines;  // Copy the lines vector
-            this->PINS = other.PINS;    // Copy the pin values
+            this->lines = other.lines;      // Copy the lines vector
+            this->PINS = other.PINS;        // Copy the pin values
+            this->masters = other.masters;  // And who can take the bus
         }
         return *this;
     }
@@ -0,0 +1,105 @@
+#ifndef CONDITION_H
+#define CONDITION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "decoder.h"
+#include "types.h"
+
+class WDC65C02;
+
+// A run-until condition, compiled once into flat bytecode
+//
+// The language is small:
+//
+//   A == $42 && PC in $8100-$81FF
+//   [$0200] changes
+//   (X > 3 || C) && !(cycles >= 100000)
+//   mem[$0300 | Y] & $80
+//
+// - Operands: the registers A, X, Y, SP, PC and P, the flags C, Z, I,
+//   D, V and N, `cycles`, and memory as `[addr]`, `mem[addr]` or
+//   `memory[addr]`
+// - Numbers: `$FF` / `0xFF` hex, `%1010` binary or decimal
+// - Operators, loosest first: `||`, `&&`, `!`, comparisons (`==`, `!=`,
+//   `<`, `<=`, `>`, `>=`, `in lo-hi`), `|`, `&`
+// - `[addr] changes` is true once the byte differs from its value when
+//   the condition was armed (the address must be a constant)
+//
+// Names are case insensitive. A malformed condition throws
+// `std::invalid_argument` from the constructor.
+class Condition {
+   public:
+    enum class Op : byte {
+        CONST,    // Push the operand
+        REG_A,    // Push a register
+        REG_X,
+        REG_Y,
+        REG_SP,
+        REG_PC,
+        REG_P,
+        FLAG,     // Push bit `operand` of P
+        CYCLES,   // Push the cycle counter
+        MEM,      // Pop an address, push the byte there
+        MEM_AT,   // Push the byte at the constant address `operand`
+        CHANGED,  // Push whether watched byte `operand` differs from its armed value
+        EQ,       // Comparisons pop two values, push 0 / 1
+        NE,
+        LT,
+        LE,
+        GT,
+        GE,
+        IN,       // Pop hi, lo, value, push lo <= value <= hi
+        BIT_AND,  // Bitwise operators
+        BIT_OR,
+        NOT,      // Logical operators
+        AND,
+        OR
+    };
+
+    struct Instruction {
+        Op op;
+        int64_t operand;
+    };
+
+   private:
+    static constexpr int STACK_SIZE = 32;
+
+    std::string source;
+    std::vector<Instruction> code;
+
+    std::vector<word> addresses;  // Constant addresses the condition reads
+    std::vector<word> watched;    // Addresses used with `changes`
+    std::vector<byte> armed;      // Their values when the condition was armed
+    bool cpu_state = false;       // Whether registers, flags or the cycle counter are referenced
+    bool dynamic_memory = false;  // Whether a memory address is computed at run time
+
+    // Recursive descent parser emitting into `code`
+    class Compiler;
+
+   public:
+    explicit Condition(const std::string& source);
+
+    // Capture the current value of every `changes` address
+    void arm(AddressDecoder& decoder);
+
+    // Evaluate against the CPU and memory
+    //
+    // Note: memory is read through the decoder without triggering
+    // watchpoints, but reading an I/O register still has its side effects
+    bool eval(const WDC65C02& cpu, AddressDecoder& decoder) const;
+
+    // True when the result can only change after a write to one of
+    // `referenced()`, so it only needs to be evaluated after those writes
+    bool memory_only() const { return !cpu_state && !dynamic_memory; }
+
+    // Constant addresses the condition reads
+    const std::vector<word>& referenced() const { return addresses; }
+
+    const std::string& text() const { return source; }
+    const std::vector<Instruction>& bytecode() const { return code; }
+};
+
+#endif  // CONDITION_H
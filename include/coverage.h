@@ -0,0 +1,67 @@
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "decoder.h"
+#include "types.h"
+
+// What an address was used for
+enum class CoverageKind : byte {
+    OPCODE = 0,   // Fetched as the opcode of an instruction
+    OPERAND = 1,  // Fetched as an instruction operand
+    READ = 2,     // Read as data (including stack pulls and vectors)
+    WRITE = 3     // Written
+};
+
+// Code and data coverage of the 64K address space
+//
+// One 64K bit bitmap per `CoverageKind`, set by the CPU with a single OR
+// per access (see `WDC65C02::attach_coverage`), so it can stay on for
+// whole regression runs. Bitmaps from many runs are merged with `merge`
+// or accumulated in a file with `save` / `merge_file`.
+class Coverage {
+   public:
+    static constexpr int KINDS = 4;
+    static constexpr int WORDS = 65536 / 64;
+
+   private:
+    uint64_t bits[KINDS][WORDS];
+
+   public:
+    Coverage() { clear(); }
+
+    void mark(CoverageKind kind, word addr) {
+        bits[static_cast<int>(kind)][addr >> 6] |= uint64_t{1} << (addr & 63);
+    }
+
+    bool covered(CoverageKind kind, word addr) const {
+        return (bits[static_cast<int>(kind)][addr >> 6] >> (addr & 63)) & 1;
+    }
+
+    // Number of addresses in start-end marked with `kind`
+    uint32_t count(CoverageKind kind, word start = 0x0000, word end = 0xFFFF) const;
+
+    void clear();
+
+    // OR another run's bitmaps into this one
+    void merge(const Coverage& other);
+
+    // Write the bitmaps to a file (an 8 byte header followed by the raw
+    // bitmaps), false on failure
+    bool save(const std::string& path) const;
+
+    // Merge the bitmaps saved in a file, false if it can't be read or
+    // isn't a coverage file
+    bool merge_file(const std::string& path);
+
+    // Annotated listing of start-end: executed instructions are
+    // disassembled, data accesses marked, and uncovered runs collapsed
+    //
+    // Note: the bytes are read through the decoder, keep I/O ranges out
+    void report(std::ostream& out, AddressDecoder& decoder, word start = 0x8000, word end = 0xFFFF) const;
+};
+
+#endif  // COVERAGE_H
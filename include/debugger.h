@@ -0,0 +1,128 @@
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+
+#include <bitset>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "condition.h"
+#include "decoder.h"
+#include "types.h"
+
+class WDC65C02;
+
+// What a watchpoint triggers on
+enum class WatchType : byte {
+    READ = 0x01,   // Data reads (and opcode / operand fetches)
+    WRITE = 0x02,  // Data writes
+    ACCESS = 0x03  // Either
+};
+
+struct Breakpoint {
+    int id;
+    word start;  // First address of the range
+    word end;    // Last address of the range
+};
+
+struct Watchpoint {
+    int id;
+    word start;  // First address of the range
+    word end;    // Last address of the range
+    WatchType type;
+    int value;     // Only trigger when this value is read / written, -1 for any value
+    bool trigger;  // Internal to `run_until`, flags a write instead of stopping
+};
+
+// Why the CPU stopped
+struct DebugHit {
+    int id;           // Breakpoint or watchpoint that triggered
+    bool breakpoint;  // Execution breakpoint (otherwise a watchpoint)
+    bool write;       // The access was a write
+    word addr;        // PC for breakpoints, accessed address for watchpoints
+    byte value;       // Value read or written
+    uint64_t cycle;   // CPU cycle of the hit
+};
+
+// Execution breakpoints and read / write watchpoints
+//
+// Everything is armed per 256 byte page. A page with watchpoints has a
+// hook swapped into the decoder's page table, pages without any keep
+// the direct lookup and never pay for a check. Breakpoints are checked
+// in the CPU's fetch path against a page bitmap, so only PCs in pages
+// with breakpoints compare against the list.
+//
+// On a hit the CPU is put in `CPU_State::STOPPED`. Watchpoints let the
+// access and the rest of the instruction complete (like a hardware
+// watchpoint), breakpoints stop before the instruction executes.
+class Debugger {
+   private:
+    WDC65C02& cpu;
+    AddressDecoder& decoder;
+
+    std::vector<Breakpoint> breakpoints;
+    std::vector<Watchpoint> watchpoints;
+    std::bitset<256> break_pages;                  // Pages containing a breakpoint
+    std::unique_ptr<MEM_Module> watch_hooks[256];  // Hooks of the pages containing a watchpoint
+    int next_id = 1;
+
+    bool skip_once = false;  // Let the instruction at `skip_pc` run once after resuming
+    word skip_pc = 0;
+
+    std::function<void(const DebugHit&)> on_hit;
+
+    bool triggered = false;  // A `run_until` trigger address was written
+
+    // Re-arm the pages overlapping start-end after a change
+    void rearm(word start, word end);
+
+    void stop(const DebugHit& hit);
+
+    bool check_breakpoint(word pc);
+
+   public:
+    DebugHit last_hit{};  // Most recent hit
+
+    Debugger(WDC65C02& cpu, AddressDecoder& decoder);
+    ~Debugger();
+
+    Debugger(const Debugger&) = delete;
+    Debugger& operator=(const Debugger&) = delete;
+
+    // Stop before executing any instruction in start-end, returns its id
+    int add_breakpoint(word start, word end);
+    int add_breakpoint(word addr) { return add_breakpoint(addr, addr); }
+
+    // Stop after an access to start-end, optionally only when `value` is
+    // read or written, returns its id
+    int add_watchpoint(word start, word end, WatchType type = WatchType::WRITE, int value = -1);
+
+    // Remove a breakpoint or watchpoint
+    bool remove(int id);
+
+    // Remove everything and unhook all pages
+    void clear();
+
+    // Called on every hit, after the CPU was stopped
+    void set_hit_handler(std::function<void(const DebugHit&)> handler) { on_hit = std::move(handler); }
+
+    // Continue from a stop, stepping over a breakpoint at the current PC
+    void resume();
+
+    // Run until `condition` holds, the CPU stops on a breakpoint or
+    // watchpoint or halts, or `max_cycles` have gone by. Returns true when
+    // the condition was met.
+    //
+    // Conditions that only read constant addresses are evaluated after
+    // writes to those addresses, anything else after every instruction.
+    bool run_until(Condition& condition, uint64_t max_cycles = UINT64_MAX);
+
+    // Whether execution must stop before the instruction at `pc`
+    // (called by the CPU before every opcode fetch)
+    bool break_at(word pc) { return break_pages[pc >> 8] && check_breakpoint(pc); }
+
+    // Called by the page hooks
+    void check_access(word addr, byte value, bool write);
+};
+
+#endif  // DEBUGGER_H
@@ -6,52 +6,168 @@
 #include <sstream>
 #include <vector>
 
+#include "io_device.h"
 #include "log.h"
 #include "memory.h"
+#include "metrics.h"
 #include "types.h"
 
+class StateHash;
+
 struct Mapping {
     word start;
     word end;
     MEM_Module* module;
+    bool device = false;  // Added with `add_device`, accesses have side effects
+};
+
+// One 256 byte page of the address space
+struct Page {
+    MEM_Module* module = nullptr;  // Module owning the whole page, nullptr when unmapped or split
+    word start = 0;                // Start of that module's range
+    bool split = false;            // Several mappings share the page, resolved through the mapping list
 };
 
 class AddressDecoder {
    private:
-    std::vector<Mapping> map;
+    std::vector<Mapping> map;         // In priority order
+    Page mapped[256];                 // Page table built from the mappings
+    Page pages[256];                  // Page table used for accesses (mapped pages, or hooks over them)
+    MEM_Module* hooks[256] = {};      // Modules hooked over whole pages (see `hook_page`)
+    StateHash* state_hash = nullptr;  // Updated on every write (see `attach_state_hash`)
 
-   public:
-    void add_mapping(word start, word end, MEM_Module* module) { map.push_back({start, end, module}); }
+    // Recompute the page table entries covering start-end
+    void rebuild_pages(word start, word end);
 
-    byte read(word addr) {
-        for (auto& m : map) {
-            if (addr >= m.start && addr <= m.end) {
+    // Set a page's entry in `mapped`, and in `pages` unless it is hooked
+    void set_page(int index, const Page& page);
+
+    // Slow path for pages shared by several mappings
+    const Mapping* find(word addr) const;
+
+    // Write past any hook and update the state hash with the byte that was
+    // actually stored
+    void write_hashed(word addr, word val);
+
+    byte read_page(const Page& page, word addr) {
+        if (page.module) return page.module->read_word(addr - page.start);
+        if (page.split) {
+            if (const Mapping* m = find(addr)) {
                 // Calculate local address within the module
-                word local_addr = addr - m.start;
-                return m.module->read_word(local_addr);
+                word local_addr = addr - m->start;
+                return m->module->read_word(local_addr);
             }
         }
-        // Use proper logging instead of cerr
-        std::stringstream ss;
-        ss << "Invalid memory read at address 0x" << std::hex << std::setw(4) << std::setfill('0') << addr;
-        logger::error(ss.str());
+        if (metrics::enabled.load(std::memory_order_relaxed)) metrics::add(metrics::UNMAPPED_READS);
+
+        // Use proper logging instead of cerr (skipping the formatting when
+        // nothing is logged, fuzzing hits this constantly)
+        if (logger::enabled) {
+            std::stringstream ss;
+            ss << "Invalid memory read at address 0x" << std::hex << std::setw(4) << std::setfill('0') << addr;
+            logger::error(ss.str());
+        }
         return 0xFF;  // Return a default value for unmapped memory
     }
 
-    void write(word addr, word val) {
-        for (auto& m : map) {
-            if (addr >= m.start && addr <= m.end) {
+    void write_page(const Page& page, word addr, word val) {
+        if (page.module) {
+            page.module->write_word(addr - page.start, val);
+            return;
+        }
+        if (page.split) {
+            if (const Mapping* m = find(addr)) {
                 // Calculate local address within the module
-                word local_addr = addr - m.start;
-                m.module->write_word(local_addr, val);
+                word local_addr = addr - m->start;
+                m->module->write_word(local_addr, val);
                 return;
             }
         }
-        // Use proper logging instead of cerr
-        std::stringstream ss;
-        ss << "Invalid memory write at address 0x" << std::hex << std::setw(4) << std::setfill('0') << addr
-           << " with value 0x" << std::setw(2) << std::setfill('0') << (int)val;
-        logger::error(ss.str());
+        if (metrics::enabled.load(std::memory_order_relaxed)) metrics::add(metrics::UNMAPPED_WRITES);
+        if (logger::enabled) {
+            std::stringstream ss;
+            ss << "Invalid memory write at address 0x" << std::hex << std::setw(4) << std::setfill('0') << addr
+               << " with value 0x" << std::setw(2) << std::setfill('0') << (int)val;
+            logger::error(ss.str());
+        }
+    }
+
+   public:
+    void add_mapping(word start, word end, MEM_Module* module);
+
+    // Map an I/O device over a range, it takes priority over any memory
+    // already mapped there (e.g. a VIA at 0x6000 inside the SRAM range)
+    void add_device(word start, word end, IO_Device* device);
+
+    // Replace whatever is mapped at start-end with `module`. Only the
+    // affected page table entries are touched, but the mapping list is
+    // still searched and a range that doesn't start or end on a page
+    // boundary rebuilds its end pages from it.
+    //
+    // Note: this is for reconfiguring the memory map. Bank switching maps a
+    // `BankWindow` (banked_memory.h) once and calls its `select`, which
+    // doesn't touch the decoder at all.
+    void remap(word start, word end, MEM_Module* module);
+
+    byte read(word addr) { return read_page(pages[addr >> 8], addr); }
+
+    void write(word addr, word val) {
+        // A hooked page is hashed when the hook passes the write on
+        // through `write_unhooked`
+        if (state_hash && hooks[addr >> 8] == nullptr) {
+            write_hashed(addr, val);
+            return;
+        }
+        write_page(pages[addr >> 8], addr, val);
+    }
+
+    // Route every access to a page through `hook` (called with the offset
+    // within the page) instead of the mapped module. Pages without a hook
+    // keep the direct lookup, so hooks cost nothing where they aren't used.
+    // A hook reaches the mapped module through `read_unhooked` /
+    // `write_unhooked`, which keep the state hash up to date.
+    void hook_page(byte index, MEM_Module* hook);
+    void unhook_page(byte index);
+
+    // Earliest `next_event()` of all mapped modules
+    uint64_t next_event();
+
+    // Bytes at `addr` and after that can be copied in bulk, straight from
+    // or to the module mapped there (see `MEM_Module::read_span`).
+    // `length` receives how many, up to the end of the mapping. nullptr
+    // when the access has to go through `read` / `write` (devices, hooked
+    // or shared pages, the state hash for writes)
+    const byte* read_span(word addr, size_t& length);
+    byte* write_span(word addr, size_t& length);
+
+    // Keep `hash` in step with every write, nullptr detaches
+    void attach_state_hash(StateHash* hash) { state_hash = hash; }
+    bool has_state_hash() const { return state_hash != nullptr; }
+
+    // Module an access to `addr` resolves to, hooks aside (nullptr when
+    // nothing is mapped there)
+    MEM_Module* module_at(word addr) const {
+        const Page& page = mapped[addr >> 8];
+        if (!page.split) return page.module;
+        const Mapping* m = find(addr);
+        return m ? m->module : nullptr;
+    }
+
+    // Whether `addr` reaches an I/O device, whose reads have side effects
+    bool is_device(word addr) const {
+        const Mapping* m = find(addr);
+        return m && m->device;
+    }
+
+    // Accesses that bypass any hook, for the hooks themselves and for
+    // debuggers. Writes still update the state hash.
+    byte read_unhooked(word addr) { return read_page(mapped[addr >> 8], addr); }
+    void write_unhooked(word addr, word val) {
+        if (state_hash) {
+            write_hashed(addr, val);
+            return;
+        }
+        write_page(mapped[addr >> 8], addr, val);
     }
 };
 
@@ -0,0 +1,26 @@
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include <cstddef>
+
+#include "decoder.h"
+#include "instructions.h"
+#include "types.h"
+
+// Size of the buffers the disassembler writes into. The longest line is
+// "BBR0 $12,$1234" plus the terminator.
+constexpr size_t DISASM_BUFFER = 24;
+
+// Disassemble the instruction in `bytes` located at `pc` into `out`
+// (DISASM_BUFFER bytes). `bytes` must hold the whole instruction.
+// Returns the instruction length.
+//
+// Formatting is done by hand into the caller's buffer so large ranges
+// can be listed interactively.
+int disassemble(const byte* bytes, word pc, char* out);
+
+// Same, reading the instruction through the decoder without triggering
+// watchpoints
+int disassemble(AddressDecoder& decoder, word pc, char* out);
+
+#endif  // DISASSEMBLER_H
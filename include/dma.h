@@ -0,0 +1,81 @@
+#ifndef DMA_H
+#define DMA_H
+
+#include <cstdint>
+
+#include "bus.h"
+#include "decoder.h"
+#include "io_device.h"
+#include "types.h"
+
+// Single channel DMA controller for block copies
+//
+// Firmware programs the source, destination and length and sets START.
+// The controller then asks for the bus (see `Bus::add_master`) and, while
+// it holds it, moves bytes with the CPU stalled on RDY. Every byte costs a
+// read and a write cycle, as on the real bus, but runs of plain memory are
+// copied with memmove on the host instead of one decoder access per byte.
+// Devices, hooked pages and the EEPROM during a write cycle still see each
+// access. Overlapping blocks copy upwards byte by byte, as the hardware
+// would, so a destination one byte past the source fills the block.
+class DMAController : public IO_Device, public BusMaster {
+   public:
+    // Register offsets
+    enum Reg : byte {
+        SRC_LO = 0x0,   // Source address, advances as bytes are copied
+        SRC_HI = 0x1,   //
+        DST_LO = 0x2,   // Destination address, advances as well
+        DST_HI = 0x3,   //
+        LEN_LO = 0x4,   // Bytes left, 0 copies 64KB
+        LEN_HI = 0x5,   //
+        CONTROL = 0x6,  // Control register
+        STATUS = 0x7    // Status (read only, reading clears DONE)
+    };
+
+    // Control register bits
+    enum Control : byte {
+        CONTROL_START = 0x01,  // Start the transfer (reads back while busy)
+        CONTROL_IRQ = 0x02     // Assert IRQ when the transfer is done
+    };
+
+    // Status register bits
+    enum Status : byte {
+        STATUS_DONE = 0x01,  // A transfer finished since the last status read
+        STATUS_BUSY = 0x80   // Transfer in progress
+    };
+
+    static constexpr uint32_t CYCLES_PER_BYTE = 2;  // Read then write
+
+   private:
+    AddressDecoder& decoder;
+
+    word source = 0;
+    word destination = 0;
+    word length = 0;  // Register value, 0 means 64KB
+    byte control = 0x00;
+
+    uint32_t remaining = 0;    // Bytes left of the running transfer
+    bool done = false;         // STATUS_DONE
+    uint64_t transferred = 0;  // Bytes copied since power on
+
+    // Copy `count` bytes and advance the addresses
+    void copy(uint32_t count);
+
+   public:
+    DMAController(AddressDecoder& decoder) : decoder(decoder) {}
+
+    // Bytes copied so far, for statistics
+    uint64_t bytes_transferred() const { return transferred; }
+
+    // IO_Device interface
+    byte io_read(word reg) override;
+    void io_write(word reg, byte data) override;
+    bool irq_asserted() override { return done && (control & CONTROL_IRQ); }
+    uint64_t next_event() override;
+
+    // BusMaster interface
+    bool bus_requested() override { return remaining != 0; }
+    uint32_t run_bus_cycles(uint32_t max_cycles) override;
+};
+
+#endif  // DMA_H
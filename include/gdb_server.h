@@ -0,0 +1,101 @@
+#ifndef GDB_SERVER_H
+#define GDB_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#include "debugger.h"
+#include "decoder.h"
+#include "wdc65c02.h"
+
+// GDB remote serial protocol stub for the 65C02
+//
+// Exposes the registers (a, x, y, p, sp as 8 bits and pc as 16 bits,
+// described to the client through `target.xml`), memory through the
+// address decoder (I/O device registers aren't read, their reads have
+// side effects), breakpoints (Z0/Z1), watchpoints (Z2-Z4) through the
+// `Debugger`, single step and continue. `monitor disas` lists code with
+// the shared disassembler.
+//
+// A reader thread owns the socket: it queues complete packets and turns
+// the asynchronous ^C into an interrupt flag. While continuing, the CPU
+// runs at full speed in batches of instructions and only looks at that
+// flag between batches, so it never touches the socket. It stops on
+// breakpoint and watchpoint hits, when it halts, or on the flag.
+class GdbServer {
+   private:
+    WDC65C02& cpu;
+    AddressDecoder& decoder;
+    Debugger& debugger;
+
+    int listen_fd = -1;               // Listening socket
+    int client_fd = -1;               // Connected debugger
+    std::string socket_path;          // Path to unlink on close (UNIX socket only)
+    std::atomic<bool> no_ack{false};  // Client switched to QStartNoAckMode
+
+    // Packets received by the reader thread
+    std::thread reader_thread;
+    std::mutex packet_mutex;
+    std::condition_variable packet_ready;
+    std::deque<std::string> packets;
+    bool disconnected = false;
+
+    std::mutex send_mutex;                         // Acks and replies come from different threads
+    std::atomic<bool> interrupt_requested{false};  // ^C from the client
+
+    // Z packet (type, address, kind) -> debugger breakpoint / watchpoint id
+    std::map<std::tuple<char, word, int>, int> points;
+    std::map<int, char> watch_types;  // Watchpoint id -> Z type, for stop replies
+
+    void reader_loop();
+
+    // Wait for the next packet, false once the client is gone
+    bool next_packet(std::string& packet);
+
+    void send_raw(const std::string& data);
+    void send_packet(const std::string& payload);
+
+    // Reply to one packet, `done` is set when the session ends
+    std::string handle(const std::string& packet, bool& done);
+
+    // Continue or single step, returns the stop reply
+    std::string run(bool single_step);
+
+    std::string read_registers();
+    bool write_register(int reg, uint32_t value);
+    std::string insert_point(const std::string& args, bool insert);
+
+    // `monitor` commands (qRcmd), returns the hex encoded output
+    std::string monitor_command(const std::string& hex_command);
+
+    void close_client();
+
+   public:
+    GdbServer(WDC65C02& cpu, AddressDecoder& decoder, Debugger& debugger);
+    ~GdbServer();
+
+    GdbServer(const GdbServer&) = delete;
+    GdbServer& operator=(const GdbServer&) = delete;
+
+    // Listen on 127.0.0.1:`port`
+    bool listen_tcp(uint16_t port);
+
+    // Listen on a UNIX socket
+    bool listen_unix(const std::string& path);
+
+    // Accept one client and serve it until it detaches, kills the session
+    // or disconnects. The CPU is left stopped on return.
+    void serve();
+
+    // Stop a running CPU as if the client had sent ^C
+    void interrupt() { interrupt_requested.store(true, std::memory_order_relaxed); }
+};
+
+#endif  // GDB_SERVER_H
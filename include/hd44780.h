@@ -0,0 +1,172 @@
+#ifndef HD44780_H
+#define HD44780_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#include "io_device.h"
+#include "types.h"
+#include "w65c22.h"
+
+// HD44780 character LCD controller
+//
+// Models the instruction and data registers, the busy flag (timed on
+// the cycle counter), DDRAM / CGRAM, the address counter, display and
+// cursor shifting, and both the 8-bit and 4-bit interfaces.
+//
+// The controller can be memory mapped directly (register 0 is the
+// instruction register, register 1 the data register) or hang off the
+// ports of a VIA through `HD44780_ViaAdapter`.
+//
+// The host display is only redrawn when something visible changed,
+// and no more often than the configured frame interval, so firmware
+// that rewrites the LCD in a tight loop doesn't end up waiting on the
+// terminal.
+class HD44780 : public IO_Device {
+   private:
+    // Visible geometry of the module (16x2, 20x4, ...)
+    byte columns;
+    byte rows;
+    double clock_hz;  // CPU clock the cycle counter runs at
+
+    // Controller state (guarded by `state_mutex` for the renderer)
+    byte ddram[80];              // Display data RAM
+    byte cgram[64];              // Character generator RAM (8 custom characters)
+    byte ac = 0;                 // Address counter
+    bool ac_cgram = false;       // Whether the address counter points into CGRAM
+    bool increment = true;       // I/D: address counter moves up after an access
+    bool shift_display = false;  // S: the display shifts along with the cursor
+    bool display_on = false;     // D
+    bool cursor_on = false;      // C
+    bool blink_on = false;       // B
+    bool eight_bit = true;       // DL: 8-bit interface
+    bool two_lines = false;      // N
+    int display_shift = 0;       // Positions the display is shifted left
+    uint64_t busy_until = 0;     // Busy flag stays set up to this cycle
+
+    // 4-bit interface: a byte is split into two transfers, high nibble first
+    bool nibble_pending = false;   // The high nibble of a write has been latched
+    byte nibble_high = 0;          // That high nibble
+    bool read_low_nibble = false;  // The next read returns the low nibble of `read_value`
+    byte read_value = 0;           // Byte being read out in two halves
+
+    // Rendering
+    mutable std::mutex state_mutex;
+    std::atomic<bool> dirty{true};  // Something visible changed since the last frame
+    std::chrono::steady_clock::time_point last_frame{};
+    std::chrono::milliseconds frame_interval{50};
+    bool drawn = false;  // A frame is on screen and can be overwritten in place
+    std::thread render_thread;
+    std::atomic<bool> rendering{false};
+
+    // What a frame shows apart from the DDRAM contents
+    struct View {
+        bool display_on;
+        bool two_lines;
+        int cursor;  // DDRAM index under the cursor, -1 when it isn't shown
+        int display_shift;
+
+        bool operator!=(const View& other) const {
+            return display_on != other.display_on || two_lines != other.two_lines || cursor != other.cursor ||
+                   display_shift != other.display_shift;
+        }
+    };
+    View view() const;
+
+    // Execute a full 8-bit transfer
+    void execute(bool rs, byte data);
+    byte fetch(bool rs);
+
+    // Run an instruction register write, true if it changed DDRAM
+    bool instruction(byte data);
+
+    // Move the address counter after a data access
+    void step_address();
+
+    // Mark the controller busy for `us` microseconds
+    void set_busy(double us);
+
+    // Index into `ddram` for the address counter / a visible position
+    int ddram_index(byte address) const;
+    int visible_index(byte row, byte col) const;
+
+   public:
+    HD44780(byte columns = 16, byte rows = 2, double cpu_clock_hz = 1000000.0);
+    ~HD44780();
+
+    HD44780(const HD44780&) = delete;
+    HD44780& operator=(const HD44780&) = delete;
+
+    // One transfer on the data pins, latched by the falling edge of E
+    //
+    // Note: in 4-bit mode only D7-D4 are used and two transfers make
+    // up one byte (high nibble first)
+    void write_bus(bool rs, byte data);
+
+    // One read transfer (busy flag + address counter when `rs` is low)
+    byte read_bus(bool rs);
+
+    // Whether the busy flag is set
+    bool busy();
+
+    // Power-on state (8-bit interface, display off, DDRAM cleared)
+    void reset();
+
+    // Character shown at `row` / `col` (the DDRAM code)
+    byte char_at(byte row, byte col) const;
+
+    // Limit redraws to one every `interval`
+    void set_frame_interval(std::chrono::milliseconds interval) { frame_interval = interval; }
+
+    // Redraw the display on `out` if it changed and the frame interval
+    // has passed, returns whether a frame was drawn
+    bool present(std::ostream& out, bool force = false);
+
+    // Call `present` on std::cout from a background thread
+    void start_rendering();
+    void stop_rendering();
+
+    // IO_Device interface (register 0: instruction, register 1: data)
+    byte io_read(word reg) override { return read_bus(reg & 0x01); }
+    void io_write(word reg, byte data) override { write_bus(reg & 0x01, data); }
+
+    // The busy flag clearing
+    uint64_t next_event() override { return busy() ? busy_until : UINT64_MAX; }
+};
+
+// Connects an HD44780 to the ports of a W65C22 VIA, defaulting to the
+// usual breadboard wiring: data on port B, E / RW / RS on PA7 / PA6 / PA5.
+// In 4-bit mode D7-D4 of the LCD sit on the port bits given by `nibble_shift`.
+class HD44780_ViaAdapter : public ViaPortListener {
+   private:
+    HD44780& lcd;
+    ViaPort data_port;
+    ViaPort control_port;
+    byte e_mask, rw_mask, rs_mask;
+    int nibble_shift;  // -1 for an 8-bit data bus
+
+    byte control = 0;     // Last levels on the control port
+    byte data = 0;        // Last levels on the data port
+    byte read_latch = 0;  // What the LCD drives on D7-D0 during a read
+
+   public:
+    HD44780_ViaAdapter(HD44780& lcd, ViaPort data_port = ViaPort::B, ViaPort control_port = ViaPort::A,
+                       byte e_mask = 0x80, byte rw_mask = 0x40, byte rs_mask = 0x20, int nibble_shift = -1)
+        : lcd(lcd),
+          data_port(data_port),
+          control_port(control_port),
+          e_mask(e_mask),
+          rw_mask(rw_mask),
+          rs_mask(rs_mask),
+          nibble_shift(nibble_shift) {}
+
+    // ViaPortListener interface
+    void port_written(ViaPort port, byte value, byte ddr) override;
+    byte port_read(ViaPort port) override;
+};
+
+#endif  // HD44780 LCD interface
@@ -6,19 +6,29 @@
 #include "types.h"
 
 class HM62256B : public MEM_Module {
-   public:                   // Make memory public for debugging purposes
-    byte memory[32 * 1024];  // 32KB of SRAM
+   public:         // Make memory public for debugging purposes
+    byte* memory;  // 32KB of SRAM, points at `storage` or at external storage
    private:
     Bus& bus;
 
+    byte storage[32 * 1024];  // Internal array used unless `use_storage` moved the contents
+
    public:
-    HM62256B(Bus& bus) : bus(bus) {
+    HM62256B(Bus& bus) : memory(storage), bus(bus) {
         // Initialize memory to 0x00 (cleared state)
         for (int i = 0; i < 32768; ++i) {
             memory[i] = 0x00;
         }
     }
 
+    HM62256B(const HM62256B&) = delete;
+    HM62256B& operator=(const HM62256B&) = delete;
+
+    // Keep the contents in `external` (32KB, e.g. a shared memory segment)
+    // from now on, nullptr goes back to the internal array. The current
+    // contents are copied over.
+    void use_storage(byte* external);
+
     // Pin layout for HM62256B SRAM
     union {
         pinl_t PINS;  // Raw access to all pins at once
@@ -79,6 +89,8 @@ class HM62256B : public MEM_Module {
     byte read_byte(byte addr) override;
     void write_word(word addr, word data) override;
     void write_byte(byte addr, byte data) override;
+    const byte* read_span(word offset, size_t& length) override;
+    byte* write_span(word offset, size_t& length) override;
 };
 
 #endif  // HM62256B SRAM interface
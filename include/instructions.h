@@ -0,0 +1,410 @@
+#ifndef INSTRUCTIONS_H
+#define INSTRUCTIONS_H
+
+#include "op_codes.h"
+#include "types.h"
+
+// Instruction metadata for all 256 65C02 opcodes
+//
+// This table is the one place mnemonics, addressing modes, lengths and
+// cycle counts are recorded. The CPU fetches operands according to it,
+// and the disassembler, coverage listings, traces and the GDB stub
+// format instructions from it.
+
+// Addressing modes
+enum class AddrMode : byte {
+    IMP,   // Implied               CLC
+    ACC,   // Accumulator           ASL A
+    IMM,   // Immediate             LDA #$12
+    ZP,    // Zero page             LDA $12
+    ZPX,   // Zero page,X           LDA $12,X
+    ZPY,   // Zero page,Y           LDX $12,Y
+    ZPI,   // Zero page indirect    LDA ($12)
+    INX,   // (Zero page,X)         LDA ($12,X)
+    INY,   // (Zero page),Y         LDA ($12),Y
+    ABS,   // Absolute              LDA $1234
+    ABSX,  // Absolute,X            LDA $1234,X
+    ABSY,  // Absolute,Y            LDA $1234,Y
+    IND,   // Absolute indirect     JMP ($1234)
+    AIX,   // (Absolute,X)          JMP ($1234,X)
+    REL,   // Relative              BNE $1234
+    ZPR    // Zero page, relative   BBR0 $12,$1234
+};
+
+// Instruction length in bytes (including the opcode) for a mode
+constexpr byte mode_length(AddrMode mode) {
+    switch (mode) {
+        case AddrMode::IMP:
+        case AddrMode::ACC:
+            return 1;
+        case AddrMode::ABS:
+        case AddrMode::ABSX:
+        case AddrMode::ABSY:
+        case AddrMode::IND:
+        case AddrMode::AIX:
+        case AddrMode::ZPR:
+            return 3;
+        default:
+            return 2;
+    }
+}
+
+struct InstructionInfo {
+    const char* mnemonic;
+    AddrMode mode;
+    byte length;  // Bytes including the opcode
+    byte cycles;  // Base cycles (page crossings, taken branches and decimal mode can add more)
+};
+
+constexpr InstructionInfo instruction(const char* mnemonic, AddrMode mode, byte cycles) {
+    return {mnemonic, mode, mode_length(mode), cycles};
+}
+
+// Indexed by opcode. Opcodes the 65C02 doesn't define are the NOPs they
+// behave as.
+inline constexpr InstructionInfo INSTRUCTIONS[256] = {
+    instruction("BRK", AddrMode::IMP, 7),  // 0x00
+    instruction("ORA", AddrMode::INX, 6),  // 0x01
+    instruction("NOP", AddrMode::IMM, 2),  // 0x02
+    instruction("NOP", AddrMode::IMP, 1),  // 0x03
+    instruction("TSB", AddrMode::ZP, 5),  // 0x04
+    instruction("ORA", AddrMode::ZP, 3),  // 0x05
+    instruction("ASL", AddrMode::ZP, 5),  // 0x06
+    instruction("RMB0", AddrMode::ZP, 5),  // 0x07
+    instruction("PHP", AddrMode::IMP, 3),  // 0x08
+    instruction("ORA", AddrMode::IMM, 2),  // 0x09
+    instruction("ASL", AddrMode::ACC, 2),  // 0x0A
+    instruction("NOP", AddrMode::IMP, 1),  // 0x0B
+    instruction("TSB", AddrMode::ABS, 6),  // 0x0C
+    instruction("ORA", AddrMode::ABS, 4),  // 0x0D
+    instruction("ASL", AddrMode::ABS, 6),  // 0x0E
+    instruction("BBR0", AddrMode::ZPR, 5),  // 0x0F
+    instruction("BPL", AddrMode::REL, 2),  // 0x10
+    instruction("ORA", AddrMode::INY, 5),  // 0x11
+    instruction("ORA", AddrMode::ZPI, 5),  // 0x12
+    instruction("NOP", AddrMode::IMP, 1),  // 0x13
+    instruction("TRB", AddrMode::ZP, 5),  // 0x14
+    instruction("ORA", AddrMode::ZPX, 4),  // 0x15
+    instruction("ASL", AddrMode::ZPX, 6),  // 0x16
+    instruction("RMB1", AddrMode::ZP, 5),  // 0x17
+    instruction("CLC", AddrMode::IMP, 2),  // 0x18
+    instruction("ORA", AddrMode::ABSY, 4),  // 0x19
+    instruction("INC", AddrMode::ACC, 2),  // 0x1A
+    instruction("NOP", AddrMode::IMP, 1),  // 0x1B
+    instruction("TRB", AddrMode::ABS, 6),  // 0x1C
+    instruction("ORA", AddrMode::ABSX, 4),  // 0x1D
+    instruction("ASL", AddrMode::ABSX, 6),  // 0x1E
+    instruction("BBR1", AddrMode::ZPR, 5),  // 0x1F
+    instruction("JSR", AddrMode::ABS, 6),  // 0x20
+    instruction("AND", AddrMode::INX, 6),  // 0x21
+    instruction("NOP", AddrMode::IMM, 2),  // 0x22
+    instruction("NOP", AddrMode::IMP, 1),  // 0x23
+    instruction("BIT", AddrMode::ZP, 3),  // 0x24
+    instruction("AND", AddrMode::ZP, 3),  // 0x25
+    instruction("ROL", AddrMode::ZP, 5),  // 0x26
+    instruction("RMB2", AddrMode::ZP, 5),  // 0x27
+    instruction("PLP", AddrMode::IMP, 4),  // 0x28
+    instruction("AND", AddrMode::IMM, 2),  // 0x29
+    instruction("ROL", AddrMode::ACC, 2),  // 0x2A
+    instruction("NOP", AddrMode::IMP, 1),  // 0x2B
+    instruction("BIT", AddrMode::ABS, 4),  // 0x2C
+    instruction("AND", AddrMode::ABS, 4),  // 0x2D
+    instruction("ROL", AddrMode::ABS, 6),  // 0x2E
+    instruction("BBR2", AddrMode::ZPR, 5),  // 0x2F
+    instruction("BMI", AddrMode::REL, 2),  // 0x30
+    instruction("AND", AddrMode::INY, 5),  // 0x31
+    instruction("AND", AddrMode::ZPI, 5),  // 0x32
+    instruction("NOP", AddrMode::IMP, 1),  // 0x33
+    instruction("BIT", AddrMode::ZPX, 4),  // 0x34
+    instruction("AND", AddrMode::ZPX, 4),  // 0x35
+    instruction("ROL", AddrMode::ZPX, 6),  // 0x36
+    instruction("RMB3", AddrMode::ZP, 5),  // 0x37
+    instruction("SEC", AddrMode::IMP, 2),  // 0x38
+    instruction("AND", AddrMode::ABSY, 4),  // 0x39
+    instruction("DEC", AddrMode::ACC, 2),  // 0x3A
+    instruction("NOP", AddrMode::IMP, 1),  // 0x3B
+    instruction("BIT", AddrMode::ABSX, 4),  // 0x3C
+    instruction("AND", AddrMode::ABSX, 4),  // 0x3D
+    instruction("ROL", AddrMode::ABSX, 6),  // 0x3E
+    instruction("BBR3", AddrMode::ZPR, 5),  // 0x3F
+    instruction("RTI", AddrMode::IMP, 6),  // 0x40
+    instruction("EOR", AddrMode::INX, 6),  // 0x41
+    instruction("NOP", AddrMode::IMM, 2),  // 0x42
+    instruction("NOP", AddrMode::IMP, 1),  // 0x43
+    instruction("NOP", AddrMode::ZP, 3),  // 0x44
+    instruction("EOR", AddrMode::ZP, 3),  // 0x45
+    instruction("LSR", AddrMode::ZP, 5),  // 0x46
+    instruction("RMB4", AddrMode::ZP, 5),  // 0x47
+    instruction("PHA", AddrMode::IMP, 3),  // 0x48
+    instruction("EOR", AddrMode::IMM, 2),  // 0x49
+    instruction("LSR", AddrMode::ACC, 2),  // 0x4A
+    instruction("NOP", AddrMode::IMP, 1),  // 0x4B
+    instruction("JMP", AddrMode::ABS, 3),  // 0x4C
+    instruction("EOR", AddrMode::ABS, 4),  // 0x4D
+    instruction("LSR", AddrMode::ABS, 6),  // 0x4E
+    instruction("BBR4", AddrMode::ZPR, 5),  // 0x4F
+    instruction("BVC", AddrMode::REL, 2),  // 0x50
+    instruction("EOR", AddrMode::INY, 5),  // 0x51
+    instruction("EOR", AddrMode::ZPI, 5),  // 0x52
+    instruction("NOP", AddrMode::IMP, 1),  // 0x53
+    instruction("NOP", AddrMode::ZPX, 4),  // 0x54
+    instruction("EOR", AddrMode::ZPX, 4),  // 0x55
+    instruction("LSR", AddrMode::ZPX, 6),  // 0x56
+    instruction("RMB5", AddrMode::ZP, 5),  // 0x57
+    instruction("CLI", AddrMode::IMP, 2),  // 0x58
+    instruction("EOR", AddrMode::ABSY, 4),  // 0x59
+    instruction("PHY", AddrMode::IMP, 3),  // 0x5A
+    instruction("NOP", AddrMode::IMP, 1),  // 0x5B
+    instruction("NOP", AddrMode::ABS, 8),  // 0x5C
+    instruction("EOR", AddrMode::ABSX, 4),  // 0x5D
+    instruction("LSR", AddrMode::ABSX, 6),  // 0x5E
+    instruction("BBR5", AddrMode::ZPR, 5),  // 0x5F
+    instruction("RTS", AddrMode::IMP, 6),  // 0x60
+    instruction("ADC", AddrMode::INX, 6),  // 0x61
+    instruction("NOP", AddrMode::IMM, 2),  // 0x62
+    instruction("NOP", AddrMode::IMP, 1),  // 0x63
+    instruction("STZ", AddrMode::ZP, 3),  // 0x64
+    instruction("ADC", AddrMode::ZP, 3),  // 0x65
+    instruction("ROR", AddrMode::ZP, 5),  // 0x66
+    instruction("RMB6", AddrMode::ZP, 5),  // 0x67
+    instruction("PLA", AddrMode::IMP, 4),  // 0x68
+    instruction("ADC", AddrMode::IMM, 2),  // 0x69
+    instruction("ROR", AddrMode::ACC, 2),  // 0x6A
+    instruction("NOP", AddrMode::IMP, 1),  // 0x6B
+    instruction("JMP", AddrMode::IND, 6),  // 0x6C
+    instruction("ADC", AddrMode::ABS, 4),  // 0x6D
+    instruction("ROR", AddrMode::ABS, 6),  // 0x6E
+    instruction("BBR6", AddrMode::ZPR, 5),  // 0x6F
+    instruction("BVS", AddrMode::REL, 2),  // 0x70
+    instruction("ADC", AddrMode::INY, 5),  // 0x71
+    instruction("ADC", AddrMode::ZPI, 5),  // 0x72
+    instruction("NOP", AddrMode::IMP, 1),  // 0x73
+    instruction("STZ", AddrMode::ZPX, 4),  // 0x74
+    instruction("ADC", AddrMode::ZPX, 4),  // 0x75
+    instruction("ROR", AddrMode::ZPX, 6),  // 0x76
+    instruction("RMB7", AddrMode::ZP, 5),  // 0x77
+    instruction("SEI", AddrMode::IMP, 2),  // 0x78
+    instruction("ADC", AddrMode::ABSY, 4),  // 0x79
+    instruction("PLY", AddrMode::IMP, 4),  // 0x7A
+    instruction("NOP", AddrMode::IMP, 1),  // 0x7B
+    instruction("JMP", AddrMode::AIX, 6),  // 0x7C
+    instruction("ADC", AddrMode::ABSX, 4),  // 0x7D
+    instruction("ROR", AddrMode::ABSX, 6),  // 0x7E
+    instruction("BBR7", AddrMode::ZPR, 5),  // 0x7F
+    instruction("BRA", AddrMode::REL, 3),  // 0x80
+    instruction("STA", AddrMode::INX, 6),  // 0x81
+    instruction("NOP", AddrMode::IMM, 2),  // 0x82
+    instruction("NOP", AddrMode::IMP, 1),  // 0x83
+    instruction("STY", AddrMode::ZP, 3),  // 0x84
+    instruction("STA", AddrMode::ZP, 3),  // 0x85
+    instruction("STX", AddrMode::ZP, 3),  // 0x86
+    instruction("SMB0", AddrMode::ZP, 5),  // 0x87
+    instruction("DEY", AddrMode::IMP, 2),  // 0x88
+    instruction("BIT", AddrMode::IMM, 2),  // 0x89
+    instruction("TXA", AddrMode::IMP, 2),  // 0x8A
+    instruction("NOP", AddrMode::IMP, 1),  // 0x8B
+    instruction("STY", AddrMode::ABS, 4),  // 0x8C
+    instruction("STA", AddrMode::ABS, 4),  // 0x8D
+    instruction("STX", AddrMode::ABS, 4),  // 0x8E
+    instruction("BBS0", AddrMode::ZPR, 5),  // 0x8F
+    instruction("BCC", AddrMode::REL, 2),  // 0x90
+    instruction("STA", AddrMode::INY, 6),  // 0x91
+    instruction("STA", AddrMode::ZPI, 5),  // 0x92
+    instruction("NOP", AddrMode::IMP, 1),  // 0x93
+    instruction("STY", AddrMode::ZPX, 4),  // 0x94
+    instruction("STA", AddrMode::ZPX, 4),  // 0x95
+    instruction("STX", AddrMode::ZPY, 4),  // 0x96
+    instruction("SMB1", AddrMode::ZP, 5),  // 0x97
+    instruction("TYA", AddrMode::IMP, 2),  // 0x98
+    instruction("STA", AddrMode::ABSY, 5),  // 0x99
+    instruction("TXS", AddrMode::IMP, 2),  // 0x9A
+    instruction("NOP", AddrMode::IMP, 1),  // 0x9B
+    instruction("STZ", AddrMode::ABS, 4),  // 0x9C
+    instruction("STA", AddrMode::ABSX, 5),  // 0x9D
+    instruction("STZ", AddrMode::ABSX, 5),  // 0x9E
+    instruction("BBS1", AddrMode::ZPR, 5),  // 0x9F
+    instruction("LDY", AddrMode::IMM, 2),  // 0xA0
+    instruction("LDA", AddrMode::INX, 6),  // 0xA1
+    instruction("LDX", AddrMode::IMM, 2),  // 0xA2
+    instruction("NOP", AddrMode::IMP, 1),  // 0xA3
+    instruction("LDY", AddrMode::ZP, 3),  // 0xA4
+    instruction("LDA", AddrMode::ZP, 3),  // 0xA5
+    instruction("LDX", AddrMode::ZP, 3),  // 0xA6
+    instruction("SMB2", AddrMode::ZP, 5),  // 0xA7
+    instruction("TAY", AddrMode::IMP, 2),  // 0xA8
+    instruction("LDA", AddrMode::IMM, 2),  // 0xA9
+    instruction("TAX", AddrMode::IMP, 2),  // 0xAA
+    instruction("NOP", AddrMode::IMP, 1),  // 0xAB
+    instruction("LDY", AddrMode::ABS, 4),  // 0xAC
+    instruction("LDA", AddrMode::ABS, 4),  // 0xAD
+    instruction("LDX", AddrMode::ABS, 4),  // 0xAE
+    instruction("BBS2", AddrMode::ZPR, 5),  // 0xAF
+    instruction("BCS", AddrMode::REL, 2),  // 0xB0
+    instruction("LDA", AddrMode::INY, 5),  // 0xB1
+    instruction("LDA", AddrMode::ZPI, 5),  // 0xB2
+    instruction("NOP", AddrMode::IMP, 1),  // 0xB3
+    instruction("LDY", AddrMode::ZPX, 4),  // 0xB4
+    instruction("LDA", AddrMode::ZPX, 4),  // 0xB5
+    instruction("LDX", AddrMode::ZPY, 4),  // 0xB6
+    instruction("SMB3", AddrMode::ZP, 5),  // 0xB7
+    instruction("CLV", AddrMode::IMP, 2),  // 0xB8
+    instruction("LDA", AddrMode::ABSY, 4),  // 0xB9
+    instruction("TSX", AddrMode::IMP, 2),  // 0xBA
+    instruction("NOP", AddrMode::IMP, 1),  // 0xBB
+    instruction("LDY", AddrMode::ABSX, 4),  // 0xBC
+    instruction("LDA", AddrMode::ABSX, 4),  // 0xBD
+    instruction("LDX", AddrMode::ABSY, 4),  // 0xBE
+    instruction("BBS3", AddrMode::ZPR, 5),  // 0xBF
+    instruction("CPY", AddrMode::IMM, 2),  // 0xC0
+    instruction("CMP", AddrMode::INX, 6),  // 0xC1
+    instruction("NOP", AddrMode::IMM, 2),  // 0xC2
+    instruction("NOP", AddrMode::IMP, 1),  // 0xC3
+    instruction("CPY", AddrMode::ZP, 3),  // 0xC4
+    instruction("CMP", AddrMode::ZP, 3),  // 0xC5
+    instruction("DEC", AddrMode::ZP, 5),  // 0xC6
+    instruction("SMB4", AddrMode::ZP, 5),  // 0xC7
+    instruction("INY", AddrMode::IMP, 2),  // 0xC8
+    instruction("CMP", AddrMode::IMM, 2),  // 0xC9
+    instruction("DEX", AddrMode::IMP, 2),  // 0xCA
+    instruction("WAI", AddrMode::IMP, 3),  // 0xCB
+    instruction("CPY", AddrMode::ABS, 4),  // 0xCC
+    instruction("CMP", AddrMode::ABS, 4),  // 0xCD
+    instruction("DEC", AddrMode::ABS, 6),  // 0xCE
+    instruction("BBS4", AddrMode::ZPR, 5),  // 0xCF
+    instruction("BNE", AddrMode::REL, 2),  // 0xD0
+    instruction("CMP", AddrMode::INY, 5),  // 0xD1
+    instruction("CMP", AddrMode::ZPI, 5),  // 0xD2
+    instruction("NOP", AddrMode::IMP, 1),  // 0xD3
+    instruction("NOP", AddrMode::ZPX, 4),  // 0xD4
+    instruction("CMP", AddrMode::ZPX, 4),  // 0xD5
+    instruction("DEC", AddrMode::ZPX, 6),  // 0xD6
+    instruction("SMB5", AddrMode::ZP, 5),  // 0xD7
+    instruction("CLD", AddrMode::IMP, 2),  // 0xD8
+    instruction("CMP", AddrMode::ABSY, 4),  // 0xD9
+    instruction("PHX", AddrMode::IMP, 3),  // 0xDA
+    instruction("STP", AddrMode::IMP, 3),  // 0xDB
+    instruction("NOP", AddrMode::ABS, 4),  // 0xDC
+    instruction("CMP", AddrMode::ABSX, 4),  // 0xDD
+    instruction("DEC", AddrMode::ABSX, 7),  // 0xDE
+    instruction("BBS5", AddrMode::ZPR, 5),  // 0xDF
+    instruction("CPX", AddrMode::IMM, 2),  // 0xE0
+    instruction("SBC", AddrMode::INX, 6),  // 0xE1
+    instruction("NOP", AddrMode::IMM, 2),  // 0xE2
+    instruction("NOP", AddrMode::IMP, 1),  // 0xE3
+    instruction("CPX", AddrMode::ZP, 3),  // 0xE4
+    instruction("SBC", AddrMode::ZP, 3),  // 0xE5
+    instruction("INC", AddrMode::ZP, 5),  // 0xE6
+    instruction("SMB6", AddrMode::ZP, 5),  // 0xE7
+    instruction("INX", AddrMode::IMP, 2),  // 0xE8
+    instruction("SBC", AddrMode::IMM, 2),  // 0xE9
+    instruction("NOP", AddrMode::IMP, 2),  // 0xEA
+    instruction("NOP", AddrMode::IMP, 1),  // 0xEB
+    instruction("CPX", AddrMode::ABS, 4),  // 0xEC
+    instruction("SBC", AddrMode::ABS, 4),  // 0xED
+    instruction("INC", AddrMode::ABS, 6),  // 0xEE
+    instruction("BBS6", AddrMode::ZPR, 5),  // 0xEF
+    instruction("BEQ", AddrMode::REL, 2),  // 0xF0
+    instruction("SBC", AddrMode::INY, 5),  // 0xF1
+    instruction("SBC", AddrMode::ZPI, 5),  // 0xF2
+    instruction("NOP", AddrMode::IMP, 1),  // 0xF3
+    instruction("NOP", AddrMode::ZPX, 4),  // 0xF4
+    instruction("SBC", AddrMode::ZPX, 4),  // 0xF5
+    instruction("INC", AddrMode::ZPX, 6),  // 0xF6
+    instruction("SMB7", AddrMode::ZP, 5),  // 0xF7
+    instruction("SED", AddrMode::IMP, 2),  // 0xF8
+    instruction("SBC", AddrMode::ABSY, 4),  // 0xF9
+    instruction("PLX", AddrMode::IMP, 4),  // 0xFA
+    instruction("NOP", AddrMode::IMP, 1),  // 0xFB
+    instruction("NOP", AddrMode::ABS, 4),  // 0xFC
+    instruction("SBC", AddrMode::ABSX, 4),  // 0xFD
+    instruction("INC", AddrMode::ABSX, 7),  // 0xFE
+    instruction("BBS7", AddrMode::ZPR, 5),  // 0xFF
+};
+
+// Whether the table entry of `op` has the given mnemonic and mode
+constexpr bool describes(Op op, const char* mnemonic, AddrMode mode) {
+    const InstructionInfo& info = INSTRUCTIONS[static_cast<byte>(op)];
+    for (int i = 0; mnemonic[i] || info.mnemonic[i]; ++i) {
+        if (mnemonic[i] != info.mnemonic[i]) return false;
+    }
+    return info.mode == mode;
+}
+
+// Every named opcode must agree with the table
+static_assert(describes(Op::BRK, "BRK", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::NOP, "NOP", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDA_IM, "LDA", AddrMode::IMM), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDA_AB, "LDA", AddrMode::ABS), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDA_ZP, "LDA", AddrMode::ZP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDA_ZPX, "LDA", AddrMode::ZPX), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDA_ABSX, "LDA", AddrMode::ABSX), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDA_ABSY, "LDA", AddrMode::ABSY), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDA_INX, "LDA", AddrMode::INX), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDA_INY, "LDA", AddrMode::INY), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDX_IM, "LDX", AddrMode::IMM), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDX_ZP, "LDX", AddrMode::ZP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDX_ZPY, "LDX", AddrMode::ZPY), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDX_AB, "LDX", AddrMode::ABS), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDX_ABSY, "LDX", AddrMode::ABSY), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDY_IM, "LDY", AddrMode::IMM), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDY_ZP, "LDY", AddrMode::ZP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDY_ZPX, "LDY", AddrMode::ZPX), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDY_AB, "LDY", AddrMode::ABS), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::LDY_ABSX, "LDY", AddrMode::ABSX), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STA_ZP, "STA", AddrMode::ZP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STA_ZPX, "STA", AddrMode::ZPX), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STA_ABS, "STA", AddrMode::ABS), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STA_ABSX, "STA", AddrMode::ABSX), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STA_ABSY, "STA", AddrMode::ABSY), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STA_INX, "STA", AddrMode::INX), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STA_INY, "STA", AddrMode::INY), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STX_ZP, "STX", AddrMode::ZP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STX_ZPY, "STX", AddrMode::ZPY), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STX_ABS, "STX", AddrMode::ABS), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STY_ZP, "STY", AddrMode::ZP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STY_ZPX, "STY", AddrMode::ZPX), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::STY_ABS, "STY", AddrMode::ABS), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::JSR, "JSR", AddrMode::ABS), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::RTS, "RTS", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::JMP, "JMP", AddrMode::ABS), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::JMPI, "JMP", AddrMode::IND), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::JMPIX, "JMP", AddrMode::AIX), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::BRA, "BRA", AddrMode::REL), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::BPL, "BPL", AddrMode::REL), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::BMI, "BMI", AddrMode::REL), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::BVC, "BVC", AddrMode::REL), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::BVS, "BVS", AddrMode::REL), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::BCC, "BCC", AddrMode::REL), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::BCS, "BCS", AddrMode::REL), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::BNE, "BNE", AddrMode::REL), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::BEQ, "BEQ", AddrMode::REL), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::PHA, "PHA", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::PHP, "PHP", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::PLA, "PLA", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::PLP, "PLP", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::TSX, "TSX", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::TXS, "TXS", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::TAX, "TAX", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::TAY, "TAY", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::TXA, "TXA", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::TYA, "TYA", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::RTI, "RTI", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::CLI, "CLI", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::SEI, "SEI", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::WAI, "WAI", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::INX, "INX", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::INY, "INY", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::DEX, "DEX", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::DEY, "DEY", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::ADC_IM, "ADC", AddrMode::IMM), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::ADC_ZP, "ADC", AddrMode::ZP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::ADC_AB, "ADC", AddrMode::ABS), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::SBC_IM, "SBC", AddrMode::IMM), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::SBC_ZP, "SBC", AddrMode::ZP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::SBC_AB, "SBC", AddrMode::ABS), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::CLC, "CLC", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::SEC, "SEC", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::CLD, "CLD", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+static_assert(describes(Op::SED, "SED", AddrMode::IMP), "op_codes.h disagrees with INSTRUCTIONS");
+
+#endif  // INSTRUCTIONS_H
@@ -0,0 +1,45 @@
+#ifndef IO_DEVICE_H
+#define IO_DEVICE_H
+
+#include <cstdint>
+
+#include "memory.h"
+#include "types.h"
+
+// Base class for memory mapped peripherals (VIA, ACIA, ...)
+//
+// Unlike plain memory, reading or writing a device register can have
+// side effects (clearing interrupt flags, starting timers), so every
+// access goes through `io_read` / `io_write` with the register offset
+// relative to the start of the range the device claims in the decoder.
+//
+// Devices never tick on their own. Anything time dependent is computed
+// lazily from the attached cycle counter when it is looked at.
+class IO_Device : public MEM_Module {
+   protected:
+    uint64_t* cycle_counter = nullptr;  // Emulated clock, usually `WDC65C02::cycles`
+
+    // Current cycle, 0 when no counter is attached
+    uint64_t now() const { return cycle_counter ? *cycle_counter : 0; }
+
+   public:
+    // Read a device register (may have side effects)
+    virtual byte io_read(word reg) = 0;
+
+    // Write a device register
+    virtual void io_write(word reg, byte data) = 0;
+
+    // Whether the device is pulling its IRQ output low right now
+    virtual bool irq_asserted() { return false; }
+
+    // Drive the device from an emulated cycle counter
+    void attach_cycle_counter(uint64_t* counter) { cycle_counter = counter; }
+
+    // Memory interface implementation, forwards to the register interface
+    word read_word(word addr) override { return io_read(addr); }
+    byte read_byte(byte addr) override { return io_read(addr); }
+    void write_word(word addr, word data) override { io_write(addr, data & 0xFF); }
+    void write_byte(byte addr, byte data) override { io_write(addr, data); }
+};
+
+#endif  // IO_DEVICE_H
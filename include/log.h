@@ -8,32 +8,42 @@
 
 namespace logger {
 
+// Drops every message while false, for runs that would drown in them
+// (e.g. fuzzing)
+inline bool enabled = true;
+
 inline void info(std::string msg) {
+    if (!enabled) return;
     std::cout << colors::BOLD << colors::GREEN << std::setw(11) << std::setfill(' ') << "[INFO] " << colors::RESET
               << msg << std::endl;
 }
 
 inline void error(std::string msg) {
+    if (!enabled) return;
     std::cerr << colors::BOLD << colors::RED << std::setw(11) << std::setfill(' ') << "[ERROR] " << colors::RESET << msg
               << std::endl;
 }
 
 inline void warning(std::string msg) {
+    if (!enabled) return;
     std::cerr << colors::BOLD << colors::YELLOW << std::setw(11) << std::setfill(' ') << "[WARNING] " << colors::RESET
               << msg << std::endl;
 }
 
 inline void debug(std::string msg) {
+    if (!enabled) return;
     std::cout << colors::BOLD << colors::BLUE << std::setw(11) << std::setfill(' ') << "[DEBUG] " << colors::RESET
               << msg << std::endl;
 }
 
 inline void print(std::string msg) {
+    if (!enabled) return;
     std::cout << colors::BOLD << colors::GREEN << std::setw(11) << std::setfill(' ') << "[WDC65C02] " << colors::RESET
               << msg << std::endl;
 }
 
 inline void header(std::string msg) {
+    if (!enabled) return;
     std::cout << colors::BOLD << colors::MAGENTA << std::string(60, '=') << colors::RESET << std::endl;
     std::cout << colors::BOLD << colors::MAGENTA << std::setw(30 + (msg.length() / 2)) << std::setfill(' ') << msg
               << colors::RESET << std::endl;
@@ -41,6 +51,7 @@ inline void header(std::string msg) {
 }
 
 inline void subheader(std::string msg) {
+    if (!enabled) return;
     std::cout << colors::BOLD << colors::CYAN << std::string(50, '-') << colors::RESET << std::endl;
     std::cout << colors::BOLD << colors::CYAN << std::setw(25 + (msg.length() / 2)) << std::setfill(' ') << msg
               << colors::RESET << std::endl;
@@ -48,6 +59,7 @@ inline void subheader(std::string msg) {
 }
 
 inline void divider() {
+    if (!enabled) return;
     std::cout << colors::BOLD << colors::WHITE << std::string(60, '-') << colors::RESET << std::endl;
 }
 
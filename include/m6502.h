@@ -0,0 +1,115 @@
+#ifndef M6502_H
+#define M6502_H
+
+/*
+ * C API of the emulator (libm6502)
+ *
+ * A stable C ABI over the emulator core for embedding it in other
+ * programs: create a machine, load images, run it for a number of cycles,
+ * look at and change its registers, and read its memory in place.
+ *
+ * The machine is the board's memory map: 32KB of SRAM at 0x0000-0x7FFF
+ * and a 32KB EEPROM at 0x8000-0xFFFF, with no devices and no threads.
+ * Calls are plain function calls on the caller's thread; a machine must
+ * only be used by one thread at a time, separate machines are independent.
+ *
+ * Memory views point straight into the emulated chips, so reading them
+ * costs nothing and always shows the current contents. Writing through a
+ * view bypasses the decoder: write-protected images and EEPROM write
+ * cycles aren't honored, use m6502_write for firmware-visible writes.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define M6502_API __attribute__((visibility("default")))
+#else
+#define M6502_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define M6502_API_VERSION 1 /* Bumped on incompatible changes */
+
+typedef struct m6502 m6502;
+
+typedef enum m6502_register {
+    M6502_REG_A = 0,
+    M6502_REG_X = 1,
+    M6502_REG_Y = 2,
+    M6502_REG_SP = 3,
+    M6502_REG_PC = 4,
+    M6502_REG_FLAGS = 5
+} m6502_register;
+
+typedef enum m6502_state {
+    M6502_STATE_POWER_OFF = 0,
+    M6502_STATE_POWER_ON = 1,
+    M6502_STATE_HALTED = 2, /* BRK, an unimplemented opcode or a failed access */
+    M6502_STATE_RUNNING = 3,
+    M6502_STATE_RESET = 4,
+    M6502_STATE_STOPPED = 5
+} m6502_state;
+
+/* M6502_API_VERSION the library was built with */
+M6502_API unsigned m6502_api_version(void);
+
+/* A new machine with cleared RAM and erased ROM (all 0xFF), powered off.
+ * NULL when out of memory. */
+M6502_API m6502* m6502_create(void);
+M6502_API void m6502_destroy(m6502* machine);
+
+/* Copy `size` bytes to `addr` and up, RAM or ROM alike, without any cycles
+ * or write timing. 0 on success, -1 when the block runs past 0xFFFF or the
+ * file can't be read. */
+M6502_API int m6502_load(m6502* machine, uint16_t addr, const uint8_t* data, size_t size);
+M6502_API int m6502_load_file(m6502* machine, uint16_t addr, const char* path);
+
+/* Reset: registers cleared, PC from the reset vector at 0xFFFC, running */
+M6502_API void m6502_reset(m6502* machine);
+
+/* Run until at least `cycles` more clock cycles have passed or the CPU
+ * stops, returns the cycles run. Whole instructions are run, so the last
+ * one may end a few cycles past the budget. */
+M6502_API uint64_t m6502_run(m6502* machine, uint64_t cycles);
+
+/* Run one instruction, returns its cycles */
+M6502_API uint64_t m6502_step(m6502* machine);
+
+M6502_API m6502_state m6502_get_state(const m6502* machine);
+M6502_API void m6502_set_state(m6502* machine, m6502_state state);
+
+/* Clock cycles since power on */
+M6502_API uint64_t m6502_cycles(const m6502* machine);
+
+M6502_API uint16_t m6502_get_register(const m6502* machine, m6502_register reg);
+M6502_API void m6502_set_register(m6502* machine, m6502_register reg, uint16_t value);
+
+/* Level of the IRQB / NMIB inputs (active low: 0 asserts) */
+M6502_API void m6502_set_irq(m6502* machine, int level);
+M6502_API void m6502_set_nmi(m6502* machine, int level);
+
+/* Memory as the CPU sees it, through the address decoder (no cycles).
+ * A write to the ROM starts an EEPROM write cycle (10ms, 10000 cycles at
+ * the 1MHz the timing assumes) that only runs down with m6502_run /
+ * m6502_step; until it ends, ROM reads return the DATA polling status. */
+M6502_API uint8_t m6502_read(m6502* machine, uint16_t addr);
+M6502_API void m6502_write(m6502* machine, uint16_t addr, uint8_t value);
+
+/* Direct pointer to the bytes at `addr`, `length` receives how many
+ * follow contiguously (up to the end of the chip). NULL while the EEPROM
+ * is in a write cycle. The mutable view is RAM only. */
+M6502_API const uint8_t* m6502_view(m6502* machine, uint16_t addr, size_t* length);
+M6502_API uint8_t* m6502_view_mut(m6502* machine, uint16_t addr, size_t* length);
+
+/* Log the core's messages to stdout (off by default) */
+M6502_API void m6502_set_logging(int enabled);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* M6502_H */
@@ -1,6 +1,9 @@
 #ifndef MEMORY_H
 #define MEMORY_H
 
+#include <cstddef>
+#include <cstdint>
+
 #include "types.h"
 
 class MEM_Module {
@@ -9,6 +12,18 @@ class MEM_Module {
     virtual byte read_byte(byte addr) = 0;
     virtual void write_word(word addr, word data) = 0;
     virtual void write_byte(byte addr, byte data) = 0;
+
+    // Earliest cycle at which the module changes state on its own
+    // (timer underflow, end of a write cycle, ...), UINT64_MAX when idle
+    virtual uint64_t next_event() { return UINT64_MAX; }
+
+    // Direct access for bulk copies (DMA): the module's bytes from
+    // `offset` on, `length` receives how many follow contiguously. nullptr
+    // when the accesses must go one by one (side effects, write cycles,
+    // write protection)
+    virtual const byte* read_span(word offset, size_t& length) { return nullptr; }
+    virtual byte* write_span(word offset, size_t& length) { return nullptr; }
+
     virtual ~MEM_Module() = default;
 };
 
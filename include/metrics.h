@@ -0,0 +1,84 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "types.h"
+
+// Runtime counters of the emulator (see metrics_writer.h for the output)
+//
+// Every thread that counts gets a shard of its own, aligned to cache lines
+// so threads never write to a line another one uses. A shard has one
+// writer, so counting is a plain load and store, and `collect()` adds the
+// shards up when the metrics are read. Shards of threads that exit are
+// kept, with their counts, and handed to the next new thread.
+namespace metrics {
+
+// Nothing is counted while false, the default, so the hooks cost one
+// predictable branch. Set once from the writer thread while the CPU and
+// chip threads read it, relaxed loads are enough for a switch.
+inline std::atomic<bool> enabled{false};
+
+enum Counter : unsigned {
+    CYCLES,           // Clock cycles run by the CPU
+    BUS_TIMEOUTS,     // `Bus::request_bus` calls that gave up
+    UNMAPPED_READS,   // Decoder reads nothing is mapped at
+    UNMAPPED_WRITES,  // Decoder writes nothing is mapped at
+    MONITOR_WAKEUPS,  // Iterations of the chips' bus monitoring threads
+    COUNTERS
+};
+
+// Upper bounds of the bus wait histogram buckets in microseconds, the
+// last bucket takes everything above
+inline constexpr uint64_t WAIT_BOUNDS_US[] = {1, 4, 16, 64, 256, 1024, 4096, 16384, 65536};
+inline constexpr unsigned WAIT_BUCKETS = sizeof(WAIT_BOUNDS_US) / sizeof(WAIT_BOUNDS_US[0]) + 1;
+
+// One thread's counters
+struct alignas(64) Shard {
+    std::atomic<uint64_t> counters[COUNTERS] = {};
+    std::atomic<uint64_t> opcodes[256] = {};            // Instructions run, by opcode
+    std::atomic<uint64_t> bus_wait[WAIT_BUCKETS] = {};  // Bus acquisitions by wait time
+    std::atomic<uint64_t> bus_wait_ns = {0};            // Total time waited for the bus
+};
+
+// Sum of all shards
+struct Totals {
+    uint64_t counters[COUNTERS] = {};
+    uint64_t opcodes[256] = {};
+    uint64_t bus_wait[WAIT_BUCKETS] = {};
+    uint64_t bus_wait_ns = 0;
+    unsigned threads = 0;  // Shards added up
+
+    uint64_t instructions() const;
+};
+
+// Shard of the calling thread, nullptr until it counts something
+inline thread_local Shard* shard = nullptr;
+
+// Give the calling thread a shard (a free one or a new one)
+Shard* register_thread();
+
+inline Shard& local() {
+    Shard* s = shard;
+    return s ? *s : *register_thread();
+}
+
+// Single writer per shard, no read-modify-write needed
+inline void bump(std::atomic<uint64_t>& counter, uint64_t n = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void add(Counter counter, uint64_t n = 1) { bump(local().counters[counter], n); }
+
+inline void count_opcode(byte opcode) { bump(local().opcodes[opcode]); }
+
+// Record one bus acquisition that waited `ns` nanoseconds
+void record_bus_wait(uint64_t ns);
+
+// Add up the shards of all threads, running ones included
+Totals collect();
+
+}  // namespace metrics
+
+#endif  // METRICS_H
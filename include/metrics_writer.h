@@ -0,0 +1,68 @@
+#ifndef METRICS_WRITER_H
+#define METRICS_WRITER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include "metrics.h"
+
+// Writes the metrics (metrics.h) to a file at a fixed interval
+//
+// The file is written next to its final name and renamed over it, so a
+// dashboard or a scraper (e.g. node_exporter's textfile collector) never
+// reads half of it. Next to the counters it reports the clock rate the
+// emulator reached over the last interval and the configured one, which
+// is how a machine that falls behind real time shows up.
+class MetricsWriter {
+   public:
+    enum class Format { JSON, PROMETHEUS };
+
+   private:
+    std::string path;
+    Format format;
+    std::chrono::milliseconds interval;
+    double configured_hz = 0;  // 0 when unknown
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool running = false;
+
+    // Clock rate over the last interval
+    std::mutex write_mutex;  // `write` from the thread and from callers
+    std::chrono::steady_clock::time_point last_time;
+    uint64_t last_cycles = 0;
+    double effective_hz = 0;
+
+    void run();
+    void write_json(std::ostream& out, const metrics::Totals& totals) const;
+    void write_prometheus(std::ostream& out, const metrics::Totals& totals) const;
+
+   public:
+    // JSON when `path` ends in ".json", the Prometheus text format otherwise
+    MetricsWriter(const std::string& path, std::chrono::milliseconds interval = std::chrono::seconds(1));
+    MetricsWriter(const MetricsWriter&) = delete;
+    MetricsWriter& operator=(const MetricsWriter&) = delete;
+    ~MetricsWriter();  // Stops, with a last write
+
+    Format file_format() const { return format; }
+
+    // Clock speed the emulator is meant to run at (`MM_ClockModule::get_speed`),
+    // set before `start`
+    void set_configured_clock(double hz) { configured_hz = hz; }
+
+    // Switch counting on (`metrics::enabled`) and write every interval
+    // from a thread of its own
+    void start();
+    void stop();
+
+    // Write the file now, false (and logged) if it can't be written
+    bool write();
+};
+
+#endif  // METRICS_WRITER_H
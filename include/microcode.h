@@ -0,0 +1,169 @@
+#ifndef MICROCODE_H
+#define MICROCODE_H
+
+#include "instructions.h"
+#include "op_codes.h"
+#include "types.h"
+
+// Bus cycles of each instruction, for the CPU's cycle mode
+//
+// Every instruction is a sequence of steps, one bus cycle each, that says
+// what is on the address bus and whether it is a read or a write. Internal
+// cycles are the reads the 65C02 really makes while it works (of the next
+// program byte or the stack), so every step is a bus access. Conditional
+// steps only take a cycle when their condition holds, the rest are skipped.
+//
+// The sequences are generated at compile time from `INSTRUCTIONS` (which
+// gives the operand fetches) and the kind of the instruction, for the
+// opcodes the CPU implements. The others only fetch their opcode and
+// operand, then the CPU halts on them as `step()` does.
+
+enum class BusStep : byte {
+    OPCODE,        // Read the opcode at PC with SYNC high, PC + 1
+    OPERAND,       // Read the (low) operand byte at PC, PC + 1
+    OPERAND_HIGH,  // Read the high operand byte at PC, PC + 1
+    DUMMY_PC,      // Internal cycle, reads PC without advancing it
+    DECIMAL,       // DUMMY_PC, only in decimal mode (ADC / SBC)
+    BRANCH,        // DUMMY_PC, only when the branch is taken
+    BRANCH_PAGE,   // DUMMY_PC, only when the taken branch crosses a page
+    READ,          // Read the operand's address
+    WRITE,         // Write the operand's address
+    POINTER_LOW,   // Read the low byte of a jump pointer
+    POINTER_HIGH,  // Read the high byte of a jump pointer
+    DUMMY_STACK,   // Internal cycle, reads the stack at SP
+    PUSH_PCH,      // Push the PC and status (interrupts)
+    PUSH_PCL,      //
+    PUSH_P,        //
+    PULL_P,        // Pull the status and PC (RTI)
+    PULL_PCL,      //
+    PULL_PCH,      //
+    VECTOR_LOW,    // Read the interrupt vector into the PC
+    VECTOR_HIGH,   //
+};
+
+struct Microcode {
+    byte length;       // Steps in use
+    bool implemented;  // False when the CPU halts after the fetches
+    BusStep steps[7];
+};
+
+constexpr Microcode microcode(byte opcode) {
+    Microcode code{};
+    auto add = [&code](BusStep step) { code.steps[code.length++] = step; };
+
+    const InstructionInfo& info = INSTRUCTIONS[opcode];
+    add(BusStep::OPCODE);
+    if (info.length >= 2) add(BusStep::OPERAND);
+    if (info.length == 3) add(BusStep::OPERAND_HIGH);
+
+    code.implemented = true;
+    switch (static_cast<Op>(opcode)) {
+        case Op::NOP:
+        case Op::INX:
+        case Op::INY:
+        case Op::DEX:
+        case Op::DEY:
+        case Op::TAX:
+        case Op::TAY:
+        case Op::TXA:
+        case Op::TYA:
+        case Op::CLI:
+        case Op::SEI:
+        case Op::CLC:
+        case Op::SEC:
+        case Op::CLD:
+        case Op::SED:
+            add(BusStep::DUMMY_PC);
+            break;
+
+        case Op::LDA_IM:
+        case Op::LDX_IM:
+        case Op::LDY_IM:
+        case Op::JMP:
+            break;
+
+        case Op::ADC_IM:
+        case Op::SBC_IM:
+            add(BusStep::DECIMAL);
+            break;
+
+        case Op::LDA_AB:
+            add(BusStep::READ);
+            break;
+
+        case Op::ADC_ZP:
+        case Op::ADC_AB:
+        case Op::SBC_ZP:
+        case Op::SBC_AB:
+            add(BusStep::READ);
+            add(BusStep::DECIMAL);
+            break;
+
+        case Op::STA_ABS:
+            add(BusStep::WRITE);
+            break;
+
+        case Op::JMPI:
+        case Op::JMPIX:
+            add(BusStep::DUMMY_PC);
+            add(BusStep::POINTER_LOW);
+            add(BusStep::POINTER_HIGH);
+            break;
+
+        case Op::BRA:
+        case Op::BPL:
+        case Op::BMI:
+        case Op::BVC:
+        case Op::BVS:
+        case Op::BCC:
+        case Op::BCS:
+        case Op::BNE:
+        case Op::BEQ:
+            add(BusStep::BRANCH);
+            add(BusStep::BRANCH_PAGE);
+            break;
+
+        case Op::RTI:
+            add(BusStep::DUMMY_PC);
+            add(BusStep::DUMMY_STACK);
+            add(BusStep::PULL_P);
+            add(BusStep::PULL_PCL);
+            add(BusStep::PULL_PCH);
+            break;
+
+        case Op::WAI:
+            add(BusStep::DUMMY_PC);
+            add(BusStep::DUMMY_PC);
+            break;
+
+        default:
+            code.implemented = false;
+            break;
+    }
+    return code;
+}
+
+struct MicrocodeTable {
+    Microcode codes[256];
+
+    constexpr MicrocodeTable() : codes() {
+        for (int opcode = 0; opcode < 256; ++opcode) codes[opcode] = microcode(opcode);
+    }
+
+    constexpr const Microcode& operator[](byte opcode) const { return codes[opcode]; }
+};
+
+inline constexpr MicrocodeTable MICROCODE;
+
+// The opcode fetch every instruction starts with, the rest of the
+// sequence is picked once the opcode is known
+inline constexpr Microcode FETCH_MICROCODE = {1, true, {BusStep::OPCODE}};
+
+// IRQ / NMI: two internal cycles, the pushes and the vector
+inline constexpr Microcode INTERRUPT_MICROCODE = {
+    7,
+    true,
+    {BusStep::DUMMY_PC, BusStep::DUMMY_PC, BusStep::PUSH_PCH, BusStep::PUSH_PCL, BusStep::PUSH_P, BusStep::VECTOR_LOW,
+     BusStep::VECTOR_HIGH}};
+
+#endif  // MICROCODE_H
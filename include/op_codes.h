@@ -43,10 +43,22 @@ enum class Op : byte {
     STY_ZPX = 0x94,  // Store Y Register Zero Page,X
     STY_ABS = 0x8C,  // Store Y Register Absolute
     // -----------------------------------------------
-    JSR = 0x20,   // Jump to Subroutine
-    RTS = 0x60,   // Return from Subroutine
-    JMP = 0x4C,   // Jump Absolute
-    JMPI = 0x6C,  // Jump Indirect
+    JSR = 0x20,    // Jump to Subroutine
+    RTS = 0x60,    // Return from Subroutine
+    JMP = 0x4C,    // Jump Absolute
+    JMPI = 0x6C,   // Jump Indirect
+    JMPIX = 0x7C,  // Jump Absolute Indexed Indirect
+    // -----------------------------------------------
+    // Branch Operations
+    BRA = 0x80,  // Branch Always
+    BPL = 0x10,  // Branch if Plus (N clear)
+    BMI = 0x30,  // Branch if Minus (N set)
+    BVC = 0x50,  // Branch if Overflow Clear
+    BVS = 0x70,  // Branch if Overflow Set
+    BCC = 0x90,  // Branch if Carry Clear
+    BCS = 0xB0,  // Branch if Carry Set
+    BNE = 0xD0,  // Branch if Not Equal (Z clear)
+    BEQ = 0xF0,  // Branch if Equal (Z set)
     // -----------------------------------------------
     // Stack Operations
     PHA = 0x48,  // Push Accumulator on Stack
@@ -62,12 +74,32 @@ enum class Op : byte {
     TXA = 0x8A,  // Transfer X to Accumulator
     TYA = 0x98,  // Transfer Y to Accumulator
     // -----------------------------------------------
+    // Interrupt Operations
+    RTI = 0x40,  // Return from Interrupt
+    CLI = 0x58,  // Clear Interrupt Disable
+    SEI = 0x78,  // Set Interrupt Disable
+    WAI = 0xCB,  // Wait for Interrupt
+    // -----------------------------------------------
     // Increment & Decrement Operations
     INX = 0xE8,  // Increment X Register
     INY = 0xC8,  // Increment Y Register
     DEX = 0xCA,  // Decrement X Register
     DEY = 0x88,  // Decrement Y Register
     // -----------------------------------------------
+    // Arithmetic Operations
+    ADC_IM = 0x69,  // Add with Carry Immediate
+    ADC_ZP = 0x65,  // Add with Carry Zero Page
+    ADC_AB = 0x6D,  // Add with Carry Absolute
+    SBC_IM = 0xE9,  // Subtract with Carry Immediate
+    SBC_ZP = 0xE5,  // Subtract with Carry Zero Page
+    SBC_AB = 0xED,  // Subtract with Carry Absolute
+    // -----------------------------------------------
+    // Flag Operations
+    CLC = 0x18,  // Clear Carry Flag
+    SEC = 0x38,  // Set Carry Flag
+    CLD = 0xD8,  // Clear Decimal Mode
+    SED = 0xF8,  // Set Decimal Mode
+    // -----------------------------------------------
 };
 
 #endif
@@ -0,0 +1,101 @@
+#ifndef PIN_CHECKER_H
+#define PIN_CHECKER_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "at28c256.h"
+#include "bus.h"
+#include "decoder.h"
+#include "hm62256b.h"
+#include "types.h"
+
+// Differential checker between the decoder fast path and the pin level
+// path of the memory chips
+//
+// The CPU keeps executing through the decoder and reports every access
+// here. A configurable fraction of them is repeated through the chip's
+// pins (address and control pins driven, `write_to_bus` / `read_from_bus`,
+// data taken from the `Bus`) and the results are compared:
+//
+//  - Reads: the byte the pins put on the bus must be the byte the CPU got
+//  - Writes: the pins must read back the byte just written, and writing
+//    it again through the pins must leave the same byte in the chip
+//
+// Sampling is driven by a fixed seed, so a run samples the same accesses
+// every time. Addresses where the decoder reaches something other than
+// the chip (an I/O device mapped over part of it) aren't checked, devices
+// have no pin path. The EEPROM is skipped while its write cycle runs (its
+// status reads have side effects) and EEPROM writes are never repeated,
+// those count as skipped. The checker drives the pins itself, so the
+// chips' monitoring threads must not run at the same time.
+class PinChecker {
+   public:
+    struct Mismatch {
+        uint64_t cycle;  // CPU cycle of the access
+        word addr;       // CPU address
+        byte fast;       // Byte seen through the decoder
+        byte pin;        // Byte seen through the pins
+        bool write;      // Found checking a write
+    };
+
+   private:
+    struct Chip {
+        word start;
+        word end;
+        HM62256B* sram;    // One of the two is set
+        AT28C256* eeprom;
+    };
+
+    static constexpr size_t MAX_RECORDED = 32;  // Mismatches kept for the report
+
+    Bus& bus;
+    const AddressDecoder& decoder;  // Tells which chip an address really reaches
+    std::vector<Chip> chips;
+    uint64_t* cycle_counter = nullptr;
+
+    uint64_t threshold = 0;        // Sample when the next random number is below this
+    uint32_t random = 0x2545F491;  // xorshift32 state
+
+    uint64_t accesses = 0;
+    uint64_t sampled_reads = 0;
+    uint64_t sampled_writes = 0;
+    uint64_t skipped = 0;
+    uint64_t mismatch_count = 0;
+    std::vector<Mismatch> mismatches;  // The first MAX_RECORDED
+
+    bool sample();
+    const Chip* find(word addr) const;
+
+    // One access through the chip's pins at its local address
+    byte pin_read(const Chip& chip, word offset);
+    void pin_write(const Chip& chip, word offset, byte value);
+
+    void record(word addr, byte fast, byte pin, bool write);
+
+   public:
+    // Check `fraction` (0 to 1) of the accesses going through `decoder`
+    PinChecker(Bus& bus, const AddressDecoder& decoder, double fraction = 0.01);
+
+    void set_sample_rate(double fraction);
+
+    // Chips mapped at start-end in the decoder
+    void add_chip(word start, word end, HM62256B& sram);
+    void add_chip(word start, word end, AT28C256& eeprom);
+
+    // Timestamp mismatches with the CPU's cycle counter
+    void attach_cycle_counter(uint64_t* counter) { cycle_counter = counter; }
+
+    // Called by the CPU after each access through the decoder
+    void check_read(word addr, byte value);
+    void check_write(word addr, byte value);
+
+    uint64_t mismatch_total() const { return mismatch_count; }
+    const std::vector<Mismatch>& recorded() const { return mismatches; }
+
+    // Counts and the recorded mismatches, one line each
+    void report(std::ostream& out) const;
+};
+
+#endif  // PIN_CHECKER_H
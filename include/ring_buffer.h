@@ -0,0 +1,61 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+
+// Lock-free single producer / single consumer ring buffer
+//
+// Note:
+//  - `N` must be a power of two, one slot is never used
+//  - Exactly one thread may push and exactly one thread may pop
+template <typename T, size_t N>
+class RingBuffer {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "RingBuffer size must be a power of two");
+
+   private:
+    T slots[N];
+    alignas(64) std::atomic<size_t> head{0};  // Next slot to pop (owned by the consumer)
+    alignas(64) std::atomic<size_t> tail{0};  // Next slot to push (owned by the producer)
+
+   public:
+    // Push one item, returns false when the buffer is full
+    bool push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t next = (t + 1) & (N - 1);
+        if (next == head.load(std::memory_order_acquire)) return false;
+        slots[t] = item;
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Pop one item, returns false when the buffer is empty
+    bool pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = slots[h];
+        head.store((h + 1) & (N - 1), std::memory_order_release);
+        return true;
+    }
+
+    // Pop up to `max` items into `out`, returns how many were popped
+    size_t pop_bulk(T* out, size_t max) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (h != t && count < max) {
+            out[count++] = slots[h];
+            h = (h + 1) & (N - 1);
+        }
+        head.store(h, std::memory_order_release);
+        return count;
+    }
+
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+    bool full() const {
+        return ((tail.load(std::memory_order_acquire) + 1) & (N - 1)) == head.load(std::memory_order_acquire);
+    }
+};
+
+#endif  // RING_BUFFER_H
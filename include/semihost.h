@@ -0,0 +1,98 @@
+#ifndef SEMIHOST_H
+#define SEMIHOST_H
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include "decoder.h"
+#include "io_device.h"
+#include "types.h"
+
+// Semihosting: host services for test firmware through one register write
+//
+// Mapped like any device (opt-in, at an address of the board's choosing),
+// it turns a write to its command register into work done by the host:
+// printing a string, stopping with an exit code, loading or saving a file
+// in emulated memory, reading the cycle counter. Firmware sets up the
+// argument registers and stores the command, so a whole console routine
+// or result dump becomes a few emulated instructions.
+//
+// Files are only reachable once `set_file_root` names a host directory,
+// and only by relative paths below it.
+class Semihost : public IO_Device {
+   public:
+    // Register offsets
+    enum Reg : byte {
+        COMMAND = 0x0,  // Command (write) / status (read)
+        DATA = 0x1,     // Byte argument (character, exit code)
+        PTR_LO = 0x2,   // String or file name in emulated memory
+        PTR_HI = 0x3,   //
+        BUF_LO = 0x4,   // Buffer of a file transfer
+        BUF_HI = 0x5,   //
+        LEN_LO = 0x6,   // Byte count, meaning depends on the command
+        LEN_HI = 0x7,   //
+        RESULT = 0x8    // 8 byte little endian result (0x8-0xF)
+    };
+
+    // Commands
+    enum Command : byte {
+        CMD_PUTC = 0x01,        // Print DATA
+        CMD_PRINT = 0x02,       // Print LEN bytes at PTR, up to a NUL when LEN is 0
+        CMD_EXIT = 0x03,        // Stop with exit code DATA
+        CMD_READ_FILE = 0x04,   // Load the file named at PTR to BUF, at most LEN bytes (0: to the end of memory)
+        CMD_WRITE_FILE = 0x05,  // Save LEN bytes at BUF to the file named at PTR
+        CMD_CYCLES = 0x06       // Cycle counter into RESULT
+    };
+
+    // Status register bits
+    enum Status : byte {
+        STATUS_ERROR = 0x01,  // The last command failed (unknown, file error)
+        STATUS_EXITED = 0x80  // CMD_EXIT was issued
+    };
+
+    static constexpr size_t MAX_NAME = 255;  // Longest file name read from memory
+
+   private:
+    AddressDecoder& decoder;
+    std::ostream* console;
+    std::string file_root;  // Empty while file access is off
+    std::function<void(int)> exit_handler;
+
+    byte data = 0x00;
+    word pointer = 0;
+    word buffer = 0;
+    word length = 0;
+    uint64_t result = 0;
+    bool error = false;
+    bool exited = false;
+    int code = 0;
+
+    // Host path of the file named at `pointer`, empty when not allowed
+    std::string file_path();
+
+    void print();
+    void read_file();
+    void write_file();
+
+   public:
+    // Console output goes to `console`, memory is accessed through `decoder`
+    Semihost(AddressDecoder& decoder, std::ostream& console);
+
+    // Allow CMD_READ_FILE / CMD_WRITE_FILE below `directory`
+    void set_file_root(const std::string& directory) { file_root = directory; }
+
+    // Called with the exit code on CMD_EXIT (e.g. to halt the CPU)
+    void set_exit_handler(std::function<void(int)> handler) { exit_handler = std::move(handler); }
+
+    bool has_exited() const { return exited; }
+    int exit_code() const { return code; }
+
+    // IO_Device interface
+    byte io_read(word reg) override;
+    void io_write(word reg, byte value) override;
+};
+
+#endif  // SEMIHOST_H
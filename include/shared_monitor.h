@@ -0,0 +1,132 @@
+#ifndef SHARED_MONITOR_H
+#define SHARED_MONITOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "types.h"
+
+class AddressDecoder;
+class AT28C256;
+class HM62256B;
+
+// Registers and counters of the CPU at an instruction boundary
+struct MonitorSnapshot {
+    byte A = 0, X = 0, Y = 0, SP = 0, FLAGS = 0;
+    word PC = 0;
+    CPU_State state = CPU_State::POWER_OFF;
+    uint64_t cycles = 0;
+    uint64_t skipped_cycles = 0;  // Part of `cycles` fast-forwarded over idle loops and WAI
+    uint64_t sequence = 0;        // Seqlock count it was read at, grows with every update
+};
+
+// Start of the shared memory segment, also read by monitors written in
+// other languages, so the layout is fixed:
+//
+//  offset 0      this block
+//  `ram_offset`  32KB of SRAM (0x0000-0x7FFF)
+//  `rom_offset`  32KB of EEPROM (0x8000-0xFFFF)
+//
+// `registers` packs A, X, Y, SP and FLAGS into bits 0-39, PC into bits
+// 40-55 and the CPU_State into bits 56-63.
+struct SharedMonitorBlock {
+    static constexpr uint32_t MAGIC = 0x3035364D;  // "M650" in memory, checked by readers
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ram_offset;
+    uint32_t rom_offset;
+
+    alignas(64) std::atomic<uint64_t> sequence;  // Odd while an update is being written
+    std::atomic<uint64_t> registers;
+    std::atomic<uint64_t> cycles;
+    std::atomic<uint64_t> skipped_cycles;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The shared block needs address free atomics");
+
+// Live view of a running machine for dashboards and external tools
+//
+// Creates a POSIX shared memory segment (see `SharedMonitorBlock`) and,
+// once the chips are attached, keeps the SRAM and EEPROM contents in it,
+// so other processes see memory as the firmware changes it without the
+// emulator copying a byte. The CPU publishes its registers and counters
+// into the block at every instruction boundary under a seqlock: a couple
+// of stores for the CPU thread, and readers (`SharedMonitorView`) never
+// make it wait.
+//
+// Note:
+//  - Memory isn't covered by the seqlock: every byte reads consistently,
+//    a multi byte value can change between reading its bytes
+//  - The chips keep using the segment, the monitor must outlive them
+//  - Attach before anything holds on to the chips' arrays: map the EEPROM
+//    image (`AT28C256::map_image`, copied into the segment) and attach a
+//    state hash (`AddressDecoder::attach_state_hash`) afterwards
+class SharedMonitor {
+   private:
+    std::string name;
+    byte* base = nullptr;
+    SharedMonitorBlock* block = nullptr;
+
+   public:
+    // Creates the segment `name` (e.g. "/m6502"), replacing a stale one
+    // of the same name. Throws `std::runtime_error` if it can't.
+    SharedMonitor(const std::string& name);
+    SharedMonitor(const SharedMonitor&) = delete;
+    SharedMonitor& operator=(const SharedMonitor&) = delete;
+    ~SharedMonitor();  // Unmaps and removes the segment
+
+    const std::string& segment_name() const { return name; }
+
+    // Move the chips' contents into the segment. Fails, logged and with
+    // the chips left alone, when the EEPROM has an image mapped or
+    // `decoder` already has a state hash attached.
+    bool attach(HM62256B& sram, AT28C256& eeprom, const AddressDecoder& decoder);
+
+    // Publish a new snapshot (see `WDC65C02::attach_monitor`)
+    void publish(const MonitorSnapshot& snapshot) {
+        uint64_t seq = block->sequence.load(std::memory_order_relaxed);
+        block->sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        uint64_t registers = snapshot.A | snapshot.X << 8 | snapshot.Y << 16 | uint64_t(snapshot.SP) << 24 |
+                             uint64_t(snapshot.FLAGS) << 32 | uint64_t(snapshot.PC) << 40 |
+                             uint64_t(snapshot.state) << 56;
+        block->registers.store(registers, std::memory_order_relaxed);
+        block->cycles.store(snapshot.cycles, std::memory_order_relaxed);
+        block->skipped_cycles.store(snapshot.skipped_cycles, std::memory_order_relaxed);
+
+        block->sequence.store(seq + 2, std::memory_order_release);
+    }
+};
+
+// Read only mapping of a `SharedMonitor` segment, usually in another process
+class SharedMonitorView {
+   private:
+    const byte* base = nullptr;
+    const SharedMonitorBlock* block = nullptr;
+
+   public:
+    // Maps the segment `name`. Throws `std::runtime_error` if it doesn't
+    // exist or isn't a monitor segment of this version.
+    SharedMonitorView(const std::string& name);
+    SharedMonitorView(const SharedMonitorView&) = delete;
+    SharedMonitorView& operator=(const SharedMonitorView&) = delete;
+    ~SharedMonitorView();
+
+    // Live memory, 32KB each
+    const byte* ram() const { return base + block->ram_offset; }
+    const byte* rom() const { return base + block->rom_offset; }
+
+    // Consistent registers and counters, retries while an update is
+    // being written
+    MonitorSnapshot snapshot() const;
+
+    // Whether anything was published after the snapshot taken at `sequence`
+    bool changed_since(uint64_t sequence) const { return block->sequence.load(std::memory_order_acquire) != sequence; }
+};
+
+#endif  // SHARED_MONITOR_H
@@ -0,0 +1,82 @@
+#ifndef STATE_HASH_H
+#define STATE_HASH_H
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "types.h"
+
+class WDC65C02;
+
+// Hash of the machine state (CPU registers plus tracked RAM)
+//
+// The memory part is a sum of one mixed value per (address, byte) pair,
+// so a write only has to take the old byte's value out and add the new
+// one. `AddressDecoder::write` does that for every write once the hash is
+// attached with `AddressDecoder::attach_state_hash`. `rehash()` recomputes
+// the sum from scratch, 8 bytes at a time with AVX2 where the host has it,
+// to verify the running value or to resync after memory was changed
+// behind the decoder's back (loading an image, switching a RAM bank).
+//
+// The mixing uses fixed constants, so equal states hash equally in every
+// process and hashes can be compared across machines.
+class StateHash {
+   private:
+    struct Region {
+        word start;
+        word end;
+        const byte* data;  // Byte at `start`
+    };
+
+    std::vector<Region> regions;
+    const Region* pages[256] = {};  // Region covering each page, nullptr if none
+
+    uint64_t memory_hash = 0;              // Running sum over the tracked bytes
+    std::unordered_set<uint64_t> visited;  // States seen by `revisit`
+
+    // Tracked byte at `addr`, nullptr when the address isn't tracked
+    const byte* cell(word addr) const {
+        const Region* region = pages[addr >> 8];
+        if (region == nullptr || addr < region->start || addr > region->end) return nullptr;
+        return region->data + (addr - region->start);
+    }
+
+    static uint64_t sum(const Region& region);
+
+    friend class AddressDecoder;
+
+   public:
+    // Mixed value of one byte, the memory hash is the sum (mod 2^32 in each
+    // half) of these over the tracked addresses
+    static uint64_t contribution(word addr, byte value);
+
+    // Include start-end, whose bytes are read from `data` (e.g. the array
+    // of a RAM module). Regions must not share a page.
+    void track(word start, word end, const byte* data);
+
+    // Recompute the memory hash from the tracked bytes and return it
+    uint64_t rehash();
+
+    // Whether the running memory hash matches a full rehash (which it
+    // then adopts)
+    bool verify();
+
+    // Account for a write that changed `addr` from `old_value` to `new_value`
+    void update(word addr, byte old_value, byte new_value);
+
+    // Hash of the tracked memory alone
+    uint64_t memory() const { return memory_hash; }
+
+    // Hash of the memory and the CPU registers
+    uint64_t state(const WDC65C02& cpu) const;
+
+    // Record the current state, true if it was already recorded (the run
+    // is looping or converged on a known state)
+    bool revisit(const WDC65C02& cpu) { return !visited.insert(state(cpu)).second; }
+
+    // Forget the recorded states
+    void clear_visited() { visited.clear(); }
+};
+
+#endif  // STATE_HASH_H
@@ -26,16 +26,31 @@ enum class CPU_State : byte {
     POWER_ON = 0x01,   // CPU is powered on
     HALTED = 0x02,     // CPU is halted
     RUNNING = 0x03,    // CPU is running
-    RESET = 0x04       // CPU is in reset state
+    RESET = 0x04,      // CPU is in reset state
+    STOPPED = 0x05     // CPU is stopped on a breakpoint or watchpoint
+};
+
+// How an EEPROM image file is mapped into the chip
+enum class RomMapping : byte {
+    PRIVATE = 0x00,          // Copy-on-write mapping, writes stay inside this process
+    SHARED_READONLY = 0x01,  // Read-only mapping shared by every process using the image
+    PERSISTENT = 0x02        // Shared writable mapping, writes are kept in the image file
+};
+
+// The two 8-bit ports of the W65C22 VIA
+enum class ViaPort : byte {
+    A = 0x00,  // Port A (PA0-PA7, handshake on CA1/CA2)
+    B = 0x01   // Port B (PB0-PB7, handshake on CB1/CB2)
 };
 
 // Identifies which component currently owns the bus
 enum class BusOwner : byte {
-    NONE = 0,      // No component owns the bus
-    CPU = 1,       // CPU owns the bus
-    MEMORY = 2,    // Memory module owns the bus
-    CLOCK = 3,     // Clock module owns the bus
-    IO_DEVICE = 4  // I/O device owns the bus
+    NONE = 0,       // No component owns the bus
+    CPU = 1,        // CPU owns the bus
+    MEMORY = 2,     // Memory module owns the bus
+    CLOCK = 3,      // Clock module owns the bus
+    IO_DEVICE = 4,  // I/O device owns the bus
+    DMA = 5         // DMA controller owns the bus
 };
 
 #endif  // TYPES_H
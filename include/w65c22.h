@@ -0,0 +1,163 @@
+#ifndef W65C22_H
+#define W65C22_H
+
+#include <cstdint>
+
+#include "io_device.h"
+#include "types.h"
+
+// Something wired to one of the VIA ports (LEDs, an LCD, a keypad, ...)
+class ViaPortListener {
+   public:
+    // Called whenever the VIA writes the output register or the data
+    // direction register of `port`. Only bits set in `ddr` are driven.
+    virtual void port_written(ViaPort port, byte value, byte ddr) = 0;
+
+    // Level the peripheral drives on the pins of `port`
+    // (only the bits configured as inputs are used)
+    virtual byte port_read(ViaPort port) { return 0xFF; }
+
+    // Called when a byte has been shifted out through the shift register
+    virtual void shifted_out(byte value) {}
+
+    virtual ~ViaPortListener() = default;
+};
+
+// W65C22 Versatile Interface Adapter
+//
+// Two 8-bit ports with data direction registers, two 16-bit timers, a
+// shift register and an IRQ output.
+//
+// Nothing is ticked per cycle: the timers and the shift register record
+// the cycle they were started at and their state is computed from the
+// attached cycle counter whenever a register or the IRQ line is looked at.
+class W65C22 : public IO_Device {
+   public:
+    // Register offsets (RS0-RS3)
+    enum Reg : byte {
+        ORB = 0x0,    // Output / input register B
+        ORA = 0x1,    // Output / input register A
+        DDRB = 0x2,   // Data direction register B
+        DDRA = 0x3,   // Data direction register A
+        T1CL = 0x4,   // Timer 1 counter, low byte
+        T1CH = 0x5,   // Timer 1 counter, high byte
+        T1LL = 0x6,   // Timer 1 latch, low byte
+        T1LH = 0x7,   // Timer 1 latch, high byte
+        T2CL = 0x8,   // Timer 2 counter, low byte
+        T2CH = 0x9,   // Timer 2 counter, high byte
+        SR = 0xA,     // Shift register
+        ACR = 0xB,    // Auxiliary control register
+        PCR = 0xC,    // Peripheral control register
+        IFR = 0xD,    // Interrupt flag register
+        IER = 0xE,    // Interrupt enable register
+        ORA_NH = 0xF  // Output / input register A, no handshake
+    };
+
+    // Interrupt flag / enable bits
+    enum Irq : byte {
+        IRQ_CA2 = 0x01,
+        IRQ_CA1 = 0x02,
+        IRQ_SR = 0x04,
+        IRQ_CB2 = 0x08,
+        IRQ_CB1 = 0x10,
+        IRQ_T2 = 0x20,
+        IRQ_T1 = 0x40,
+        IRQ_ANY = 0x80
+    };
+
+   private:
+    // Port registers
+    byte ora = 0, orb = 0;    // Output registers
+    byte ddra = 0, ddrb = 0;  // Data direction registers (1 = output)
+    byte acr = 0, pcr = 0;    // Control registers
+    byte ifr = 0, ier = 0;    // Interrupt flags / enables (bit 7 is derived)
+
+    // Timer 1, the counter held `t1_value` at cycle `t1_loaded` and
+    // counts down by one every cycle from there
+    word t1_latch = 0;        // Reload value
+    word t1_value = 0;        // Counter value at `t1_loaded`
+    uint64_t t1_loaded = 0;   // Cycle the counter was last loaded
+    uint64_t t1_fire = 0;     // Next cycle the counter rolls over to 0xFFFF
+    bool t1_armed = false;    // Whether that roll over sets the T1 flag
+    uint64_t t1_toggles = 0;  // Roll overs since the last load, drives PB7
+
+    // Timer 2, same scheme as timer 1 in timed mode
+    byte t2_latch = 0;        // Low byte latch (the high byte goes straight in)
+    word t2_value = 0;        // Counter value at `t2_loaded`
+    uint64_t t2_loaded = 0;   // Cycle the counter was last loaded
+    bool t2_armed = false;    // Whether the next time-out sets the T2 flag
+    word t2_pulses = 0;       // Counter value in PB6 pulse counting mode
+
+    // Shift register
+    byte sr = 0;              // Shift register contents
+    uint64_t sr_shifted = 8;  // Bits shifted since the last SR access (>= 8 is idle)
+    uint64_t sr_started = 0;  // Cycle the current shift started
+
+    // Handshake / control lines, the last level seen for edge detection
+    bool ca1 = true, ca2 = true, cb1 = true, cb2 = true;
+    byte pins_a = 0xFF, pins_b = 0xFF;  // Input levels when no listener is attached
+
+    ViaPortListener* listener = nullptr;
+
+    // Bring the timers and the shift register up to `now`
+    void sync(uint64_t now);
+
+    // Cycles per shifted bit in the current shift mode (0 for external clock)
+    uint64_t shift_period() const;
+
+    // Current counter values
+    word t1_counter(uint64_t now) const;
+    word t2_counter(uint64_t now) const;
+
+    // Level of PB7 when timer 1 drives it (ACR bit 7)
+    bool pb7() const;
+
+    // Levels currently on the port pins
+    byte read_port_a();
+    byte read_port_b();
+
+    // Notify the listener of new output levels
+    void drive_port(ViaPort port);
+
+    // Handle a transition on one of the handshake inputs
+    void edge(bool& line, bool level, byte flag, bool positive);
+
+    // Accessing ORA/ORB clears the handshake flags of that port
+    void clear_port_flags(ViaPort port);
+
+    // Bit 2 of the CA2 / CB2 control field selects "independent interrupt"
+    bool ca2_independent() const { return (pcr & 0x0A) == 0x02; }
+    bool cb2_independent() const { return (pcr & 0xA0) == 0x20; }
+
+    // Restart the shift register after an SR access
+    void restart_shift(uint64_t now);
+
+   public:
+    W65C22() = default;
+
+    // Connect a peripheral to the ports
+    void attach_listener(ViaPortListener* l) { listener = l; }
+
+    // Drive the handshake lines from outside
+    void set_ca1(bool level);
+    void set_ca2(bool level);
+    void set_cb1(bool level);
+    void set_cb2(bool level);
+
+    // Count a negative pulse on PB6 (timer 2 pulse counting mode)
+    void pulse_pb6();
+
+    // Level on the port pins when no listener provides one
+    void set_port_input(ViaPort port, byte levels);
+
+    // Reset all registers (the RESB line of the chip)
+    void reset();
+
+    // IO_Device interface
+    byte io_read(word reg) override;
+    void io_write(word reg, byte data) override;
+    bool irq_asserted() override;
+    uint64_t next_event() override;
+};
+
+#endif  // W65C22 VIA interface
@@ -0,0 +1,128 @@
+#ifndef W65C51_H
+#define W65C51_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "io_device.h"
+#include "ring_buffer.h"
+#include "types.h"
+
+// W65C51 Asynchronous Communications Interface Adapter (serial port)
+//
+// Bytes written by firmware go into a lock-free TX ring and bytes from
+// the host come out of an RX ring. A bridge thread moves them between
+// the rings and a host file descriptor (stdin/stdout, a pseudo-terminal
+// or a UNIX socket) in batches, so the CPU thread never makes a syscall.
+//
+// With throttling on (the default) a character occupies the line for
+// as many CPU cycles as it would at the programmed baud rate, derived
+// from the cycle counter. Unthrottled, the line is always ready.
+class W65C51 : public IO_Device {
+   public:
+    // Register offsets (RS0-RS1)
+    enum Reg : byte {
+        DATA = 0x0,     // Transmit (write) / receive (read) data
+        STATUS = 0x1,   // Status (read) / programmed reset (write)
+        COMMAND = 0x2,  // Command register
+        CONTROL = 0x3   // Control register
+    };
+
+    // Status register bits
+    enum Status : byte {
+        STATUS_PARITY = 0x01,   // Parity error
+        STATUS_FRAMING = 0x02,  // Framing error
+        STATUS_OVERRUN = 0x04,  // Receiver overrun
+        STATUS_RDRF = 0x08,     // Receiver data register full
+        STATUS_TDRE = 0x10,     // Transmitter data register empty
+        STATUS_DCDB = 0x20,     // Data carrier detect (active low)
+        STATUS_DSRB = 0x40,     // Data set ready (active low)
+        STATUS_IRQ = 0x80       // Interrupt pending
+    };
+
+   private:
+    byte command = 0x00;  // Command register
+    byte control = 0x00;  // Control register
+
+    byte rx_data = 0x00;      // Receive data register
+    bool rx_full = false;     // RDRF
+    uint64_t rx_next = 0;     // Cycle the next character can finish arriving
+    bool tx_busy = false;     // A character is still being shifted out
+    uint64_t tx_free_at = 0;  // Cycle the transmitter finishes the current character
+    bool tx_irq = false;      // Transmitter went empty since the last status read
+
+    double clock_hz;       // CPU clock the cycle counter runs at
+    bool throttle = true;  // Pace characters at the programmed baud rate
+
+    RingBuffer<byte, 4096> tx_ring;  // Firmware -> host
+    RingBuffer<byte, 4096> rx_ring;  // Host -> firmware
+
+    // Host side bridge
+    int host_in = -1;                         // Descriptor the bridge reads RX bytes from
+    int host_out = -1;                        // Descriptor the bridge writes TX bytes to
+    int listen_fd = -1;                       // Listening UNIX socket (socket mode only)
+    std::string socket_path;                  // Path to unlink on close (socket mode only)
+    bool restore_tty = false;                 // Whether stdin's terminal settings must be restored
+    std::thread bridge_thread;                // Moves bytes between the rings and the host
+    std::atomic<bool> bridge_running{false};  // Keeps the bridge thread alive
+
+    // CPU cycles one character occupies the line at the programmed rate
+    uint64_t char_cycles() const;
+
+    // Move a received character into the data register when it is due
+    void sync(uint64_t now);
+
+    // Transmit one character (also used for receiver echo)
+    void transmit(byte data, uint64_t now);
+
+    // Start the bridge thread on the given descriptors
+    bool start_bridge(int in_fd, int out_fd);
+
+    // Bridge thread body
+    void bridge_loop();
+
+   public:
+    // `cpu_clock_hz` converts baud rates into CPU cycles
+    W65C51(double cpu_clock_hz = 1000000.0) : clock_hz(cpu_clock_hz) {}
+    ~W65C51();
+
+    W65C51(const W65C51&) = delete;
+    W65C51& operator=(const W65C51&) = delete;
+
+    // Pace characters at the programmed baud rate (true) or never
+    // make the firmware wait (false)
+    void set_throttle(bool enabled) { throttle = enabled; }
+
+    // Bridge the serial line to the emulator's own stdin / stdout
+    // (stdin is switched to raw mode while attached to a terminal)
+    bool open_stdio();
+
+    // Bridge the serial line to a new pseudo-terminal, `slave_name`
+    // receives the path to open with a terminal program (e.g. /dev/pts/3)
+    bool open_pty(std::string* slave_name);
+
+    // Bridge the serial line to a UNIX socket listening at `path`
+    // (one client at a time, e.g. `socat - UNIX-CONNECT:path`)
+    bool open_unix_socket(const std::string& path);
+
+    // Stop the bridge and close the host side
+    void close_host();
+
+    // Feed bytes into the receiver / drain the transmitter directly,
+    // for embedding without a bridge (same thread rules as the rings)
+    bool host_send(byte data) { return rx_ring.push(data); }
+    bool host_receive(byte& data) { return tx_ring.pop(data); }
+
+    // Programmed reset (also what a write to the status register does)
+    void reset();
+
+    // IO_Device interface
+    byte io_read(word reg) override;
+    void io_write(word reg, byte data) override;
+    bool irq_asserted() override;
+    uint64_t next_event() override;
+};
+
+#endif  // W65C51 ACIA interface
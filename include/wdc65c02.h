@@ -1,22 +1,150 @@
 #ifndef WDC65C02_H
 #define WDC65C02_H
 
+#include <vector>
+
 #include "bus.h"
 #include "decoder.h"
+#include "io_device.h"
+#include "metrics.h"
 #include "types.h"
 
+class Coverage;
+class Debugger;
+class PinChecker;
+class SharedMonitor;
+struct Microcode;
+enum class BusStep : byte;
+
+// One bus cycle of the CPU, as seen on its pins
+struct BusCycle {
+    word addr;
+    byte data;
+    bool write;  // RWB low
+    bool sync;   // SYNC high, an opcode fetch
+};
+
 class WDC65C02 {
    private:
     byte registers[3];            // Index registers
     Bus& bus;                     // Reference to the bus for memory access
     AddressDecoder* decoder_ptr;  // Pointer to the address decoder for memory access
 
+    std::vector<IO_Device*> irq_sources;  // Devices whose IRQ outputs are wired to IRQB
+    bool nmi_line = true;                 // Level of NMIB at the previous instruction boundary
+
+    Debugger* debugger = nullptr;       // Breakpoints checked before every opcode fetch
+    Coverage* coverage = nullptr;       // Marked on every fetch and data access
+    PinChecker* pin_checker = nullptr;  // Sees every fetch and data access
+    SharedMonitor* monitor = nullptr;   // Registers published at every instruction boundary
+    uint64_t metered_cycles = 0;        // `cycles` when they were last added to the metrics
+
+    // Idle loop detection (see `set_idle_skip`)
+    struct IdleLoop {
+        word head = 0;        // Target of the last backward jump or branch
+        uint64_t cycles = 0;  // Cycle count when it was reached
+        uint64_t writes = 0;  // Write count when it was reached
+        uint64_t event = 0;   // Next device event seen from there, 0 until the loop repeats once
+        byte A = 0, X = 0, Y = 0, SP = 0, FLAGS = 0;
+        bool valid = false;
+    } idle;
+
+    bool idle_skip = false;          // Fast-forward idle loops and WAI
+    uint64_t idle_quantum = 100000;  // Most cycles skipped by one `step()`
+    uint64_t writes = 0;             // Bus writes so far, a loop that writes isn't idle
+    bool waiting = false;            // Stopped by WAI until an interrupt arrives
+
+    // Cycle mode (see `set_cycle_mode`)
+    struct BusSequence {
+        const Microcode* code = nullptr;  // Steps being run, nullptr at an instruction boundary
+        byte index = 0;                   // Next step of `code`
+        word opcode_addr = 0;             // Address of the instruction's opcode
+        byte opcode = 0;
+        word operand = 0;
+        word pointer = 0;  // Address of a JMP pointer
+        word vector = 0;   // Interrupt vector
+        byte data = 0;     // Byte read by the previous step
+    } sequence;
+
+    bool cycle_mode = false;            // `tick()` runs one bus cycle instead of a whole instruction
+    bool cycle_mode_requested = false;  // Mode to switch to at the next instruction boundary
+    BusCycle last_cycle = {};           // Last cycle run in cycle mode
+
+    // Sample the interrupt lines, returns the vector of the interrupt that
+    // is due or 0
+    word due_interrupt();
+
+    // Publish the registers and counters to `monitor`
+    void publish_state();
+
+    // Add the cycles run since the last call to the metrics, when they're
+    // on. Called after every instruction either way, so switching metrics
+    // on doesn't count the cycles that ran before.
+    void meter_cycles() {
+        if (metrics::enabled.load(std::memory_order_relaxed) && cycles > metered_cycles) {
+            metrics::add(metrics::CYCLES, cycles - metered_cycles);
+        }
+        metered_cycles = cycles;
+    }
+
+    // Let the bus master that wins arbitration run, with RDY held low and
+    // its cycles added to `cycles`
+    void yield_bus();
+
+    // Push the PC and status and jump through `vector`
+    void interrupt(word vector);
+
+    // Relative branch, one extra cycle when taken and one more when the
+    // target is on another page
+    void branch(bool taken, byte offset);
+
+    // ADC / SBC of `value` into A, decimal mode is table driven. Its extra
+    // cycle is left to the caller, which knows where it falls on the bus
+    void add_with_carry(byte value);
+    void subtract_with_carry(byte value);
+
+    // Cycle mode (lib/wdc65c02_cycles.cpp)
+    //
+    // At an instruction boundary: start the interrupt sequence, wait for
+    // WAI, stop on a breakpoint or start the opcode fetch
+    void begin_sequence();
+    // Whether a conditional step is left out this time
+    bool skipped(BusStep step) const;
+    // Run one bus cycle of the sequence
+    void run_bus_step(BusStep step);
+    // Register effects of the instruction once its last cycle is done
+    void finish_instruction();
+    // Internal cycle, a read whose byte is discarded
+    byte dummy_read(word addr);
+    // Put the cycle on the pins and in `last_cycle`
+    void drive_pins(word addr, byte data, bool write);
+    // `step()` in cycle mode
+    void step_cycles();
+    // `step()` without publishing to the monitor
+    void step_instruction();
+
+    // Earliest `next_event()` of the mapped modules and IRQ sources
+    uint64_t next_device_event();
+
+    // Cycle up to which nothing outside the CPU changes on its own: the
+    // next device event, capped by `idle_quantum` and `skip_limit`
+    uint64_t idle_target(uint64_t event);
+
+    // Called after a backward jump to `PC`, skips whole iterations of the
+    // loop once one of them is known to change nothing
+    void check_idle_loop();
+
    public:
     CPU_State state;  // Current state of the CPU
 
     word PC;  // Program counter register
     byte SP;  // Stack pointer register (stores the lower 8-bit)
 
+    uint64_t cycles;  // Clock cycles executed since power on (one per bus access)
+
+    uint64_t skipped_cycles = 0;       // Part of `cycles` fast-forwarded over idle loops and WAI
+    uint64_t skip_limit = UINT64_MAX;  // Idle skipping never moves `cycles` past this
+
     // Register references for easier access
     byte& A = registers[static_cast<byte>(Register::A)];
     byte& X = registers[static_cast<byte>(Register::X)];
@@ -28,14 +156,15 @@ class WDC65C02 {
     union {
         byte FLAGS;  // Status flags byte
         struct {
-            byte FLAGS_N : 1;  // Negative Flag (bit 7)
-            byte FLAGS_V : 1;  // Overflow Flag (bit 6)
-            byte FLAGS_U : 1;  // Unused/expansion (bit 5)
-            byte FLAGS_B : 1;  // Break Flag (bit 4)
-            byte FLAGS_D : 1;  // Decimal Mode Flag (bit 3)
-            byte FLAGS_I : 1;  // Interrupt Disable Flag (bit 2)
-            byte FLAGS_Z : 1;  // Zero Flag (bit 1)
+            // Bit-fields are allocated from the least significant bit
             byte FLAGS_C : 1;  // Carry Flag (bit 0)
+            byte FLAGS_Z : 1;  // Zero Flag (bit 1)
+            byte FLAGS_I : 1;  // Interrupt Disable Flag (bit 2)
+            byte FLAGS_D : 1;  // Decimal Mode Flag (bit 3)
+            byte FLAGS_B : 1;  // Break Flag (bit 4)
+            byte FLAGS_U : 1;  // Unused/expansion (bit 5)
+            byte FLAGS_V : 1;  // Overflow Flag (bit 6)
+            byte FLAGS_N : 1;  // Negative Flag (bit 7)
         };
     };
 
@@ -135,8 +264,14 @@ class WDC65C02 {
     //  - This will sync with the clock pulse which it gets from the pin `PHI0`
     void execute();
 
+    // Execute one instruction when the clock on `PHI0` allows it
     void execute_instruction();
 
+    // Execute exactly one instruction, ignoring the clock pins
+    //
+    // Note: `cycles` is advanced by the number of clock cycles it took
+    void step();
+
     // To fetch the next 16-bits from the memory
     // (consumes cycles)
     word fetch_word();
@@ -151,6 +286,16 @@ class WDC65C02 {
     // (doesn't consume cycles)
     byte read_byte();
 
+    // Push a byte on the stack (consumes a cycle)
+    void push(byte val);
+    // Pull a byte from the stack (consumes a cycle)
+    byte pull();
+
+    // Read a byte of data from memory (consumes a cycle)
+    byte read_mem(word addr);
+    // Write a byte of data to memory (consumes a cycle)
+    void write_mem(word addr, byte val);
+
     // Always return the SP added with the page value
     // because the SP only stores the lower 8 bit of the
     // current address space
@@ -161,6 +306,78 @@ class WDC65C02 {
 
     // Set address decoder for memory access
     void set_decoder(AddressDecoder* decoder);
+
+    // Wire the IRQ output of a device to IRQB
+    //
+    // Note:
+    //  - All attached outputs are wired-OR'd and sampled at every
+    //    instruction boundary
+    //  - The device is also driven from this CPU's cycle counter
+    void attach_irq_source(IO_Device* device);
+
+    // Check breakpoints before every instruction (done by the `Debugger`
+    // constructor), nullptr detaches
+    void attach_debugger(Debugger* debugger) { this->debugger = debugger; }
+
+    // Record code and data coverage, nullptr detaches
+    void attach_coverage(Coverage* coverage) { this->coverage = coverage; }
+
+    // Repeat a sample of the memory accesses through the chips' pins,
+    // nullptr detaches
+    void attach_pin_checker(PinChecker* checker) { this->pin_checker = checker; }
+
+    // Publish the registers and counters to a shared memory monitor, right
+    // away and after every instruction, nullptr detaches
+    void attach_monitor(SharedMonitor* monitor);
+
+    // Fast-forward over loops that only wait for something external
+    //
+    // Note:
+    //  - A loop is idle once one iteration, from a backward jump back to
+    //    the same target, leaves the registers and flags as they were and
+    //    writes nothing (`JMP *`, `BRA *`, polling a status register).
+    //    Every further iteration is then identical until a device changes
+    //    state, so whole iterations are added to `cycles` up to the next
+    //    device event (at most `quantum` cycles per `step()`), and the
+    //    loop runs normally across the event itself
+    //  - WAI likewise jumps straight to the next device event
+    //  - Reads inside the loop may have side effects on devices (clearing
+    //    a flag), those repeat identically between events
+    //  - `cycles` ends up exactly where interpreting every iteration
+    //    would have put it, `skipped_cycles` counts the skipped part
+    void set_idle_skip(bool enabled, uint64_t quantum = 100000);
+
+    // Forget the loop being watched, for when registers or memory were
+    // changed from outside the emulation (e.g. by a debugger)
+    void reset_idle_detection() { idle.valid = false; }
+
+    // Whether the CPU is stopped by WAI
+    bool is_waiting() const { return waiting; }
+
+    // Run instructions one bus cycle at a time
+    //
+    // Note:
+    //  - Every cycle of an instruction, internal ones included, is a bus
+    //    access whose address, data and RWB are driven on the pins, in the
+    //    order the 65C02 makes them (see `microcode.h`). SYNC is reported
+    //    in `last_bus_cycle()` only
+    //  - The switch happens at the next instruction boundary, right away
+    //    when the CPU is at one
+    //  - `tick()` runs single cycles, `step()` still runs whole
+    //    instructions. Registers, memory and `cycles` end up as in the
+    //    instruction mode
+    //  - Idle loops and WAI aren't fast-forwarded in cycle mode
+    void set_cycle_mode(bool enabled);
+    bool in_cycle_mode() const { return cycle_mode; }
+
+    // Whether no instruction is partly done
+    bool at_instruction_boundary() const { return sequence.code == nullptr; }
+
+    // Run one bus cycle in cycle mode, one instruction otherwise
+    void tick();
+
+    // The last cycle run in cycle mode
+    const BusCycle& last_bus_cycle() const { return last_cycle; }
 };
 
 #endif  // WDC65C02 CPU interface
@@ -1,15 +1,302 @@
 #include "at28c256.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
 #include <thread>
 
 #include "log.h"
+#include "metrics.h"
 
 // Static thread management variables
 static std::thread eeprom_thread;
 static std::atomic<bool> eeprom_running{false};
 
+static constexpr size_t EEPROM_SIZE = 32 * 1024;
+
+AT28C256::AT28C256(Bus& bus) : memory(storage), bus(bus) {
+    // Initialize memory to 0xFF (unprogrammed state)
+    std::memset(storage, 0xFF, sizeof(storage));
+}
+
+AT28C256::AT28C256(Bus& bus, const std::string& image_path, RomMapping mode) : memory(storage), bus(bus) {
+    if (!map_image(image_path, mode)) {
+        throw std::runtime_error("Failed to map EEPROM image: " + image_path);
+    }
+}
+
+AT28C256::~AT28C256() {
+    unmap_image();
+}
+
+bool AT28C256::map_image(const std::string& path, RomMapping mode) {
+    bool read_only = (mode == RomMapping::SHARED_READONLY);
+    bool persistent = (mode == RomMapping::PERSISTENT);
+
+    // Others read external storage (`use_storage`), so the image is copied
+    // into it rather than mapped over it
+    bool copy = backing != storage;
+    if (persistent && copy) {
+        logger::error("Cannot keep a persistent EEPROM image " + path + " in external storage");
+        return false;
+    }
+
+    // A persistent image is created on first use, like a freshly erased chip
+    int fd = persistent ? open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)
+                        : open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        logger::error("Cannot open EEPROM image " + path + ": " + std::strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        logger::error("Cannot stat EEPROM image " + path + ": " + std::strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    unmap_image();
+
+    if (persistent && static_cast<size_t>(st.st_size) < EEPROM_SIZE) {
+        // Grow the file to a full chip, padding with erased cells (0xFF)
+        // rather than the zeros ftruncate() would give us
+        size_t pad = EEPROM_SIZE - st.st_size;
+        std::memset(storage, 0xFF, pad);
+        if (pwrite(fd, storage, pad, st.st_size) != static_cast<ssize_t>(pad)) {
+            logger::error("Cannot extend EEPROM image " + path + ": " + std::strerror(errno));
+            close(fd);
+            return false;
+        }
+        st.st_size = EEPROM_SIZE;
+    }
+
+    if (static_cast<size_t>(st.st_size) > EEPROM_SIZE) {
+        logger::warning("EEPROM image " + path + " is larger than 32KB, using the first 32KB only");
+    }
+
+    if (copy || static_cast<size_t>(st.st_size) < EEPROM_SIZE) {
+        // Mapping past the end of the file would fault, so short images
+        // are read into the array and padded like erased cells
+        ssize_t size = std::min<ssize_t>(st.st_size, EEPROM_SIZE);
+        ssize_t got = pread(fd, backing, size, 0);
+        close(fd);
+        if (got != size) {
+            logger::error("Short read from EEPROM image " + path);
+            std::memset(backing, 0xFF, EEPROM_SIZE);
+            return false;
+        }
+        std::memset(backing + got, 0xFF, EEPROM_SIZE - got);
+        writable = !read_only;
+        return true;
+    }
+
+    int prot = read_only ? PROT_READ : (PROT_READ | PROT_WRITE);
+    int flags = (read_only || persistent) ? MAP_SHARED : MAP_PRIVATE;
+    void* addr = mmap(nullptr, EEPROM_SIZE, prot, flags, fd, 0);
+    close(fd);  // The mapping keeps its own reference to the file
+    if (addr == MAP_FAILED) {
+        logger::error("Cannot map EEPROM image " + path + ": " + std::strerror(errno));
+        return false;
+    }
+
+    // Firmware jumps around, readahead would only fault in pages nobody executes
+    madvise(addr, EEPROM_SIZE, MADV_RANDOM);
+
+    mapping = static_cast<byte*>(addr);
+    mapping_size = EEPROM_SIZE;
+    memory = mapping;
+    writable = !read_only;
+    this->persistent = persistent;
+    dirty_lo = EEPROM_SIZE;
+    dirty_hi = 0;
+    last_sync = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool AT28C256::sync(bool wait) {
+    if (!persistent || dirty_lo > dirty_hi) return true;  // Nothing to flush
+
+    // msync() wants a page aligned start, only the touched pages are flushed
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t start = (dirty_lo / page) * page;
+    size_t length = dirty_hi + 1 - start;
+
+    dirty_lo = EEPROM_SIZE;
+    dirty_hi = 0;
+    last_sync = std::chrono::steady_clock::now();
+
+    if (msync(mapping + start, length, wait ? MS_SYNC : MS_ASYNC) != 0) {
+        logger::error(std::string("Failed to sync EEPROM image: ") + std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void AT28C256::set_sync_interval(std::chrono::milliseconds interval) {
+    sync_interval = interval;
+}
+
+void AT28C256::mark_dirty(size_t lo, size_t hi) {
+    if (lo < dirty_lo) dirty_lo = lo;
+    if (hi > dirty_hi) dirty_hi = hi;
+    if (sync_interval.count() > 0 && std::chrono::steady_clock::now() - last_sync >= sync_interval) {
+        sync(false);
+    }
+}
+
+void AT28C256::unmap_image() {
+    if (mapping == nullptr) return;
+
+    // Let a page write that is still in flight land in the image
+    if (phase != WritePhase::IDLE) commit_page();
+
+    // Make sure everything the firmware wrote reaches the disk
+    sync(true);
+    persistent = false;
+
+    munmap(mapping, mapping_size);
+    mapping = nullptr;
+    mapping_size = 0;
+
+    // Fall back to an erased internal array
+    std::memset(backing, 0xFF, EEPROM_SIZE);
+    memory = backing;
+    writable = true;
+}
+
+bool AT28C256::use_storage(byte* external) {
+    if (mapping != nullptr) {
+        logger::error("Cannot move a mapped EEPROM image, move the storage before mapping it");
+        return false;
+    }
+
+    // Let a page write that is still in flight land first
+    if (phase != WritePhase::IDLE) commit_page();
+
+    byte* target = external ? external : storage;
+    if (target != memory) std::memcpy(target, memory, EEPROM_SIZE);
+
+    backing = target;
+    memory = target;
+    return true;
+}
+
+void AT28C256::load(const byte* data, size_t size, word offset) {
+    if (offset >= EEPROM_SIZE) return;
+    if (size > EEPROM_SIZE - offset) size = EEPROM_SIZE - offset;
+    if (!writable) {
+        logger::error("Cannot load data into a read-only EEPROM image");
+        return;
+    }
+    std::memcpy(memory + offset, data, size);
+    if (persistent && size > 0) mark_dirty(offset, offset + size - 1);
+}
+
+void AT28C256::store(word addr, byte data) {
+    if (!writable) return;  // Shared read-only image, the write is ignored
+    memory[addr] = data;
+    if (persistent) mark_dirty(addr, addr);
+}
+
+void AT28C256::attach_cycle_counter(uint64_t* counter, double clock_hz) {
+    // Finish anything in flight with the old clock before switching
+    if (phase != WritePhase::IDLE) commit_page();
+
+    cycle_counter = counter;
+
+    // Datasheet timings: tBLC = 150us, tWC = 10ms
+    byte_load_cycles = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clock_hz * 150e-6)));
+    write_cycles = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clock_hz * 10e-3)));
+}
+
+void AT28C256::commit_page() {
+    for (int i = 0; i < 64; ++i) {
+        if (page_mask & (1ULL << i)) store(page_base + i, page_buffer[i]);
+    }
+    phase = WritePhase::IDLE;
+    page_mask = 0;
+}
+
+bool AT28C256::is_busy() {
+    if (cycle_counter == nullptr) return false;
+    advance(*cycle_counter);
+    return phase != WritePhase::IDLE;
+}
+
+uint64_t AT28C256::next_event() {
+    if (cycle_counter == nullptr) return UINT64_MAX;
+    advance(*cycle_counter);
+    if (phase == WritePhase::LOADING) return load_deadline;
+    if (phase == WritePhase::WRITING) return busy_until;
+    return UINT64_MAX;
+}
+
+void AT28C256::advance(uint64_t now) {
+    if (phase == WritePhase::LOADING && now >= load_deadline) {
+        // No further byte arrived in time, the internal write cycle starts
+        phase = WritePhase::WRITING;
+        busy_until = load_deadline + write_cycles;
+    }
+
+    if (phase == WritePhase::WRITING && now >= busy_until) {
+        // Write cycle done, the page buffer is committed to the array
+        commit_page();
+    }
+}
+
+void AT28C256::latch(word addr, byte data) {
+    if (cycle_counter == nullptr) {
+        store(addr, data);  // No clock attached, writes are instant
+        return;
+    }
+    if (!writable) return;
+
+    uint64_t now = *cycle_counter;
+    advance(now);
+
+    // Writes are ignored while the internal write cycle runs
+    if (phase == WritePhase::WRITING) return;
+
+    // The page (A6-A14) is latched by the first write of a page write,
+    // the datasheet requires it to stay the same for the following bytes
+    if (phase == WritePhase::IDLE) {
+        phase = WritePhase::LOADING;
+        page_base = addr & ~0x3F;
+    }
+
+    page_buffer[addr & 0x3F] = data;
+    page_mask |= 1ULL << (addr & 0x3F);
+    last_written = data;
+    load_deadline = now + byte_load_cycles;
+}
+
+byte AT28C256::fetch(word addr) {
+    if (cycle_counter == nullptr || phase == WritePhase::IDLE) return memory[addr];
+
+    uint64_t now = *cycle_counter;
+    advance(now);
+    if (phase == WritePhase::IDLE) return memory[addr];
+
+    if (phase == WritePhase::LOADING) {
+        // A read ends the byte load phase, the write cycle starts right away
+        phase = WritePhase::WRITING;
+        busy_until = now + write_cycles;
+    }
+
+    // DATA polling: I/O7 reads back inverted, toggle bit: I/O6 flips
+    toggle = !toggle;
+    return (~last_written & 0x80) | (toggle ? 0x40 : 0x00) | (last_written & 0x3F);
+}
+
 void AT28C256::read_from_bus() {
     // Check if chip is enabled (CE is active low)
     if (CE != 0) return;
@@ -53,7 +340,7 @@ void AT28C256::read_from_bus() {
     data |= (IO_7 ? 1 : 0) << 7;
 
     // Store the data in memory
-    memory[address] = data;
+    latch(address, data);
 }
 
 void AT28C256::write_to_bus() {
@@ -88,7 +375,7 @@ void AT28C256::write_to_bus() {
     if (address >= 32 * 1024) return;
 
     // Get data from memory
-    byte data = memory[address];
+    byte data = fetch(address);
 
     // Set the data pins
     IO_0 = (data & 0x01) != 0;
@@ -113,28 +400,37 @@ word AT28C256::read_word(word addr) {
     if (addr >= 32 * 1024) {
         return 0xFFFF;  // Out of bounds
     }
-    return memory[addr];
+    return fetch(addr);
 }
 
 byte AT28C256::read_byte(byte addr) {
     if (addr >= 32 * 1024U) {
         return 0xFF;  // Out of bounds
     }
-    return memory[addr];
+    return fetch(addr);
 }
 
 void AT28C256::write_word(word addr, word data) {
     if (addr >= 32 * 1024U) {
         return;  // Out of bounds
     }
-    memory[addr] = data & 0xFF;  // Only write the lower 8 bits
+    latch(addr, data & 0xFF);  // Only write the lower 8 bits
 }
 
 void AT28C256::write_byte(byte addr, byte data) {
     if (addr >= 256U) {
         return;  // Out of bounds
     }
-    memory[addr] = data;
+    latch(addr, data);
+}
+
+const byte* AT28C256::read_span(word offset, size_t& length) {
+    // Reads during a write cycle return status bits, not memory
+    if (offset >= 32 * 1024U || is_busy()) {
+        return nullptr;
+    }
+    length = 32 * 1024 - offset;
+    return memory + offset;
 }
 
 void AT28C256::attach_to_bus(Bus& new_bus) {
@@ -162,6 +458,8 @@ void AT28C256::start_monitoring() {
         bool prev_oe = OE;
 
         while (eeprom_running.load()) {
+            if (metrics::enabled.load(std::memory_order_relaxed)) metrics::add(metrics::MONITOR_WAKEUPS);
+
             // Only process if pins have changed or chip is active
             // Monitor for pin changes
             bool pins_changed = (prev_ce != CE || prev_we != WE || prev_oe != OE);
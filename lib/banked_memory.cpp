@@ -0,0 +1,54 @@
+#include "banked_memory.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+static void check_bank_size(uint32_t bank_size) {
+    // Windows are addressed with a 16 bit offset mask
+    if (bank_size == 0 || bank_size > 0x10000 || (bank_size & (bank_size - 1)) != 0) {
+        throw std::invalid_argument("Bank size must be a power of two up to 64KB");
+    }
+}
+
+BankedMemory::BankedMemory(uint32_t size, uint32_t bank_size, bool writable)
+    : storage(std::max(size, bank_size), writable ? 0x00 : 0xFF), bank_size(bank_size), writable(writable) {
+    check_bank_size(bank_size);
+}
+
+BankedMemory::BankedMemory(const std::string& image_path, uint32_t bank_size)
+    : bank_size(bank_size), writable(false) {
+    check_bank_size(bank_size);
+
+    std::ifstream file(image_path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open banked ROM image: " + image_path);
+    }
+    storage.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    // Pad to a whole number of banks
+    size_t banks = std::max<size_t>(1, (storage.size() + bank_size - 1) / bank_size);
+    storage.resize(banks * bank_size, 0xFF);
+}
+
+void BankedMemory::load(const byte* data, size_t size, uint32_t offset) {
+    if (offset >= storage.size()) return;
+    std::memcpy(storage.data() + offset, data, std::min(size, storage.size() - offset));
+}
+
+BankWindow::BankWindow(BankedMemory& memory, byte bank)
+    : memory(memory), mask(memory.get_bank_size() - 1) {
+    select(bank);
+}
+
+byte BankRegister::io_read(word reg) {
+    if (reg >= windows.size()) return 0xFF;
+    return windows[reg]->selected_bank();
+}
+
+void BankRegister::io_write(word reg, byte data) {
+    if (reg >= windows.size()) return;
+    windows[reg]->select(data);
+}
@@ -0,0 +1,486 @@
+#include "batch_cpu.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "bcd.h"
+#include "instructions.h"
+#include "op_codes.h"
+
+// The lanes of a block as GCC / Clang vector types. On x86 `step_block`
+// is built twice, for AVX2 and for the SSE2 baseline, and the loader
+// picks one for the host. Elsewhere the compiler lowers the vectors to
+// whatever the target has, down to plain scalar code.
+typedef byte Bytes __attribute__((vector_size(BatchCPU::BLOCK)));
+typedef int8_t SignedBytes __attribute__((vector_size(BatchCPU::BLOCK)));
+typedef word Words __attribute__((vector_size(BatchCPU::BLOCK * 2)));
+typedef int16_t SignedWords __attribute__((vector_size(BatchCPU::BLOCK * 2)));
+typedef uint64_t Counters __attribute__((vector_size(BatchCPU::BLOCK * 8)));
+typedef int64_t SignedCounters __attribute__((vector_size(BatchCPU::BLOCK * 8)));
+
+// The helpers below return these vectors. They are forced inline, also at
+// -O0, so no call crosses from the AVX2 clone of `step_block` into code
+// built for the baseline, which passes the vectors differently.
+#pragma GCC diagnostic ignored "-Wpsabi"
+#define BATCH_INLINE inline __attribute__((always_inline))
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BATCH_TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define BATCH_TARGET_CLONES
+#endif
+
+static constexpr byte RUNNING = static_cast<byte>(CPU_State::RUNNING);
+static constexpr byte HALTED = static_cast<byte>(CPU_State::HALTED);
+
+template <typename V>
+static BATCH_INLINE V load(const void* from) {
+    V v;
+    std::memcpy(&v, from, sizeof v);
+    return v;
+}
+
+template <typename V>
+static BATCH_INLINE void store(void* to, const V& v) {
+    std::memcpy(to, &v, sizeof v);
+}
+
+// Lanes of `a` where `mask` is set, lanes of `b` elsewhere
+template <typename V>
+static BATCH_INLINE V select(const V& mask, const V& a, const V& b) {
+    return (a & mask) | (b & ~mask);
+}
+
+// Byte lane masks (0xFF / 0x00) to the wider lane types
+static BATCH_INLINE Words to_words(const Bytes& mask) {
+    return (Words)__builtin_convertvector((SignedBytes)mask, SignedWords);
+}
+
+static BATCH_INLINE Counters to_counters(const Bytes& mask) {
+    return (Counters)__builtin_convertvector((SignedBytes)mask, SignedCounters);
+}
+
+static BATCH_INLINE Bytes splat(byte value) {
+    Bytes v = {};
+    return v + value;
+}
+
+static BATCH_INLINE Words splat_word(word value) {
+    Words v = {};
+    return v + value;
+}
+
+// N and Z from `value`, as the loads and transfers set them
+static BATCH_INLINE Bytes set_nz(const Bytes& flags, const Bytes& value) {
+    return (flags & 0x7D) | (value & 0x80) | ((Bytes)(value == 0) & 0x02);
+}
+
+BatchCPU::BatchCPU(int lanes, uint32_t ram_size) : lane_count(lanes), ram_size(ram_size) {
+    if (lanes <= 0) throw std::invalid_argument("BatchCPU needs at least one lane");
+    if (ram_size > 0x10000) throw std::invalid_argument("BatchCPU RAM can't exceed 64K");
+
+    stride = (lanes + BLOCK - 1) / BLOCK * BLOCK;
+
+    PC.assign(stride, 0);
+    A.assign(stride, 0);
+    X.assign(stride, 0);
+    Y.assign(stride, 0);
+    SP.assign(stride, 0xFF);
+    FLAGS.assign(stride, 0x04);
+    cycles.assign(stride, 0);
+
+    // Padding lanes never run
+    states.assign(stride, HALTED);
+    std::fill(states.begin(), states.begin() + lanes, RUNNING);
+
+    ram.assign(static_cast<size_t>(ram_size) * stride, 0);
+    shared.assign(0x10000, 0xFF);
+}
+
+void BatchCPU::load_shared(word addr, const byte* data, size_t size) {
+    if (size > 0x10000u - addr) throw std::out_of_range("Shared image doesn't fit at that address");
+    std::memcpy(&shared[addr], data, size);
+}
+
+byte BatchCPU::read(int lane, word addr) const {
+    if (addr < ram_size) return ram[static_cast<size_t>(addr) * stride + lane];
+    return shared[addr];
+}
+
+void BatchCPU::write(int lane, word addr, byte value) {
+    // The shared image is read-only for the lanes
+    if (addr < ram_size) ram[static_cast<size_t>(addr) * stride + lane] = value;
+}
+
+BatchCPU::LaneState BatchCPU::lane(int lane) const {
+    LaneState s;
+    s.PC = PC[lane];
+    s.A = A[lane];
+    s.X = X[lane];
+    s.Y = Y[lane];
+    s.SP = SP[lane];
+    s.FLAGS = FLAGS[lane];
+    s.cycles = cycles[lane];
+    s.state = static_cast<CPU_State>(states[lane]);
+    return s;
+}
+
+void BatchCPU::set_lane(int lane, const LaneState& s) {
+    PC[lane] = s.PC;
+    A[lane] = s.A;
+    X[lane] = s.X;
+    Y[lane] = s.Y;
+    SP[lane] = s.SP;
+    FLAGS[lane] = s.FLAGS;
+    cycles[lane] = s.cycles;
+    states[lane] = static_cast<byte>(s.state);
+}
+
+void BatchCPU::reset() {
+    for (int lane = 0; lane < lane_count; ++lane) {
+        LaneState s;
+        s.PC = read(lane, 0xFFFC) | (read(lane, 0xFFFD) << 8);
+        set_lane(lane, s);
+    }
+}
+
+void BatchCPU::step() {
+    for (int block = 0; block < stride / BLOCK; ++block) step_block(block);
+}
+
+uint64_t BatchCPU::run(uint64_t max_steps) {
+    uint64_t steps = 0;
+    while (steps < max_steps && running_lanes() > 0) {
+        step();
+        steps++;
+    }
+    return steps;
+}
+
+int BatchCPU::running_lanes() const {
+    int count = 0;
+    for (int lane = 0; lane < lane_count; ++lane) count += states[lane] == RUNNING;
+    return count;
+}
+
+void BatchCPU::step_lane(int lane, byte opcode, word operand) {
+    const InstructionInfo& info = INSTRUCTIONS[opcode];
+    cycles[lane] += info.length;  // Opcode and operand fetches
+
+    switch (opcode) {
+        case static_cast<byte>(Op::JMPIX): {
+            // The pointer depends on the lane's X
+            cycles[lane] += 3;  // Internal cycle and the two pointer reads
+            word pointer = operand + X[lane];
+            PC[lane] = read(lane, pointer) | (read(lane, pointer + 1) << 8);
+            break;
+        }
+
+        case static_cast<byte>(Op::RTI): {
+            // Pulls from the lane's own stack
+            cycles[lane] += 5;  // Internal cycle, dummy stack read and three pulls
+            FLAGS[lane] = (read(lane, 0x0100 + ++SP[lane]) & ~0x10) | 0x20;
+            byte lo = read(lane, 0x0100 + ++SP[lane]);
+            byte hi = read(lane, 0x0100 + ++SP[lane]);
+            PC[lane] = (hi << 8) | lo;
+            break;
+        }
+
+        case static_cast<byte>(Op::ADC_IM):
+        case static_cast<byte>(Op::ADC_ZP):
+        case static_cast<byte>(Op::ADC_AB):
+        case static_cast<byte>(Op::SBC_IM):
+        case static_cast<byte>(Op::SBC_ZP):
+        case static_cast<byte>(Op::SBC_AB): {
+            // Decimal mode is a table lookup per lane
+            PC[lane] += info.length;
+            byte value = operand;
+            if (info.mode != AddrMode::IMM) {
+                cycles[lane]++;
+                value = read(lane, operand);
+            }
+
+            bool carry = FLAGS[lane] & 0x01;
+            bool subtract = info.mnemonic[0] == 'S';
+            AluResult result;
+            if (FLAGS[lane] & 0x08) {
+                uint32_t index = decimal_index(A[lane], value, carry);
+                result = subtract ? DECIMAL_SBC[index] : DECIMAL_ADC[index];
+                cycles[lane]++;
+            } else {
+                result = subtract ? binary_sbc(A[lane], value, carry) : binary_adc(A[lane], value, carry);
+            }
+            A[lane] = result.value;
+            FLAGS[lane] = (FLAGS[lane] & ~ALU_FLAGS) | result.flags;
+            break;
+        }
+
+        default:
+            states[lane] = HALTED;
+            break;
+    }
+}
+
+BATCH_TARGET_CLONES
+void BatchCPU::step_block(int block) {
+    const int base = block * BLOCK;
+
+    Bytes a = load<Bytes>(&A[base]);
+    Bytes x = load<Bytes>(&X[base]);
+    Bytes y = load<Bytes>(&Y[base]);
+    Bytes flags = load<Bytes>(&FLAGS[base]);
+    Bytes state = load<Bytes>(&states[base]);
+    Words pc = load<Words>(&PC[base]);
+    Counters cyc = load<Counters>(&cycles[base]);
+
+    // Lanes still to execute an instruction in this step
+    Bytes pending = (Bytes)(state == RUNNING);
+
+    // Each pass runs one group: the lanes at the PC of the first pending lane
+    for (;;) {
+        byte pending_lanes[BLOCK];
+        store(pending_lanes, pending);
+        int first = 0;
+        while (first < BLOCK && !pending_lanes[first]) first++;
+        if (first == BLOCK) break;
+
+        const word at = pc[first];
+        const int leader = base + first;
+
+        Bytes group;
+        if (at < ram_size) {
+            // Code in RAM can differ per lane, the leader runs alone
+            group = Bytes{};
+            group[first] = 0xFF;
+        } else {
+            group = (Bytes)__builtin_convertvector((SignedWords)(pc == at), SignedBytes) & pending;
+        }
+        pending &= ~group;
+
+        const byte opcode = read(leader, at);
+        const InstructionInfo& info = INSTRUCTIONS[opcode];
+        word operand = 0;
+        if (info.length == 2) {
+            operand = read(leader, at + 1);
+        } else if (info.length == 3) {
+            operand = read(leader, at + 1) | (read(leader, at + 2) << 8);
+        }
+
+        const Words group_words = to_words(group);
+        const word next = at + info.length;
+
+        // Row of `addr` across the block: the lanes' RAM or the shared byte
+        auto row = [&](word addr) __attribute__((always_inline)) -> Bytes {
+            if (addr < ram_size) return load<Bytes>(&ram[static_cast<size_t>(addr) * stride + base]);
+            return splat(shared[addr]);
+        };
+
+        uint64_t taken_cycles = 0;  // Extra cycles for the lanes in `taken`
+        Bytes taken = Bytes{};
+        uint64_t group_cycles = info.length;  // Opcode and operand fetches
+        Words target = splat_word(next);
+
+        switch (opcode) {
+            case static_cast<byte>(Op::NOP):
+                group_cycles++;
+                break;
+
+            case static_cast<byte>(Op::LDA_IM):
+                a = select(group, splat(operand), a);
+                flags = select(group, set_nz(flags, a), flags);
+                break;
+
+            case static_cast<byte>(Op::LDX_IM):
+                x = select(group, splat(operand), x);
+                flags = select(group, set_nz(flags, x), flags);
+                break;
+
+            case static_cast<byte>(Op::LDY_IM):
+                y = select(group, splat(operand), y);
+                flags = select(group, set_nz(flags, y), flags);
+                break;
+
+            case static_cast<byte>(Op::LDA_AB):
+                group_cycles++;
+                a = select(group, row(operand), a);
+                flags = select(group, set_nz(flags, a), flags);
+                break;
+
+            case static_cast<byte>(Op::STA_ABS):
+                group_cycles++;
+                if (operand < ram_size) {
+                    byte* cells = &ram[static_cast<size_t>(operand) * stride + base];
+                    store(cells, select(group, a, load<Bytes>(cells)));
+                }
+                break;
+
+            case static_cast<byte>(Op::INX):
+                group_cycles++;
+                x = select(group, x + 1, x);
+                flags = select(group, set_nz(flags, x), flags);
+                break;
+
+            case static_cast<byte>(Op::INY):
+                group_cycles++;
+                y = select(group, y + 1, y);
+                flags = select(group, set_nz(flags, y), flags);
+                break;
+
+            case static_cast<byte>(Op::DEX):
+                group_cycles++;
+                x = select(group, x - 1, x);
+                flags = select(group, set_nz(flags, x), flags);
+                break;
+
+            case static_cast<byte>(Op::DEY):
+                group_cycles++;
+                y = select(group, y - 1, y);
+                flags = select(group, set_nz(flags, y), flags);
+                break;
+
+            case static_cast<byte>(Op::TAX):
+                group_cycles++;
+                x = select(group, a, x);
+                flags = select(group, set_nz(flags, x), flags);
+                break;
+
+            case static_cast<byte>(Op::TAY):
+                group_cycles++;
+                y = select(group, a, y);
+                flags = select(group, set_nz(flags, y), flags);
+                break;
+
+            case static_cast<byte>(Op::TXA):
+                group_cycles++;
+                a = select(group, x, a);
+                flags = select(group, set_nz(flags, a), flags);
+                break;
+
+            case static_cast<byte>(Op::TYA):
+                group_cycles++;
+                a = select(group, y, a);
+                flags = select(group, set_nz(flags, a), flags);
+                break;
+
+            case static_cast<byte>(Op::CLI):
+                group_cycles++;
+                flags = select(group, flags & 0xFB, flags);
+                break;
+
+            case static_cast<byte>(Op::SEI):
+                group_cycles++;
+                flags = select(group, flags | 0x04, flags);
+                break;
+
+            case static_cast<byte>(Op::CLC):
+                group_cycles++;
+                flags = select(group, flags & 0xFE, flags);
+                break;
+
+            case static_cast<byte>(Op::SEC):
+                group_cycles++;
+                flags = select(group, flags | 0x01, flags);
+                break;
+
+            case static_cast<byte>(Op::CLD):
+                group_cycles++;
+                flags = select(group, flags & 0xF7, flags);
+                break;
+
+            case static_cast<byte>(Op::SED):
+                group_cycles++;
+                flags = select(group, flags | 0x08, flags);
+                break;
+
+            case static_cast<byte>(Op::JMP):
+                target = splat_word(operand);
+                break;
+
+            case static_cast<byte>(Op::JMPI):
+                group_cycles += 3;  // Internal cycle and the two pointer reads
+                target = __builtin_convertvector(row(operand), Words) |
+                         (__builtin_convertvector(row(operand + 1), Words) << 8);
+                break;
+
+            case static_cast<byte>(Op::BRA):
+            case static_cast<byte>(Op::BPL):
+            case static_cast<byte>(Op::BMI):
+            case static_cast<byte>(Op::BVC):
+            case static_cast<byte>(Op::BVS):
+            case static_cast<byte>(Op::BCC):
+            case static_cast<byte>(Op::BCS):
+            case static_cast<byte>(Op::BNE):
+            case static_cast<byte>(Op::BEQ): {
+                // Bits 7-6 of the opcode pick the flag (N, V, C, Z) and bit 5
+                // the value that takes the branch, BRA is always taken
+                static constexpr byte FLAG_BITS[4] = {0x80, 0x40, 0x01, 0x02};
+                if (opcode == static_cast<byte>(Op::BRA)) {
+                    taken = group;
+                } else {
+                    Bytes set = (Bytes)((flags & FLAG_BITS[opcode >> 6]) != 0);
+                    taken = group & ((opcode & 0x20) ? set : ~set);
+                }
+
+                word destination = next + static_cast<int8_t>(operand);
+                taken_cycles = (destination & 0xFF00) != (next & 0xFF00) ? 2 : 1;
+                target = select(to_words(taken), splat_word(destination), target);
+                break;
+            }
+
+            case static_cast<byte>(Op::JMPIX):
+            case static_cast<byte>(Op::RTI):
+            case static_cast<byte>(Op::ADC_IM):
+            case static_cast<byte>(Op::ADC_ZP):
+            case static_cast<byte>(Op::ADC_AB):
+            case static_cast<byte>(Op::SBC_IM):
+            case static_cast<byte>(Op::SBC_ZP):
+            case static_cast<byte>(Op::SBC_AB): {
+                // Addresses or table lookups differ per lane, run them one by
+                // one on the arrays
+                store(&A[base], a);
+                store(&X[base], x);
+                store(&Y[base], y);
+                store(&FLAGS[base], flags);
+                store(&states[base], state);
+                store(&PC[base], pc);
+                store(&cycles[base], cyc);
+
+                byte lanes_in_group[BLOCK];
+                store(lanes_in_group, group);
+                for (int lane = 0; lane < BLOCK; ++lane) {
+                    if (lanes_in_group[lane]) step_lane(base + lane, opcode, operand);
+                }
+
+                a = load<Bytes>(&A[base]);
+                flags = load<Bytes>(&FLAGS[base]);
+                state = load<Bytes>(&states[base]);
+                pc = load<Words>(&PC[base]);
+                cyc = load<Counters>(&cycles[base]);
+                continue;
+            }
+
+            case static_cast<byte>(Op::WAI):
+                // Nothing can interrupt a lane, it stays stopped
+                group_cycles += 2;
+                state = select(group, splat(HALTED), state);
+                break;
+
+            default:
+                // BRK and anything not implemented
+                state = select(group, splat(HALTED), state);
+                break;
+        }
+
+        pc = select(group_words, target, pc);
+        cyc += to_counters(group) & group_cycles;
+        cyc += to_counters(taken) & taken_cycles;
+    }
+
+    store(&A[base], a);
+    store(&X[base], x);
+    store(&Y[base], y);
+    store(&FLAGS[base], flags);
+    store(&states[base], state);
+    store(&PC[base], pc);
+    store(&cycles[base], cyc);
+}
@@ -0,0 +1,45 @@
+#include "bcd.h"
+
+// The nibble arithmetic, run once per table entry when the tables are filled
+
+static AluResult decimal_adc(byte a, byte operand, bool carry) {
+    int lo = (a & 0x0F) + (operand & 0x0F) + carry;
+    if (lo >= 0x0A) lo = ((lo + 0x06) & 0x0F) + 0x10;
+
+    // V comes from the sum before the high digit is corrected, taken as signed
+    int sum = (a & 0xF0) + (operand & 0xF0) + lo;
+    int signed_sum = static_cast<int8_t>(a & 0xF0) + static_cast<int8_t>(operand & 0xF0) + lo;
+    bool overflow = signed_sum < -128 || signed_sum > 127;
+
+    if (sum >= 0xA0) sum += 0x60;
+    byte value = sum & 0xFF;
+    return {value, static_cast<byte>((value & 0x80) | (overflow << 6) | ((value == 0) << 1) | (sum > 0xFF))};
+}
+
+static AluResult decimal_sbc(byte a, byte operand, bool carry) {
+    int lo = (a & 0x0F) - (operand & 0x0F) + carry - 1;
+    int difference = a - operand + carry - 1;
+
+    // C and V are those of the binary subtraction
+    AluResult binary = binary_sbc(a, operand, carry);
+
+    if (difference < 0) difference -= 0x60;
+    if (lo < 0) difference -= 0x06;
+    byte value = difference & 0xFF;
+    return {value, static_cast<byte>((value & 0x80) | (binary.flags & 0x41) | ((value == 0) << 1))};
+}
+
+// Filled by a static initializer at startup, 0x20000 entries are more than
+// compilers will evaluate as a constant (GCC with -fsanitize=undefined,
+// Clang's -fconstexpr-steps)
+template <AluResult (*Operation)(byte, byte, bool)>
+static std::array<AluResult, DECIMAL_TABLE_SIZE> decimal_table() {
+    std::array<AluResult, DECIMAL_TABLE_SIZE> table{};
+    for (uint32_t index = 0; index < DECIMAL_TABLE_SIZE; ++index) {
+        table[index] = Operation((index >> 8) & 0xFF, index & 0xFF, index >> 16);
+    }
+    return table;
+}
+
+const std::array<AluResult, DECIMAL_TABLE_SIZE> DECIMAL_ADC = decimal_table<decimal_adc>();
+const std::array<AluResult, DECIMAL_TABLE_SIZE> DECIMAL_SBC = decimal_table<decimal_sbc>();
@@ -1 +1,35 @@
 #include "bus.h"
+
+#include <algorithm>
+
+void Bus::add_master(BusMaster* master, byte priority, uint32_t burst) {
+    Master entry = {master, priority, burst ? burst : UINT32_MAX};
+    auto position = std::find_if(masters.begin(), masters.end(),
+                                 [priority](const Master& other) { return other.priority < priority; });
+    masters.insert(position, entry);
+    next_turn = 0;
+}
+
+uint32_t Bus::arbitrate() {
+    // Masters are sorted by priority, so the first pending one sets the
+    // level. Among the masters at that level the search starts after the
+    // last winner, which makes them take turns.
+    size_t count = masters.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (!masters[i].master->bus_requested()) continue;
+
+        size_t last = i;
+        while (last + 1 < count && masters[last + 1].priority == masters[i].priority) last++;
+
+        size_t span = last - i + 1;
+        size_t start = (next_turn > i && next_turn <= last) ? next_turn : i;
+        for (size_t k = 0; k < span; ++k) {
+            size_t j = i + (start - i + k) % span;
+            if (j != i && !masters[j].master->bus_requested()) continue;
+
+            next_turn = j < last ? j + 1 : i;
+            return masters[j].master->run_bus_cycles(masters[j].burst);
+        }
+    }
+    return 0;
+}
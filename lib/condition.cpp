@@ -0,0 +1,349 @@
+#include "condition.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#include "wdc65c02.h"
+
+class Condition::Compiler {
+   private:
+    Condition& cond;
+    const std::string& text;
+    size_t pos = 0;
+    int depth = 0;  // Stack depth after the code emitted so far
+    int max_depth = 0;
+
+    [[noreturn]] void fail(const std::string& message) {
+        throw std::invalid_argument("Condition error at column " + std::to_string(pos + 1) + ": " + message +
+                                    " in \"" + text + "\"");
+    }
+
+    void skip_space() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) pos++;
+    }
+
+    // Consume `token` if it comes next
+    bool accept(const char* token) {
+        skip_space();
+        size_t len = std::char_traits<char>::length(token);
+        if (text.compare(pos, len, token) != 0) return false;
+        // Don't split `||` / `&&` into `|` / `&`, or `<=` into `<`
+        if (len == 1 && pos + 1 < text.size()) {
+            char next = text[pos + 1];
+            if ((token[0] == '|' || token[0] == '&') && next == token[0]) return false;
+            if ((token[0] == '<' || token[0] == '>' || token[0] == '!' || token[0] == '=') && next == '=') return false;
+        }
+        pos += len;
+        return true;
+    }
+
+    void expect(const char* token) {
+        if (!accept(token)) fail(std::string("expected '") + token + "'");
+    }
+
+    // Consume a keyword if it comes next (case insensitive, whole word)
+    bool accept_word(const char* keyword) {
+        skip_space();
+        size_t len = std::char_traits<char>::length(keyword);
+        if (pos + len > text.size()) return false;
+        for (size_t i = 0; i < len; ++i) {
+            if (std::tolower(static_cast<unsigned char>(text[pos + i])) != keyword[i]) return false;
+        }
+        if (pos + len < text.size()) {
+            char next = text[pos + len];
+            if (std::isalnum(static_cast<unsigned char>(next)) || next == '_') return false;
+        }
+        pos += len;
+        return true;
+    }
+
+    // Emit an instruction, `effect` is how it changes the stack depth
+    void emit(Op op, int effect, int64_t operand = 0) {
+        cond.code.push_back({op, operand});
+        depth += effect;
+        max_depth = std::max(max_depth, depth);
+        if (max_depth > STACK_SIZE) fail("expression too deep");
+    }
+
+    int64_t number() {
+        int base = 10;
+        if (accept("$")) {
+            base = 16;
+        } else if (accept("%")) {
+            base = 2;
+        } else if (text.compare(pos, 2, "0x") == 0 || text.compare(pos, 2, "0X") == 0) {
+            pos += 2;
+            base = 16;
+        }
+
+        size_t start = pos;
+        int64_t value = 0;
+        while (pos < text.size()) {
+            int digit = std::isdigit(static_cast<unsigned char>(text[pos]))   ? text[pos] - '0'
+                        : std::isxdigit(static_cast<unsigned char>(text[pos])) ? std::tolower(text[pos]) - 'a' + 10
+                                                                               : base;
+            if (digit >= base) break;
+            value = value * base + digit;
+            pos++;
+        }
+        if (pos == start) fail("expected a number");
+        return value;
+    }
+
+    // `[addr]`, after the opening bracket
+    void memory() {
+        size_t start = cond.code.size();
+        expression();
+        expect("]");
+
+        // A constant address is folded into a single load
+        if (cond.code.size() == start + 1 && cond.code[start].op == Op::CONST) {
+            word addr = static_cast<word>(cond.code[start].operand);
+            cond.code.pop_back();
+            depth--;
+            emit(Op::MEM_AT, 1, addr);
+            cond.addresses.push_back(addr);
+        } else {
+            emit(Op::MEM, 0);
+            cond.dynamic_memory = true;
+        }
+    }
+
+    void primary() {
+        skip_space();
+        if (pos >= text.size()) fail("unexpected end of condition");
+
+        if (accept("(")) {
+            expression();
+            expect(")");
+            return;
+        }
+        if (accept("[")) {
+            memory();
+            return;
+        }
+        if (accept_word("memory") || accept_word("mem")) {
+            expect("[");
+            memory();
+            return;
+        }
+
+        static const struct {
+            const char* name;
+            Op op;
+            int bit;  // Flag bit in P
+        } NAMES[] = {
+            {"a", Op::REG_A, 0},   {"x", Op::REG_X, 0}, {"y", Op::REG_Y, 0}, {"sp", Op::REG_SP, 0},
+            {"pc", Op::REG_PC, 0}, {"p", Op::REG_P, 0}, {"c", Op::FLAG, 0},  {"z", Op::FLAG, 1},
+            {"i", Op::FLAG, 2},    {"d", Op::FLAG, 3},  {"v", Op::FLAG, 6},  {"n", Op::FLAG, 7},
+            {"cycles", Op::CYCLES, 0},
+        };
+        for (const auto& name : NAMES) {
+            if (accept_word(name.name)) {
+                emit(name.op, 1, name.bit);
+                cond.cpu_state = true;
+                return;
+            }
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(text[pos])) || text[pos] == '$' || text[pos] == '%') {
+            emit(Op::CONST, 1, number());
+            return;
+        }
+
+        fail("unexpected '" + std::string(1, text[pos]) + "'");
+    }
+
+    void bit_and() {
+        primary();
+        while (accept("&")) {
+            primary();
+            emit(Op::BIT_AND, -1);
+        }
+    }
+
+    void bit_or() {
+        bit_and();
+        while (accept("|")) {
+            bit_and();
+            emit(Op::BIT_OR, -1);
+        }
+    }
+
+    void comparison() {
+        bit_or();
+
+        if (accept_word("changes")) {
+            Instruction& last = cond.code.back();
+            if (last.op != Op::MEM_AT) fail("'changes' needs a memory operand with a constant address");
+            last.op = Op::CHANGED;
+            last.operand = static_cast<int64_t>(cond.watched.size());
+            cond.watched.push_back(cond.addresses.back());
+            return;
+        }
+
+        if (accept_word("in")) {
+            bit_or();
+            if (!accept("-") && !accept("..")) fail("expected '-' in range");
+            bit_or();
+            emit(Op::IN, -2);
+            return;
+        }
+
+        static const struct {
+            const char* token;
+            Op op;
+        } OPS[] = {{"==", Op::EQ}, {"!=", Op::NE}, {"<=", Op::LE}, {">=", Op::GE}, {"<", Op::LT}, {">", Op::GT}};
+        for (const auto& op : OPS) {
+            if (accept(op.token)) {
+                bit_or();
+                emit(op.op, -1);
+                return;
+            }
+        }
+    }
+
+    void unary() {
+        if (accept("!")) {
+            unary();
+            emit(Op::NOT, 0);
+            return;
+        }
+        comparison();
+    }
+
+    void conjunction() {
+        unary();
+        while (accept("&&")) {
+            unary();
+            emit(Op::AND, -1);
+        }
+    }
+
+   public:
+    Compiler(Condition& cond, const std::string& text) : cond(cond), text(text) {}
+
+    void expression() {
+        conjunction();
+        while (accept("||")) {
+            conjunction();
+            emit(Op::OR, -1);
+        }
+    }
+
+    void compile() {
+        expression();
+        skip_space();
+        if (pos != text.size()) fail("unexpected '" + std::string(1, text[pos]) + "'");
+    }
+};
+
+Condition::Condition(const std::string& source) : source(source) {
+    Compiler(*this, source).compile();
+
+    std::sort(addresses.begin(), addresses.end());
+    addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+    armed.assign(watched.size(), 0);
+}
+
+void Condition::arm(AddressDecoder& decoder) {
+    for (size_t i = 0; i < watched.size(); ++i) {
+        armed[i] = decoder.read_unhooked(watched[i]);
+    }
+}
+
+bool Condition::eval(const WDC65C02& cpu, AddressDecoder& decoder) const {
+    int64_t stack[STACK_SIZE];
+    int sp = 0;
+
+    for (const Instruction& insn : code) {
+        switch (insn.op) {
+            case Op::CONST:
+                stack[sp++] = insn.operand;
+                break;
+            case Op::REG_A:
+                stack[sp++] = cpu.A;
+                break;
+            case Op::REG_X:
+                stack[sp++] = cpu.X;
+                break;
+            case Op::REG_Y:
+                stack[sp++] = cpu.Y;
+                break;
+            case Op::REG_SP:
+                stack[sp++] = cpu.SP;
+                break;
+            case Op::REG_PC:
+                stack[sp++] = cpu.PC;
+                break;
+            case Op::REG_P:
+                stack[sp++] = cpu.FLAGS;
+                break;
+            case Op::FLAG:
+                stack[sp++] = (cpu.FLAGS >> insn.operand) & 1;
+                break;
+            case Op::CYCLES:
+                stack[sp++] = static_cast<int64_t>(cpu.cycles);
+                break;
+            case Op::MEM:
+                stack[sp - 1] = decoder.read_unhooked(static_cast<word>(stack[sp - 1]));
+                break;
+            case Op::MEM_AT:
+                stack[sp++] = decoder.read_unhooked(static_cast<word>(insn.operand));
+                break;
+            case Op::CHANGED:
+                stack[sp++] = decoder.read_unhooked(watched[insn.operand]) != armed[insn.operand];
+                break;
+            case Op::EQ:
+                sp--;
+                stack[sp - 1] = stack[sp - 1] == stack[sp];
+                break;
+            case Op::NE:
+                sp--;
+                stack[sp - 1] = stack[sp - 1] != stack[sp];
+                break;
+            case Op::LT:
+                sp--;
+                stack[sp - 1] = stack[sp - 1] < stack[sp];
+                break;
+            case Op::LE:
+                sp--;
+                stack[sp - 1] = stack[sp - 1] <= stack[sp];
+                break;
+            case Op::GT:
+                sp--;
+                stack[sp - 1] = stack[sp - 1] > stack[sp];
+                break;
+            case Op::GE:
+                sp--;
+                stack[sp - 1] = stack[sp - 1] >= stack[sp];
+                break;
+            case Op::IN:
+                sp -= 2;
+                stack[sp - 1] = stack[sp - 1] >= stack[sp] && stack[sp - 1] <= stack[sp + 1];
+                break;
+            case Op::BIT_AND:
+                sp--;
+                stack[sp - 1] &= stack[sp];
+                break;
+            case Op::BIT_OR:
+                sp--;
+                stack[sp - 1] |= stack[sp];
+                break;
+            case Op::NOT:
+                stack[sp - 1] = !stack[sp - 1];
+                break;
+            case Op::AND:
+                sp--;
+                stack[sp - 1] = stack[sp - 1] && stack[sp];
+                break;
+            case Op::OR:
+                sp--;
+                stack[sp - 1] = stack[sp - 1] || stack[sp];
+                break;
+        }
+    }
+
+    return sp > 0 && stack[sp - 1] != 0;
+}
@@ -0,0 +1,122 @@
+#include "coverage.h"
+
+#include <bitset>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+#include "disassembler.h"
+
+static const char COVERAGE_MAGIC[8] = {'M', '6', '5', 'C', 'O', 'V', '0', '1'};
+
+uint32_t Coverage::count(CoverageKind kind, word start, word end) const {
+    uint32_t total = 0;
+    for (uint32_t addr = start; addr <= end; ++addr) {
+        // Whole words at a time where the range allows it
+        if ((addr & 63) == 0 && addr + 63 <= end) {
+            total += std::bitset<64>(bits[static_cast<int>(kind)][addr >> 6]).count();
+            addr += 63;
+        } else {
+            total += covered(kind, addr);
+        }
+    }
+    return total;
+}
+
+void Coverage::clear() {
+    std::memset(bits, 0, sizeof(bits));
+}
+
+void Coverage::merge(const Coverage& other) {
+    for (int kind = 0; kind < KINDS; ++kind) {
+        for (int i = 0; i < WORDS; ++i) bits[kind][i] |= other.bits[kind][i];
+    }
+}
+
+bool Coverage::save(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(COVERAGE_MAGIC, sizeof(COVERAGE_MAGIC));
+    file.write(reinterpret_cast<const char*>(bits), sizeof(bits));
+    return static_cast<bool>(file);
+}
+
+bool Coverage::merge_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    char magic[sizeof(COVERAGE_MAGIC)];
+    Coverage other;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(other.bits), sizeof(other.bits));
+    if (!file || std::memcmp(magic, COVERAGE_MAGIC, sizeof(magic)) != 0) return false;
+
+    merge(other);
+    return true;
+}
+
+void Coverage::report(std::ostream& out, AddressDecoder& decoder, word start, word end) const {
+    uint32_t size = end - start + 1;
+    out << std::hex << std::uppercase << std::setfill('0');
+    out << "; Coverage of $" << std::setw(4) << start << "-$" << std::setw(4) << end << std::dec << ": "
+        << count(CoverageKind::OPCODE, start, end) << " opcodes, " << count(CoverageKind::OPERAND, start, end)
+        << " operands, " << count(CoverageKind::READ, start, end) << " data reads, "
+        << count(CoverageKind::WRITE, start, end) << " writes out of " << size << " bytes\n";
+    out << std::hex;
+
+    // Flags column: X executed opcode, o operand, R read, W written
+    auto flags = [this](word addr) {
+        std::string f = "    ";
+        if (covered(CoverageKind::OPCODE, addr)) f[0] = 'X';
+        if (covered(CoverageKind::OPERAND, addr)) f[1] = 'o';
+        if (covered(CoverageKind::READ, addr)) f[2] = 'R';
+        if (covered(CoverageKind::WRITE, addr)) f[3] = 'W';
+        return f;
+    };
+    auto any = [this](word addr) {
+        return covered(CoverageKind::OPCODE, addr) || covered(CoverageKind::OPERAND, addr) ||
+               covered(CoverageKind::READ, addr) || covered(CoverageKind::WRITE, addr);
+    };
+
+    uint32_t addr = start;
+    while (addr <= end) {
+        if (!any(addr)) {
+            uint32_t first = addr;
+            while (addr <= end && !any(addr)) addr++;
+            out << "; $" << std::setw(4) << first << "-$" << std::setw(4) << addr - 1 << " not covered ("
+                << std::dec << addr - first << " bytes)" << std::hex << "\n";
+            continue;
+        }
+
+        byte opcode = decoder.read_unhooked(addr);
+        out << std::setw(4) << addr << "  " << flags(addr) << "  ";
+
+        if (!covered(CoverageKind::OPCODE, addr)) {
+            out << std::setw(2) << (int)opcode << "          .byte $" << std::setw(2) << (int)opcode << "\n";
+            addr++;
+            continue;
+        }
+
+        int length = INSTRUCTIONS[opcode].length;
+        if (addr + length - 1 > end) length = end - addr + 1;
+
+        byte bytes[3] = {opcode, 0, 0};
+        char hex[12] = "           ";
+        for (int i = 0; i < length; ++i) {
+            if (i > 0) bytes[i] = decoder.read_unhooked(addr + i);
+            std::snprintf(hex + 3 * i, 4, "%02X ", bytes[i]);
+            hex[3 * i + 3] = ' ';
+        }
+
+        char text[DISASM_BUFFER];
+        disassemble(bytes, addr, text);
+        out << hex << text << "\n";
+
+        // The operands are shown on this line, unless one of them was
+        // also executed as an opcode
+        uint32_t next = addr + 1;
+        while (next < addr + length && !covered(CoverageKind::OPCODE, next)) next++;
+        addr = next;
+    }
+}
@@ -0,0 +1,190 @@
+#include "debugger.h"
+
+#include <algorithm>
+
+#include "wdc65c02.h"
+
+// Hooked over a page with watchpoints, forwards every access to the
+// mapped module and reports it to the debugger
+class WatchHook : public MEM_Module {
+   private:
+    Debugger& debugger;
+    AddressDecoder& decoder;
+    word base;  // First address of the page
+
+   public:
+    WatchHook(Debugger& debugger, AddressDecoder& decoder, byte index)
+        : debugger(debugger), decoder(decoder), base(index << 8) {}
+
+    word read_word(word addr) override {
+        word full = base | (addr & 0xFF);
+        byte value = decoder.read_unhooked(full);
+        debugger.check_access(full, value, false);
+        return value;
+    }
+    byte read_byte(byte addr) override { return read_word(addr); }
+    void write_word(word addr, word data) override {
+        word full = base | (addr & 0xFF);
+        decoder.write_unhooked(full, data);
+        debugger.check_access(full, data & 0xFF, true);
+    }
+    void write_byte(byte addr, byte data) override { write_word(addr, data); }
+};
+
+Debugger::Debugger(WDC65C02& cpu, AddressDecoder& decoder) : cpu(cpu), decoder(decoder) {
+    cpu.attach_debugger(this);
+}
+
+Debugger::~Debugger() {
+    clear();
+    cpu.attach_debugger(nullptr);
+}
+
+int Debugger::add_breakpoint(word start, word end) {
+    if (end < start) std::swap(start, end);
+    breakpoints.push_back({next_id, start, end});
+    rearm(start, end);
+    return next_id++;
+}
+
+int Debugger::add_watchpoint(word start, word end, WatchType type, int value) {
+    if (end < start) std::swap(start, end);
+    watchpoints.push_back({next_id, start, end, type, value, false});
+    rearm(start, end);
+    return next_id++;
+}
+
+bool Debugger::remove(int id) {
+    for (auto it = breakpoints.begin(); it != breakpoints.end(); ++it) {
+        if (it->id == id) {
+            Breakpoint removed = *it;
+            breakpoints.erase(it);
+            rearm(removed.start, removed.end);
+            return true;
+        }
+    }
+    for (auto it = watchpoints.begin(); it != watchpoints.end(); ++it) {
+        if (it->id == id) {
+            Watchpoint removed = *it;
+            watchpoints.erase(it);
+            rearm(removed.start, removed.end);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Debugger::clear() {
+    breakpoints.clear();
+    watchpoints.clear();
+    rearm(0x0000, 0xFFFF);
+}
+
+void Debugger::rearm(word start, word end) {
+    for (int index = start >> 8; index <= end >> 8; ++index) {
+        word first = index << 8;
+        word last = first | 0xFF;
+        auto overlaps = [&](word s, word e) { return s <= last && e >= first; };
+
+        break_pages[index] = std::any_of(breakpoints.begin(), breakpoints.end(),
+                                         [&](const Breakpoint& b) { return overlaps(b.start, b.end); });
+
+        bool watched = std::any_of(watchpoints.begin(), watchpoints.end(),
+                                   [&](const Watchpoint& w) { return overlaps(w.start, w.end); });
+        if (watched && !watch_hooks[index]) {
+            watch_hooks[index] = std::make_unique<WatchHook>(*this, decoder, index);
+            decoder.hook_page(index, watch_hooks[index].get());
+        } else if (!watched && watch_hooks[index]) {
+            decoder.unhook_page(index);
+            watch_hooks[index].reset();
+        }
+    }
+}
+
+bool Debugger::check_breakpoint(word pc) {
+    if (skip_once) {
+        skip_once = false;
+        if (pc == skip_pc) return false;
+    }
+
+    for (const Breakpoint& b : breakpoints) {
+        if (pc >= b.start && pc <= b.end) {
+            stop({b.id, true, false, pc, 0, cpu.cycles});
+            return true;
+        }
+    }
+    return false;
+}
+
+void Debugger::check_access(word addr, byte value, bool write) {
+    byte type = static_cast<byte>(write ? WatchType::WRITE : WatchType::READ);
+    for (const Watchpoint& w : watchpoints) {
+        if (addr < w.start || addr > w.end) continue;
+        if (!(static_cast<byte>(w.type) & type)) continue;
+        if (w.value >= 0 && w.value != value) continue;
+        if (w.trigger) {
+            triggered = true;
+            continue;
+        }
+        stop({w.id, false, write, addr, value, cpu.cycles});
+        return;
+    }
+}
+
+void Debugger::stop(const DebugHit& hit) {
+    last_hit = hit;
+    cpu.state = CPU_State::STOPPED;
+    if (on_hit) on_hit(hit);
+}
+
+void Debugger::resume() {
+    if (cpu.state != CPU_State::STOPPED) return;
+    skip_once = last_hit.breakpoint && last_hit.addr == cpu.PC;
+    skip_pc = cpu.PC;
+    cpu.reset_idle_detection();  // Registers or memory may have been edited while stopped
+    cpu.state = CPU_State::RUNNING;
+}
+
+bool Debugger::run_until(Condition& condition, uint64_t max_cycles) {
+    condition.arm(decoder);
+    if (condition.eval(cpu, decoder)) return true;
+
+    uint64_t limit = max_cycles > UINT64_MAX - cpu.cycles ? UINT64_MAX : cpu.cycles + max_cycles;
+    resume();
+
+    // Memory only conditions can't change unless one of their bytes is written
+    bool on_writes = condition.memory_only();
+    std::vector<int> triggers;
+    if (on_writes) {
+        for (word addr : condition.referenced()) {
+            watchpoints.push_back({next_id, addr, addr, WatchType::WRITE, -1, true});
+            rearm(addr, addr);
+            triggers.push_back(next_id++);
+        }
+    }
+    triggered = false;
+
+    // Idle loop skipping must not run past the cycle limit, nor past the
+    // cycle a condition on `cycles` becomes true
+    bool on_cycles = std::any_of(condition.bytecode().begin(), condition.bytecode().end(),
+                                 [](const Condition::Instruction& i) { return i.op == Condition::Op::CYCLES; });
+    uint64_t saved_skip_limit = cpu.skip_limit;
+    cpu.skip_limit = on_cycles ? 0 : std::min(limit, saved_skip_limit);
+
+    bool met = false;
+    while (cpu.state == CPU_State::RUNNING && cpu.cycles < limit) {
+        cpu.step();
+        if (on_writes) {
+            if (!triggered) continue;
+            triggered = false;
+        }
+        if (condition.eval(cpu, decoder)) {
+            met = true;
+            break;
+        }
+    }
+
+    for (int id : triggers) remove(id);
+    cpu.skip_limit = saved_skip_limit;
+    return met;
+}
@@ -0,0 +1,133 @@
+#include "decoder.h"
+
+#include <algorithm>
+
+#include "state_hash.h"
+
+void AddressDecoder::add_mapping(word start, word end, MEM_Module* module) {
+    map.push_back({start, end, module});
+    rebuild_pages(start, end);
+}
+
+void AddressDecoder::add_device(word start, word end, IO_Device* device) {
+    map.insert(map.begin(), {start, end, device, true});
+    rebuild_pages(start, end);
+}
+
+void AddressDecoder::remap(word start, word end, MEM_Module* module) {
+    // Drop mappings that lie entirely inside the range, anything only
+    // partially covered keeps the bytes outside it
+    map.erase(std::remove_if(map.begin(), map.end(),
+                             [&](const Mapping& m) { return m.start >= start && m.end <= end; }),
+              map.end());
+    map.insert(map.begin(), {start, end, module});
+
+    // The new mapping comes first, so the pages it covers whole are its
+    // own without scanning the list. Only partly covered pages at either
+    // end of the range have to be rebuilt.
+    int first = start >> 8;
+    int last = end >> 8;
+    if ((start & 0xFF) != 0) {
+        rebuild_pages(start, start);
+        first++;
+    }
+    if ((end & 0xFF) != 0xFF) {
+        rebuild_pages(end, end);
+        last--;
+    }
+    for (int index = first; index <= last; ++index) set_page(index, {module, start, false});
+}
+
+uint64_t AddressDecoder::next_event() {
+    uint64_t next = UINT64_MAX;
+    for (auto& m : map) next = std::min(next, m.module->next_event());
+    return next;
+}
+
+// Bytes from `addr` to the end of the run of pages mapped like its own
+static size_t mapped_run(const Page* pages, word addr) {
+    const Page& page = pages[addr >> 8];
+    unsigned index = addr >> 8;
+    while (index + 1 < 256 && pages[index + 1].module == page.module && pages[index + 1].start == page.start) index++;
+    return (index + 1) * 256 - addr;
+}
+
+const byte* AddressDecoder::read_span(word addr, size_t& length) {
+    const Page& page = pages[addr >> 8];
+    if (page.module == nullptr) return nullptr;
+
+    const byte* span = page.module->read_span(addr - page.start, length);
+    if (span) length = std::min(length, mapped_run(pages, addr));
+    return span;
+}
+
+byte* AddressDecoder::write_span(word addr, size_t& length) {
+    const Page& page = pages[addr >> 8];
+    if (page.module == nullptr || state_hash) return nullptr;
+
+    byte* span = page.module->write_span(addr - page.start, length);
+    if (span) length = std::min(length, mapped_run(pages, addr));
+    return span;
+}
+
+void AddressDecoder::write_hashed(word addr, word val) {
+    const byte* cell = state_hash->cell(addr);
+    if (cell == nullptr) {
+        write_page(mapped[addr >> 8], addr, val);
+        return;
+    }
+
+    // Compare with what the module stored, not the value on the bus
+    byte old_value = *cell;
+    write_page(mapped[addr >> 8], addr, val);
+    state_hash->update(addr, old_value, *cell);
+}
+
+const Mapping* AddressDecoder::find(word addr) const {
+    for (auto& m : map) {
+        if (addr >= m.start && addr <= m.end) return &m;
+    }
+    return nullptr;
+}
+
+void AddressDecoder::rebuild_pages(word start, word end) {
+    for (int index = start >> 8; index <= end >> 8; ++index) {
+        word first = index << 8;
+        word last = first | 0xFF;
+        Page page;
+
+        // The highest priority mapping touching the page decides: it
+        // either owns the whole page or the page has to be split
+        for (auto& m : map) {
+            if (m.end < first || m.start > last) continue;
+            if (m.start <= first && m.end >= last) {
+                page.module = m.module;
+                page.start = m.start;
+            } else {
+                page.split = true;
+            }
+            break;
+        }
+
+        set_page(index, page);
+    }
+}
+
+void AddressDecoder::set_page(int index, const Page& page) {
+    mapped[index] = page;
+    if (hooks[index]) {
+        pages[index] = {hooks[index], static_cast<word>(index << 8), false};
+    } else {
+        pages[index] = page;
+    }
+}
+
+void AddressDecoder::hook_page(byte index, MEM_Module* hook) {
+    hooks[index] = hook;
+    pages[index] = {hook, static_cast<word>(index << 8), false};
+}
+
+void AddressDecoder::unhook_page(byte index) {
+    hooks[index] = nullptr;
+    pages[index] = mapped[index];
+}
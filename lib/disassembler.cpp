@@ -0,0 +1,104 @@
+#include "disassembler.h"
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+static char* put(char* p, const char* text) {
+    while (*text) *p++ = *text++;
+    return p;
+}
+
+static char* put_hex8(char* p, byte value) {
+    *p++ = '$';
+    *p++ = HEX_DIGITS[value >> 4];
+    *p++ = HEX_DIGITS[value & 0x0F];
+    return p;
+}
+
+static char* put_hex16(char* p, word value) {
+    *p++ = '$';
+    *p++ = HEX_DIGITS[value >> 12];
+    *p++ = HEX_DIGITS[(value >> 8) & 0x0F];
+    *p++ = HEX_DIGITS[(value >> 4) & 0x0F];
+    *p++ = HEX_DIGITS[value & 0x0F];
+    return p;
+}
+
+int disassemble(const byte* bytes, word pc, char* out) {
+    const InstructionInfo& info = INSTRUCTIONS[bytes[0]];
+    byte lo = info.length > 1 ? bytes[1] : 0;
+    word abs = info.length > 2 ? static_cast<word>(lo | (bytes[2] << 8)) : lo;
+
+    char* p = put(out, info.mnemonic);
+    if (info.mode != AddrMode::IMP) *p++ = ' ';
+
+    switch (info.mode) {
+        case AddrMode::IMP:
+            break;
+        case AddrMode::ACC:
+            *p++ = 'A';
+            break;
+        case AddrMode::IMM:
+            *p++ = '#';
+            p = put_hex8(p, lo);
+            break;
+        case AddrMode::ZP:
+            p = put_hex8(p, lo);
+            break;
+        case AddrMode::ZPX:
+            p = put(put_hex8(p, lo), ",X");
+            break;
+        case AddrMode::ZPY:
+            p = put(put_hex8(p, lo), ",Y");
+            break;
+        case AddrMode::ZPI:
+            *p++ = '(';
+            p = put(put_hex8(p, lo), ")");
+            break;
+        case AddrMode::INX:
+            *p++ = '(';
+            p = put(put_hex8(p, lo), ",X)");
+            break;
+        case AddrMode::INY:
+            *p++ = '(';
+            p = put(put_hex8(p, lo), "),Y");
+            break;
+        case AddrMode::ABS:
+            p = put_hex16(p, abs);
+            break;
+        case AddrMode::ABSX:
+            p = put(put_hex16(p, abs), ",X");
+            break;
+        case AddrMode::ABSY:
+            p = put(put_hex16(p, abs), ",Y");
+            break;
+        case AddrMode::IND:
+            *p++ = '(';
+            p = put(put_hex16(p, abs), ")");
+            break;
+        case AddrMode::AIX:
+            *p++ = '(';
+            p = put(put_hex16(p, abs), ",X)");
+            break;
+        case AddrMode::REL:
+            // Branch targets are relative to the next instruction
+            p = put_hex16(p, pc + 2 + static_cast<int8_t>(lo));
+            break;
+        case AddrMode::ZPR:
+            p = put(put_hex8(p, lo), ",");
+            p = put_hex16(p, pc + 3 + static_cast<int8_t>(bytes[2]));
+            break;
+    }
+
+    *p = '\0';
+    return info.length;
+}
+
+int disassemble(AddressDecoder& decoder, word pc, char* out) {
+    byte bytes[3];
+    bytes[0] = decoder.read_unhooked(pc);
+    int length = INSTRUCTIONS[bytes[0]].length;
+    for (int i = 1; i < length; ++i) {
+        bytes[i] = decoder.read_unhooked(static_cast<word>(pc + i));
+    }
+    return disassemble(bytes, pc, out);
+}
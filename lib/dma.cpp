@@ -0,0 +1,104 @@
+#include "dma.h"
+
+#include <algorithm>
+#include <cstring>
+
+byte DMAController::io_read(word reg) {
+    switch (reg & 0x07) {
+        case SRC_LO:
+            return source & 0xFF;
+        case SRC_HI:
+            return source >> 8;
+        case DST_LO:
+            return destination & 0xFF;
+        case DST_HI:
+            return destination >> 8;
+        case LEN_LO:
+            return length & 0xFF;
+        case LEN_HI:
+            return length >> 8;
+        case CONTROL:
+            return (control & ~CONTROL_START) | (remaining ? CONTROL_START : 0);
+        default: {
+            byte status = (remaining ? STATUS_BUSY : 0) | (done ? STATUS_DONE : 0);
+            done = false;  // Reading the status acknowledges the IRQ
+            return status;
+        }
+    }
+}
+
+void DMAController::io_write(word reg, byte data) {
+    // The addresses and length are locked while a transfer runs
+    if (remaining && (reg & 0x07) != CONTROL) return;
+
+    switch (reg & 0x07) {
+        case SRC_LO:
+            source = (source & 0xFF00) | data;
+            break;
+        case SRC_HI:
+            source = (source & 0x00FF) | (data << 8);
+            break;
+        case DST_LO:
+            destination = (destination & 0xFF00) | data;
+            break;
+        case DST_HI:
+            destination = (destination & 0x00FF) | (data << 8);
+            break;
+        case LEN_LO:
+            length = (length & 0xFF00) | data;
+            break;
+        case LEN_HI:
+            length = (length & 0x00FF) | (data << 8);
+            break;
+        case CONTROL:
+            control = data;
+            if ((data & CONTROL_START) && !remaining) {
+                remaining = length ? length : 0x10000;
+                done = false;
+            }
+            break;
+        default:
+            break;  // STATUS is read only
+    }
+}
+
+uint64_t DMAController::next_event() {
+    // A pending transfer runs at the next instruction boundary
+    return remaining ? now() : UINT64_MAX;
+}
+
+uint32_t DMAController::run_bus_cycles(uint32_t max_cycles) {
+    uint32_t count = std::min(remaining, std::max<uint32_t>(1, max_cycles / CYCLES_PER_BYTE));
+    copy(count);
+
+    remaining -= count;
+    length = remaining & 0xFFFF;
+    if (remaining == 0) done = true;
+    return count * CYCLES_PER_BYTE;
+}
+
+void DMAController::copy(uint32_t count) {
+    transferred += count;
+    while (count > 0) {
+        // A destination just above the source reads bytes this transfer
+        // wrote, so a chunk must not reach past the gap
+        size_t chunk = count;
+        word gap = destination - source;
+        if (gap != 0 && gap < chunk) chunk = gap;
+
+        size_t readable = 0, writable = 0;
+        const byte* from = decoder.read_span(source, readable);
+        byte* to = decoder.write_span(destination, writable);
+        if (from && to) {
+            chunk = std::min({chunk, readable, writable});
+            std::memmove(to, from, chunk);
+        } else {
+            chunk = 1;
+            decoder.write(destination, decoder.read(source));
+        }
+
+        source += chunk;
+        destination += chunk;
+        count -= chunk;
+    }
+}
@@ -0,0 +1,517 @@
+#include "gdb_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "disassembler.h"
+#include "log.h"
+
+// Instructions run between looks at the interrupt flag
+static constexpr int RUN_BATCH = 4096;
+
+// Register numbers in `g` / `p` packets
+enum GdbReg { REG_A = 0, REG_X = 1, REG_Y = 2, REG_P = 3, REG_SP = 4, REG_PC = 5, REG_COUNT = 6 };
+
+static const char TARGET_XML[] =
+    "<?xml version=\"1.0\"?>"
+    "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">"
+    "<target version=\"1.0\">"
+    "<feature name=\"org.m65c02.core\">"
+    "<reg name=\"a\" bitsize=\"8\" regnum=\"0\"/>"
+    "<reg name=\"x\" bitsize=\"8\" regnum=\"1\"/>"
+    "<reg name=\"y\" bitsize=\"8\" regnum=\"2\"/>"
+    "<reg name=\"p\" bitsize=\"8\" regnum=\"3\"/>"
+    "<reg name=\"sp\" bitsize=\"8\" regnum=\"4\"/>"
+    "<reg name=\"pc\" bitsize=\"16\" regnum=\"5\" type=\"code_ptr\"/>"
+    "</feature>"
+    "</target>";
+
+static std::string to_hex(uint32_t value, int bytes) {
+    // Little endian, the way GDB expects register contents
+    std::string out;
+    char buf[3];
+    for (int i = 0; i < bytes; ++i) {
+        std::snprintf(buf, sizeof(buf), "%02x", (value >> (8 * i)) & 0xFF);
+        out += buf;
+    }
+    return out;
+}
+
+static uint32_t from_hex_le(const std::string& hex) {
+    uint32_t value = 0;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        value |= std::strtoul(hex.substr(i, 2).c_str(), nullptr, 16) << (4 * i);
+    }
+    return value;
+}
+
+GdbServer::GdbServer(WDC65C02& cpu, AddressDecoder& decoder, Debugger& debugger)
+    : cpu(cpu), decoder(decoder), debugger(debugger) {}
+
+GdbServer::~GdbServer() {
+    close_client();
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        if (!socket_path.empty()) unlink(socket_path.c_str());
+    }
+}
+
+bool GdbServer::listen_tcp(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        logger::error(std::string("Cannot create GDB socket: ") + std::strerror(errno));
+        return false;
+    }
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // Never reachable from other hosts
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 1) != 0) {
+        logger::error("Cannot listen on port " + std::to_string(port) + ": " + std::strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    listen_fd = fd;
+    logger::info("GDB server listening on 127.0.0.1:" + std::to_string(port));
+    return true;
+}
+
+bool GdbServer::listen_unix(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        logger::error("UNIX socket path too long: " + path);
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        logger::error(std::string("Cannot create UNIX socket: ") + std::strerror(errno));
+        return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 1) != 0) {
+        logger::error("Cannot listen on " + path + ": " + std::strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    listen_fd = fd;
+    socket_path = path;
+    logger::info("GDB server listening on " + path);
+    return true;
+}
+
+void GdbServer::close_client() {
+    if (client_fd >= 0) {
+        shutdown(client_fd, SHUT_RDWR);  // Wakes the reader thread up
+    }
+    if (reader_thread.joinable()) {
+        reader_thread.join();
+    }
+    if (client_fd >= 0) {
+        close(client_fd);
+        client_fd = -1;
+    }
+}
+
+void GdbServer::serve() {
+    if (listen_fd < 0) return;
+
+    client_fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client_fd < 0) {
+        logger::error(std::string("GDB accept failed: ") + std::strerror(errno));
+        return;
+    }
+    int one = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // Fails harmlessly on UNIX sockets
+    logger::info("GDB client connected");
+
+    no_ack.store(false);
+    disconnected = false;
+    packets.clear();
+    interrupt_requested.store(false);
+    reader_thread = std::thread(&GdbServer::reader_loop, this);
+
+    // The client is in control from now on
+    if (cpu.state == CPU_State::RUNNING) cpu.state = CPU_State::STOPPED;
+
+    std::string packet;
+    bool done = false;
+    while (!done && next_packet(packet)) {
+        std::string reply = handle(packet, done);
+        if (packet == "k") break;  // Kill has no reply
+        send_packet(reply);
+
+        // The reply to QStartNoAckMode is the last one acknowledged
+        if (packet == "QStartNoAckMode") no_ack = true;
+    }
+
+    close_client();
+    logger::info("GDB client disconnected");
+}
+
+void GdbServer::reader_loop() {
+    enum { IDLE, DATA, CHECKSUM1, CHECKSUM2 } state = IDLE;
+    std::string payload;
+    byte sum = 0;
+    char checksum[3] = {};
+
+    char buf[4096];
+    while (true) {
+        ssize_t got = recv(client_fd, buf, sizeof(buf), 0);
+        if (got <= 0) break;
+
+        for (ssize_t i = 0; i < got; ++i) {
+            char c = buf[i];
+            switch (state) {
+                case IDLE:
+                    if (c == '$') {
+                        payload.clear();
+                        sum = 0;
+                        state = DATA;
+                    } else if (c == 0x03) {
+                        interrupt_requested.store(true, std::memory_order_relaxed);
+                    }
+                    // '+' / '-' acks need no handling, replies are never resent
+                    break;
+                case DATA:
+                    if (c == '#') {
+                        state = CHECKSUM1;
+                    } else {
+                        payload += c;
+                        sum += static_cast<byte>(c);
+                    }
+                    break;
+                case CHECKSUM1:
+                    checksum[0] = c;
+                    state = CHECKSUM2;
+                    break;
+                case CHECKSUM2: {
+                    checksum[1] = c;
+                    state = IDLE;
+                    bool valid = std::strtoul(checksum, nullptr, 16) == sum;
+                    if (!no_ack) send_raw(valid ? "+" : "-");
+                    if (valid) {
+                        std::lock_guard<std::mutex> lock(packet_mutex);
+                        packets.push_back(payload);
+                        packet_ready.notify_one();
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // The client went away, stop a running CPU and wake the server up
+    std::lock_guard<std::mutex> lock(packet_mutex);
+    disconnected = true;
+    interrupt_requested.store(true);
+    packet_ready.notify_one();
+}
+
+bool GdbServer::next_packet(std::string& packet) {
+    std::unique_lock<std::mutex> lock(packet_mutex);
+    packet_ready.wait(lock, [this]() { return !packets.empty() || disconnected; });
+    if (packets.empty()) return false;
+    packet = std::move(packets.front());
+    packets.pop_front();
+    return true;
+}
+
+void GdbServer::send_raw(const std::string& data) {
+    std::lock_guard<std::mutex> lock(send_mutex);
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(client_fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return;
+        }
+        sent += n;
+    }
+}
+
+void GdbServer::send_packet(const std::string& payload) {
+    byte sum = 0;
+    for (char c : payload) sum += static_cast<byte>(c);
+    char trailer[4];
+    std::snprintf(trailer, sizeof(trailer), "#%02x", sum);
+    send_raw("$" + payload + trailer);
+}
+
+std::string GdbServer::read_registers() {
+    return to_hex(cpu.A, 1) + to_hex(cpu.X, 1) + to_hex(cpu.Y, 1) + to_hex(cpu.FLAGS, 1) + to_hex(cpu.SP, 1) +
+           to_hex(cpu.PC, 2);
+}
+
+bool GdbServer::write_register(int reg, uint32_t value) {
+    switch (reg) {
+        case REG_A:
+            cpu.A = value;
+            return true;
+        case REG_X:
+            cpu.X = value;
+            return true;
+        case REG_Y:
+            cpu.Y = value;
+            return true;
+        case REG_P:
+            cpu.FLAGS = value;
+            return true;
+        case REG_SP:
+            cpu.SP = value;
+            return true;
+        case REG_PC:
+            cpu.PC = value;
+            return true;
+        default:
+            return false;
+    }
+}
+
+std::string GdbServer::insert_point(const std::string& args, bool insert) {
+    // type,addr,kind
+    char type = args[0];
+    char* end = nullptr;
+    word addr = std::strtoul(args.c_str() + 2, &end, 16);
+    int kind = (end && *end == ',') ? std::strtol(end + 1, nullptr, 16) : 1;
+    if (type < '0' || type > '4') return "";
+    auto key = std::make_tuple(type, addr, kind);
+
+    if (!insert) {
+        auto it = points.find(key);
+        if (it != points.end()) {
+            debugger.remove(it->second);
+            watch_types.erase(it->second);
+            points.erase(it);
+        }
+        return "OK";
+    }
+
+    if (points.count(key)) return "OK";
+
+    int id;
+    if (type == '0' || type == '1') {
+        id = debugger.add_breakpoint(addr);
+    } else {
+        static const WatchType TYPES[] = {WatchType::WRITE, WatchType::READ, WatchType::ACCESS};
+        word last = addr + std::max(kind, 1) - 1;
+        id = debugger.add_watchpoint(addr, last, TYPES[type - '2']);
+        watch_types[id] = type;
+    }
+    points[key] = id;
+    return "OK";
+}
+
+std::string GdbServer::run(bool single_step) {
+    if (cpu.state == CPU_State::HALTED || cpu.state == CPU_State::POWER_OFF) return "W00";
+
+    debugger.resume();
+    if (cpu.state != CPU_State::RUNNING) cpu.state = CPU_State::RUNNING;
+
+    bool interrupted = false;
+    if (single_step) {
+        cpu.step();
+    } else {
+        while (cpu.state == CPU_State::RUNNING) {
+            for (int i = 0; i < RUN_BATCH && cpu.state == CPU_State::RUNNING; ++i) {
+                cpu.step();
+            }
+            if (interrupt_requested.exchange(false, std::memory_order_relaxed)) {
+                interrupted = true;
+                break;
+            }
+        }
+    }
+
+    if (cpu.state == CPU_State::HALTED) return "W00";
+
+    if (cpu.state == CPU_State::STOPPED) {
+        // Stopped by the debugger
+        const DebugHit& hit = debugger.last_hit;
+        if (!hit.breakpoint) {
+            auto it = watch_types.find(hit.id);
+            char type = it == watch_types.end() ? '2' : it->second;
+            const char* name = type == '3' ? "rwatch" : type == '4' ? "awatch" : "watch";
+            char reply[32];
+            std::snprintf(reply, sizeof(reply), "T05%s:%04x;", name, hit.addr);
+            return reply;
+        }
+        return "T05swbreak:;";
+    }
+
+    cpu.state = CPU_State::STOPPED;
+    return interrupted ? "S02" : "S05";
+}
+
+std::string GdbServer::monitor_command(const std::string& hex_command) {
+    std::string command;
+    for (size_t i = 0; i + 1 < hex_command.size(); i += 2) {
+        command += static_cast<char>(std::strtoul(hex_command.substr(i, 2).c_str(), nullptr, 16));
+    }
+
+    // monitor disas [addr [count]], GDB has no 65C02 disassembler of its own
+    std::string output;
+    if (command.rfind("disas", 0) == 0) {
+        char* end = nullptr;
+        word addr = cpu.PC;
+        int count = 10;
+        const char* args = command.c_str() + 5;
+        if (*args) {
+            unsigned long value = std::strtoul(args, &end, 16);
+            if (end != args) {
+                addr = value;
+                args = end;
+            }
+            long n = std::strtol(args, &end, 10);
+            if (end != args && n > 0) count = n;
+        }
+
+        char line[8 + DISASM_BUFFER];
+        for (int i = 0; i < count; ++i) {
+            std::snprintf(line, 8, "%04X  ", addr);
+            int length = disassemble(decoder, addr, line + 6);
+            output += line;
+            output += '\n';
+            addr += length;
+        }
+    } else {
+        output = "Commands: disas [addr [count]]\n";
+    }
+
+    std::string reply;
+    for (char c : output) reply += to_hex(static_cast<byte>(c), 1);
+    return reply;
+}
+
+std::string GdbServer::handle(const std::string& packet, bool& done) {
+    if (packet.empty()) return "";
+
+    switch (packet[0]) {
+        case '?':
+            return cpu.state == CPU_State::HALTED ? "W00" : "S05";
+
+        case 'g':
+            return read_registers();
+
+        case 'G': {
+            for (int reg = 0; reg < REG_COUNT; ++reg) {
+                size_t offset = 1 + 2 * reg;
+                if (offset + 2 > packet.size()) return "E01";
+                int bytes = reg == REG_PC ? 2 : 1;
+                write_register(reg, from_hex_le(packet.substr(offset, 2 * bytes)));
+            }
+            return "OK";
+        }
+
+        case 'p': {
+            int reg = std::strtol(packet.c_str() + 1, nullptr, 16);
+            if (reg < 0 || reg >= REG_COUNT) return "E01";
+            std::string regs = read_registers();
+            return reg == REG_PC ? regs.substr(2 * REG_PC, 4) : regs.substr(2 * reg, 2);
+        }
+
+        case 'P': {
+            size_t eq = packet.find('=');
+            if (eq == std::string::npos) return "E01";
+            int reg = std::strtol(packet.c_str() + 1, nullptr, 16);
+            return write_register(reg, from_hex_le(packet.substr(eq + 1))) ? "OK" : "E01";
+        }
+
+        case 'm': {
+            // m addr,length
+            char* end = nullptr;
+            uint32_t addr = std::strtoul(packet.c_str() + 1, &end, 16);
+            uint32_t length = (end && *end == ',') ? std::strtoul(end + 1, nullptr, 16) : 0;
+            std::string out;
+            for (uint32_t i = 0; i < length && addr + i <= 0xFFFF; ++i) {
+                // Reading a device register would consume its data (ACIA
+                // RX) or clear its flags (VIA), the reply stops short
+                if (decoder.is_device(addr + i)) break;
+                out += to_hex(decoder.read_unhooked(addr + i), 1);
+            }
+            return out.empty() ? "E01" : out;
+        }
+
+        case 'M': {
+            // M addr,length:XX...
+            char* end = nullptr;
+            uint32_t addr = std::strtoul(packet.c_str() + 1, &end, 16);
+            uint32_t length = (end && *end == ',') ? std::strtoul(end + 1, &end, 16) : 0;
+            if (!end || *end != ':') return "E01";
+            std::string data(end + 1);
+            // Nothing is written unless all of it can be
+            if (addr > 0xFFFF || length > 0x10000 - addr || data.size() < 2 * static_cast<size_t>(length)) return "E01";
+            for (uint32_t i = 0; i < length; ++i) {
+                decoder.write_unhooked(addr + i, std::strtoul(data.substr(2 * i, 2).c_str(), nullptr, 16));
+            }
+            return "OK";
+        }
+
+        case 'c':
+        case 's': {
+            if (packet.size() > 1) cpu.PC = std::strtoul(packet.c_str() + 1, nullptr, 16);
+            return run(packet[0] == 's');
+        }
+
+        case 'Z':
+        case 'z':
+            return packet.size() > 2 ? insert_point(packet.substr(1), packet[0] == 'Z') : "E01";
+
+        case 'H':
+            return "OK";  // Only one thread
+
+        case 'k':
+            done = true;
+            return "";
+
+        case 'D':
+            done = true;
+            return "OK";
+
+        case 'q':
+            if (packet.rfind("qSupported", 0) == 0) {
+                return "PacketSize=4000;qXfer:features:read+;QStartNoAckMode+;swbreak+;hwbreak+";
+            }
+            if (packet == "qAttached") return "1";
+            if (packet == "qC") return "QC1";
+            if (packet == "qfThreadInfo") return "m1";
+            if (packet == "qsThreadInfo") return "l";
+            if (packet.rfind("qRcmd,", 0) == 0) return monitor_command(packet.substr(6));
+            if (packet.rfind("qXfer:features:read:target.xml:", 0) == 0) {
+                // qXfer:features:read:target.xml:offset,length
+                char* end = nullptr;
+                size_t offset = std::strtoul(packet.c_str() + 31, &end, 16);
+                size_t length = (end && *end == ',') ? std::strtoul(end + 1, nullptr, 16) : 0;
+                std::string xml(TARGET_XML);
+                if (offset >= xml.size()) return "l";
+                std::string chunk = xml.substr(offset, length);
+                return (offset + chunk.size() >= xml.size() ? "l" : "m") + chunk;
+            }
+            return "";
+
+        case 'Q':
+            return packet == "QStartNoAckMode" ? "OK" : "";
+
+        default:
+            return "";
+    }
+}
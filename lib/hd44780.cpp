@@ -0,0 +1,303 @@
+#include "hd44780.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// Execution times from the datasheet (270kHz oscillator)
+static constexpr double CMD_US = 37.0;           // Most instructions
+static constexpr double CLEAR_HOME_US = 1520.0;  // Clear display / return home
+static constexpr double DATA_US = 41.0;          // Data reads and writes (37us + 4us address update)
+
+HD44780::HD44780(byte columns, byte rows, double cpu_clock_hz)
+    : columns(columns), rows(rows), clock_hz(cpu_clock_hz) {
+    reset();
+}
+
+HD44780::~HD44780() {
+    stop_rendering();
+}
+
+void HD44780::reset() {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    std::memset(ddram, 0x20, sizeof(ddram));
+    std::memset(cgram, 0x00, sizeof(cgram));
+    ac = 0;
+    ac_cgram = false;
+    increment = true;
+    shift_display = false;
+    display_on = cursor_on = blink_on = false;
+    eight_bit = true;
+    two_lines = false;
+    display_shift = 0;
+    busy_until = 0;
+    nibble_pending = read_low_nibble = false;
+    dirty.store(true);
+}
+
+void HD44780::set_busy(double us) {
+    busy_until = now() + static_cast<uint64_t>(clock_hz * us / 1e6);
+}
+
+bool HD44780::busy() {
+    return now() < busy_until;
+}
+
+int HD44780::ddram_index(byte address) const {
+    if (!two_lines) return address % 80;
+    // Two lines: 0x00-0x27 and 0x40-0x67
+    return (address & 0x40 ? 40 : 0) + (address & 0x3F) % 40;
+}
+
+int HD44780::visible_index(byte row, byte col) const {
+    if (!two_lines) {
+        if (row != 0) return -1;
+        return ((col + display_shift) % 80 + 80) % 80;
+    }
+    // Rows 2 and 3 of a 4 line module continue lines 0 and 1
+    int line = row & 1;
+    int offset = (row >> 1) * columns + col + display_shift;
+    return line * 40 + (offset % 40 + 40) % 40;
+}
+
+void HD44780::step_address() {
+    if (ac_cgram) {
+        ac = (ac + (increment ? 1 : -1)) & 0x3F;
+        return;
+    }
+
+    if (!two_lines) {
+        ac = increment ? (ac + 1) % 80 : (ac + 79) % 80;
+    } else if (increment) {
+        // 0x27 continues at 0x40 and 0x67 wraps back to 0x00
+        ac = ac == 0x27 ? 0x40 : ac == 0x67 ? 0x00 : ac + 1;
+    } else {
+        ac = ac == 0x40 ? 0x27 : ac == 0x00 ? 0x67 : ac - 1;
+    }
+}
+
+HD44780::View HD44780::view() const {
+    int cursor = (cursor_on || blink_on) && !ac_cgram ? ddram_index(ac) : -1;
+    return {display_on, two_lines, cursor, display_shift};
+}
+
+bool HD44780::instruction(byte data) {
+    double us = CMD_US;
+    bool changed = false;
+
+    if (data & 0x80) {
+        // Set DDRAM address
+        ac = data & 0x7F;
+        ac_cgram = false;
+    } else if (data & 0x40) {
+        // Set CGRAM address
+        ac = data & 0x3F;
+        ac_cgram = true;
+    } else if (data & 0x20) {
+        // Function set
+        eight_bit = data & 0x10;
+        two_lines = data & 0x08;
+        nibble_pending = false;
+    } else if (data & 0x10) {
+        // Cursor or display shift
+        if (data & 0x08) {
+            display_shift += (data & 0x04) ? -1 : 1;
+        } else {
+            bool saved = increment;
+            increment = data & 0x04;
+            step_address();
+            increment = saved;
+        }
+    } else if (data & 0x08) {
+        // Display on/off control
+        display_on = data & 0x04;
+        cursor_on = data & 0x02;
+        blink_on = data & 0x01;
+    } else if (data & 0x04) {
+        // Entry mode set
+        increment = data & 0x02;
+        shift_display = data & 0x01;
+    } else if (data & 0x02) {
+        // Return home
+        ac = 0;
+        ac_cgram = false;
+        display_shift = 0;
+        us = CLEAR_HOME_US;
+    } else if (data & 0x01) {
+        // Clear display
+        changed = std::any_of(ddram, ddram + sizeof(ddram), [](byte code) { return code != 0x20; });
+        std::memset(ddram, 0x20, sizeof(ddram));
+        ac = 0;
+        ac_cgram = false;
+        increment = true;
+        display_shift = 0;
+        us = CLEAR_HOME_US;
+    }
+
+    set_busy(us);
+    return changed;
+}
+
+void HD44780::execute(bool rs, byte data) {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    View before = view();
+    bool changed = false;  // DDRAM contents
+
+    if (!rs) {
+        changed = instruction(data);
+    } else {
+        if (ac_cgram) {
+            cgram[ac & 0x3F] = data;  // Custom characters are drawn as placeholders
+        } else {
+            byte& cell = ddram[ddram_index(ac)];
+            changed = cell != data;
+            cell = data;
+            if (shift_display) display_shift += increment ? 1 : -1;
+        }
+        step_address();
+        set_busy(DATA_US);
+    }
+
+    // Rewriting what is already shown doesn't cost a frame
+    if (changed || view() != before) dirty.store(true, std::memory_order_release);
+}
+
+byte HD44780::fetch(bool rs) {
+    if (!rs) return (busy() ? 0x80 : 0x00) | (ac & 0x7F);
+
+    std::lock_guard<std::mutex> lock(state_mutex);
+    View before = view();
+    byte value = ac_cgram ? cgram[ac & 0x3F] : ddram[ddram_index(ac)];
+    step_address();
+    set_busy(DATA_US);
+    if (view() != before) dirty.store(true, std::memory_order_release);  // The cursor moved
+    return value;
+}
+
+void HD44780::write_bus(bool rs, byte data) {
+    if (eight_bit) {
+        execute(rs, data);
+    } else if (!nibble_pending) {
+        nibble_high = data & 0xF0;
+        nibble_pending = true;
+    } else {
+        nibble_pending = false;
+        execute(rs, nibble_high | (data >> 4));
+    }
+}
+
+byte HD44780::read_bus(bool rs) {
+    if (eight_bit) return fetch(rs);
+
+    // The byte is read once, then handed out on D7-D4 in two halves
+    if (!read_low_nibble) {
+        read_value = fetch(rs);
+        read_low_nibble = true;
+        return read_value & 0xF0;
+    }
+    read_low_nibble = false;
+    return (read_value << 4) & 0xF0;
+}
+
+byte HD44780::char_at(byte row, byte col) const {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    int index = visible_index(row, col);
+    return index < 0 ? 0x20 : ddram[index];
+}
+
+bool HD44780::present(std::ostream& out, bool force) {
+    auto now = std::chrono::steady_clock::now();
+    if (!force && (!dirty.load(std::memory_order_acquire) || now - last_frame < frame_interval)) return false;
+
+    last_frame = now;
+    dirty.store(false, std::memory_order_relaxed);
+
+    // Build the whole frame under the lock, write it out after
+    std::string frame;
+    if (drawn) frame += "\033[" + std::to_string(rows + 2) + "F";  // Back to the top of the last frame
+    std::string border = "+" + std::string(columns, '-') + "+\033[K\n";
+    frame += border;
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        int cursor = view().cursor;
+        for (byte row = 0; row < rows; ++row) {
+            frame += "|";
+            for (byte col = 0; col < columns; ++col) {
+                int index = visible_index(row, col);
+                byte code = index < 0 ? 0x20 : ddram[index];
+                char glyph = ' ';
+                if (display_on) {
+                    if (code < 0x10) {
+                        glyph = '#';  // Custom CGRAM character
+                    } else if (code >= 0x20 && code < 0x7F) {
+                        glyph = static_cast<char>(code);
+                    } else {
+                        glyph = '?';
+                    }
+                }
+                if (display_on && index >= 0 && index == cursor) {
+                    frame += "\033[4m";
+                    frame += glyph;
+                    frame += "\033[0m";
+                } else {
+                    frame += glyph;
+                }
+            }
+            frame += "|\033[K\n";
+        }
+    }
+    frame += border;
+
+    out << frame << std::flush;
+    drawn = true;
+    return true;
+}
+
+void HD44780::start_rendering() {
+    if (rendering.exchange(true)) return;
+
+    render_thread = std::thread([this]() {
+        while (rendering.load()) {
+            present(std::cout);
+            std::this_thread::sleep_for(frame_interval);
+        }
+    });
+}
+
+void HD44780::stop_rendering() {
+    if (rendering.exchange(false)) {
+        render_thread.join();
+    }
+}
+
+void HD44780_ViaAdapter::port_written(ViaPort port, byte value, byte ddr) {
+    // Pins configured as inputs float high
+    byte levels = (value & ddr) | static_cast<byte>(~ddr);
+
+    if (port == data_port) data = levels;
+    if (port != control_port) return;
+
+    byte previous = control;
+    control = levels;
+    bool rs = control & rs_mask;
+    bool read = control & rw_mask;
+
+    if (read && !(previous & e_mask) && (control & e_mask)) {
+        // The LCD drives the data pins while E is high during a read
+        read_latch = lcd.read_bus(rs);
+    } else if (!read && (previous & e_mask) && !(control & e_mask)) {
+        // Writes are latched on the falling edge of E
+        byte bus = nibble_shift < 0 ? data : static_cast<byte>(((data >> nibble_shift) & 0x0F) << 4);
+        lcd.write_bus(rs, bus);
+    }
+}
+
+byte HD44780_ViaAdapter::port_read(ViaPort port) {
+    if (port != data_port) return 0xFF;
+    if (!(control & e_mask) || !(control & rw_mask)) return 0xFF;  // Not driving the bus
+
+    if (nibble_shift < 0) return read_latch;
+    byte mask = static_cast<byte>(0x0F << nibble_shift);
+    return static_cast<byte>(((read_latch >> 4) << nibble_shift) & mask) | static_cast<byte>(~mask);
+}
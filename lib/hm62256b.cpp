@@ -2,9 +2,11 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstring>
 #include <thread>
 
 #include "log.h"
+#include "metrics.h"
 
 // Static thread management variables
 static std::thread sram_thread;
@@ -134,6 +136,29 @@ void HM62256B::write_byte(byte addr, byte data) {
     memory[addr] = data;
 }
 
+const byte* HM62256B::read_span(word offset, size_t& length) {
+    if (offset >= 32 * 1024) {
+        return nullptr;  // Out of bounds
+    }
+    length = 32 * 1024 - offset;
+    return memory + offset;
+}
+
+byte* HM62256B::write_span(word offset, size_t& length) {
+    if (offset >= 32 * 1024) {
+        return nullptr;  // Out of bounds
+    }
+    length = 32 * 1024 - offset;
+    return memory + offset;
+}
+
+void HM62256B::use_storage(byte* external) {
+    byte* target = external ? external : storage;
+    if (target == memory) return;
+    std::memcpy(target, memory, sizeof(storage));
+    memory = target;
+}
+
 void HM62256B::attach_to_bus(Bus& new_bus) {
     this->bus = new_bus;
 }
@@ -158,6 +183,8 @@ void HM62256B::start_monitoring() {
         bool prev_oe = OE;
 
         while (sram_running.load()) {
+            if (metrics::enabled.load(std::memory_order_relaxed)) metrics::add(metrics::MONITOR_WAKEUPS);
+
             // Only process if pins have changed or chip is active
             bool pins_changed = (prev_cs != CS || prev_we != WE || prev_oe != OE);
             (void)pins_changed;  // Avoid unused variable warning
@@ -0,0 +1,164 @@
+#include "m6502.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <vector>
+
+#include "at28c256.h"
+#include "bus.h"
+#include "decoder.h"
+#include "hm62256b.h"
+#include "log.h"
+#include "wdc65c02.h"
+
+static_assert(M6502_STATE_RUNNING == static_cast<int>(CPU_State::RUNNING), "m6502_state must match CPU_State");
+static_assert(M6502_STATE_STOPPED == static_cast<int>(CPU_State::STOPPED), "m6502_state must match CPU_State");
+
+// The board's memory map without devices
+struct m6502 {
+    Bus bus;
+    HM62256B ram{bus};
+    AT28C256 rom{bus};
+    AddressDecoder decoder;
+    WDC65C02 cpu{bus, &decoder};
+
+    m6502() {
+        decoder.add_mapping(0x0000, 0x7FFF, &ram);
+        decoder.add_mapping(0x8000, 0xFFFF, &rom);
+        rom.attach_cycle_counter(&cpu.cycles);  // ROM writes start a write cycle (timed at 1MHz)
+    }
+};
+
+static bool logging = false;  // The core logs to stdout, the embedding program decides
+
+unsigned m6502_api_version(void) { return M6502_API_VERSION; }
+
+m6502* m6502_create(void) {
+    logger::enabled = logging;
+    return new (std::nothrow) m6502();
+}
+
+void m6502_destroy(m6502* machine) { delete machine; }
+
+int m6502_load(m6502* machine, uint16_t addr, const uint8_t* data, size_t size) {
+    if (size > 0x10000u - addr) return -1;
+
+    // The RAM part, then the ROM part (loaded without a write cycle)
+    size_t ram_size = addr < 0x8000 ? std::min<size_t>(size, 0x8000 - addr) : 0;
+    if (ram_size) std::memcpy(machine->ram.memory + addr, data, ram_size);
+    if (size > ram_size) {
+        word offset = addr + ram_size - 0x8000;
+        machine->rom.load(data + ram_size, size - ram_size, offset);
+    }
+    return 0;
+}
+
+int m6502_load_file(m6502* machine, uint16_t addr, const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return -1;
+    std::vector<uint8_t> image((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return m6502_load(machine, addr, image.data(), image.size());
+}
+
+void m6502_reset(m6502* machine) {
+    WDC65C02& cpu = machine->cpu;
+    cpu.reset();
+
+    // The reset vector through the decoder, `reset()` reads it off the bus pins
+    cpu.PC = machine->decoder.read(0xFFFC) | (machine->decoder.read(0xFFFD) << 8);
+    cpu.state = CPU_State::RUNNING;
+}
+
+uint64_t m6502_run(m6502* machine, uint64_t cycles) {
+    WDC65C02& cpu = machine->cpu;
+    uint64_t start = cpu.cycles;
+    while (cpu.state == CPU_State::RUNNING && cpu.cycles - start < cycles) cpu.step();
+    return cpu.cycles - start;
+}
+
+uint64_t m6502_step(m6502* machine) {
+    uint64_t start = machine->cpu.cycles;
+    machine->cpu.step();
+    return machine->cpu.cycles - start;
+}
+
+m6502_state m6502_get_state(const m6502* machine) { return static_cast<m6502_state>(machine->cpu.state); }
+
+void m6502_set_state(m6502* machine, m6502_state state) { machine->cpu.state = static_cast<CPU_State>(state); }
+
+uint64_t m6502_cycles(const m6502* machine) { return machine->cpu.cycles; }
+
+uint16_t m6502_get_register(const m6502* machine, m6502_register reg) {
+    const WDC65C02& cpu = machine->cpu;
+    switch (reg) {
+        case M6502_REG_A:
+            return cpu.A;
+        case M6502_REG_X:
+            return cpu.X;
+        case M6502_REG_Y:
+            return cpu.Y;
+        case M6502_REG_SP:
+            return cpu.SP;
+        case M6502_REG_PC:
+            return cpu.PC;
+        case M6502_REG_FLAGS:
+            return cpu.FLAGS;
+    }
+    return 0;
+}
+
+void m6502_set_register(m6502* machine, m6502_register reg, uint16_t value) {
+    WDC65C02& cpu = machine->cpu;
+    switch (reg) {
+        case M6502_REG_A:
+            cpu.A = value;
+            break;
+        case M6502_REG_X:
+            cpu.X = value;
+            break;
+        case M6502_REG_Y:
+            cpu.Y = value;
+            break;
+        case M6502_REG_SP:
+            cpu.SP = value;
+            break;
+        case M6502_REG_PC:
+            cpu.PC = value;
+            break;
+        case M6502_REG_FLAGS:
+            cpu.FLAGS = value;
+            break;
+    }
+    cpu.reset_idle_detection();
+}
+
+void m6502_set_irq(m6502* machine, int level) { machine->cpu.IRQB = level ? 1 : 0; }
+
+void m6502_set_nmi(m6502* machine, int level) { machine->cpu.NMIB = level ? 1 : 0; }
+
+uint8_t m6502_read(m6502* machine, uint16_t addr) { return machine->decoder.read(addr); }
+
+void m6502_write(m6502* machine, uint16_t addr, uint8_t value) { machine->decoder.write(addr, value); }
+
+const uint8_t* m6502_view(m6502* machine, uint16_t addr, size_t* length) {
+    size_t available = 0;
+    const uint8_t* view = machine->decoder.read_span(addr, available);
+    if (length) *length = view ? available : 0;
+    return view;
+}
+
+uint8_t* m6502_view_mut(m6502* machine, uint16_t addr, size_t* length) {
+    // The EEPROM has no write span, stores to it need a write cycle
+    size_t available = 0;
+    uint8_t* view = machine->decoder.write_span(addr, available);
+    if (length) *length = view ? available : 0;
+    return view;
+}
+
+void m6502_set_logging(int enabled) {
+    logging = enabled != 0;
+    logger::enabled = logging;
+}
@@ -0,0 +1,67 @@
+#include "metrics.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace metrics {
+
+// Every shard ever handed out, and the ones whose threads have exited
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<Shard>> shards;
+static std::vector<Shard*> free_shards;
+
+// Hands the thread's shard back when the thread exits
+struct ShardRelease {
+    Shard* owned = nullptr;
+    ~ShardRelease() {
+        if (owned == nullptr) return;
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        free_shards.push_back(owned);
+        shard = nullptr;
+    }
+};
+
+Shard* register_thread() {
+    static thread_local ShardRelease release;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    if (!free_shards.empty()) {
+        shard = free_shards.back();
+        free_shards.pop_back();
+    } else {
+        shards.push_back(std::make_unique<Shard>());
+        shard = shards.back().get();
+    }
+    release.owned = shard;
+    return shard;
+}
+
+void record_bus_wait(uint64_t ns) {
+    Shard& s = local();
+    unsigned bucket = 0;
+    while (bucket < WAIT_BUCKETS - 1 && ns > WAIT_BOUNDS_US[bucket] * 1000) bucket++;
+    bump(s.bus_wait[bucket]);
+    bump(s.bus_wait_ns, ns);
+}
+
+Totals collect() {
+    Totals totals;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& s : shards) {
+        for (unsigned i = 0; i < COUNTERS; ++i) totals.counters[i] += s->counters[i].load(std::memory_order_relaxed);
+        for (unsigned i = 0; i < 256; ++i) totals.opcodes[i] += s->opcodes[i].load(std::memory_order_relaxed);
+        for (unsigned i = 0; i < WAIT_BUCKETS; ++i) totals.bus_wait[i] += s->bus_wait[i].load(std::memory_order_relaxed);
+        totals.bus_wait_ns += s->bus_wait_ns.load(std::memory_order_relaxed);
+    }
+    totals.threads = shards.size();
+    return totals;
+}
+
+uint64_t Totals::instructions() const {
+    uint64_t sum = 0;
+    for (uint64_t count : opcodes) sum += count;
+    return sum;
+}
+
+}  // namespace metrics
@@ -0,0 +1,186 @@
+#include "metrics_writer.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+#include "instructions.h"
+#include "log.h"
+
+// Names of the counters in both formats
+static const char* const COUNTER_NAMES[metrics::COUNTERS] = {
+    "cycles", "bus_timeouts", "unmapped_reads", "unmapped_writes", "monitor_wakeups",
+};
+
+static bool ends_with(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+MetricsWriter::MetricsWriter(const std::string& path, std::chrono::milliseconds interval)
+    : path(path), format(ends_with(path, ".json") ? Format::JSON : Format::PROMETHEUS), interval(interval) {}
+
+MetricsWriter::~MetricsWriter() {
+    stop();
+}
+
+void MetricsWriter::start() {
+    if (thread.joinable()) return;
+
+    metrics::enabled.store(true, std::memory_order_relaxed);
+    last_time = std::chrono::steady_clock::now();
+    last_cycles = metrics::collect().counters[metrics::CYCLES];
+    running = true;
+    thread = std::thread(&MetricsWriter::run, this);
+}
+
+void MetricsWriter::stop() {
+    if (!thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake.notify_one();
+    thread.join();
+    write();  // The counts up to the end of the run
+}
+
+void MetricsWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, interval, [this]() { return !running; })) {
+        lock.unlock();
+        write();
+        lock.lock();
+    }
+}
+
+bool MetricsWriter::write() {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    metrics::Totals totals = metrics::collect();
+
+    // Clock rate since the previous write
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - last_time).count();
+    uint64_t cycles = totals.counters[metrics::CYCLES];
+    if (seconds > 0) effective_hz = (cycles - last_cycles) / seconds;
+    last_time = now;
+    last_cycles = cycles;
+
+    // Written aside and renamed, readers see the old file or the new one
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        if (!out) {
+            logger::error("Cannot write metrics to " + temporary + ": " + std::strerror(errno));
+            return false;
+        }
+        out << std::setprecision(12);
+        if (format == Format::JSON) {
+            write_json(out, totals);
+        } else {
+            write_prometheus(out, totals);
+        }
+        if (!out.flush()) {
+            logger::error("Cannot write metrics to " + temporary);
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        logger::error("Cannot replace " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void MetricsWriter::write_json(std::ostream& out, const metrics::Totals& totals) const {
+    uint64_t waits = 0;
+    for (uint64_t count : totals.bus_wait) waits += count;
+
+    out << "{\n";
+    out << "  \"threads\": " << totals.threads << ",\n";
+    out << "  \"instructions\": " << totals.instructions() << ",\n";
+    out << "  \"clock\": {\"configured_hz\": " << configured_hz << ", \"effective_hz\": " << effective_hz
+        << ", \"ratio\": " << (configured_hz > 0 ? effective_hz / configured_hz : 0) << "},\n";
+    for (unsigned i = 0; i < metrics::COUNTERS; ++i) {
+        if (i == metrics::BUS_TIMEOUTS) continue;  // Goes with the bus below
+        out << "  \"" << COUNTER_NAMES[i] << "\": " << totals.counters[i] << ",\n";
+    }
+
+    out << "  \"bus\": {\"waits\": " << waits << ", \"wait_ns\": " << totals.bus_wait_ns
+        << ", \"timeouts\": " << totals.counters[metrics::BUS_TIMEOUTS] << ", \"wait_histogram_us\": {";
+    for (unsigned i = 0; i < metrics::WAIT_BUCKETS; ++i) {
+        if (i > 0) out << ", ";
+        if (i < metrics::WAIT_BUCKETS - 1) {
+            out << "\"" << metrics::WAIT_BOUNDS_US[i] << "\": ";
+        } else {
+            out << "\"+Inf\": ";
+        }
+        out << totals.bus_wait[i];
+    }
+    out << "}},\n";
+
+    // Only the opcodes that ran
+    out << "  \"opcodes\": [";
+    bool first = true;
+    for (unsigned op = 0; op < 256; ++op) {
+        if (totals.opcodes[op] == 0) continue;
+        out << (first ? "\n" : ",\n") << "    {\"opcode\": \"0x" << std::hex << std::uppercase << std::setw(2)
+            << std::setfill('0') << op << std::dec << std::nouppercase << "\", \"mnemonic\": \""
+            << INSTRUCTIONS[op].mnemonic << "\", \"count\": " << totals.opcodes[op] << "}";
+        first = false;
+    }
+    out << (first ? "]\n" : "\n  ]\n");
+    out << "}\n";
+}
+
+void MetricsWriter::write_prometheus(std::ostream& out, const metrics::Totals& totals) const {
+    auto header = [&out](const char* name, const char* type, const char* help) {
+        out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    };
+
+    header("m6502_instructions_total", "counter", "Instructions run by the CPU.");
+    out << "m6502_instructions_total " << totals.instructions() << "\n";
+    header("m6502_cycles_total", "counter", "Clock cycles run by the CPU.");
+    out << "m6502_cycles_total " << totals.counters[metrics::CYCLES] << "\n";
+
+    header("m6502_clock_configured_hz", "gauge", "Clock speed the emulator is configured for.");
+    out << "m6502_clock_configured_hz " << configured_hz << "\n";
+    header("m6502_clock_effective_hz", "gauge", "Clock rate reached over the last interval.");
+    out << "m6502_clock_effective_hz " << effective_hz << "\n";
+
+    header("m6502_bus_wait_seconds", "histogram", "Time waited to acquire the bus.");
+    uint64_t cumulative = 0;
+    for (unsigned i = 0; i < metrics::WAIT_BUCKETS; ++i) {
+        cumulative += totals.bus_wait[i];
+        out << "m6502_bus_wait_seconds_bucket{le=\"";
+        if (i < metrics::WAIT_BUCKETS - 1) {
+            out << metrics::WAIT_BOUNDS_US[i] * 1e-6;
+        } else {
+            out << "+Inf";
+        }
+        out << "\"} " << cumulative << "\n";
+    }
+    out << "m6502_bus_wait_seconds_sum " << totals.bus_wait_ns * 1e-9 << "\n";
+    out << "m6502_bus_wait_seconds_count " << cumulative << "\n";
+    header("m6502_bus_timeouts_total", "counter", "Bus requests that timed out.");
+    out << "m6502_bus_timeouts_total " << totals.counters[metrics::BUS_TIMEOUTS] << "\n";
+
+    header("m6502_decoder_unmapped_total", "counter", "Decoder accesses to unmapped addresses.");
+    out << "m6502_decoder_unmapped_total{access=\"read\"} " << totals.counters[metrics::UNMAPPED_READS] << "\n";
+    out << "m6502_decoder_unmapped_total{access=\"write\"} " << totals.counters[metrics::UNMAPPED_WRITES] << "\n";
+
+    header("m6502_monitor_wakeups_total", "counter", "Iterations of the memory chips' bus monitoring threads.");
+    out << "m6502_monitor_wakeups_total " << totals.counters[metrics::MONITOR_WAKEUPS] << "\n";
+
+    header("m6502_metric_threads", "gauge", "Threads that have counted metrics.");
+    out << "m6502_metric_threads " << totals.threads << "\n";
+
+    header("m6502_opcode_instructions_total", "counter", "Instructions run, by opcode.");
+    for (unsigned op = 0; op < 256; ++op) {
+        if (totals.opcodes[op] == 0) continue;
+        out << "m6502_opcode_instructions_total{opcode=\"0x" << std::hex << std::uppercase << std::setw(2)
+            << std::setfill('0') << op << std::dec << std::nouppercase << "\",mnemonic=\"" << INSTRUCTIONS[op].mnemonic
+            << "\"} " << totals.opcodes[op] << "\n";
+    }
+}
@@ -0,0 +1,204 @@
+#include "pin_checker.h"
+
+#include <iomanip>
+
+// Address and data pins of the SRAM, control pins are set by the caller
+static void drive_address(HM62256B& chip, word addr) {
+    chip.A0 = (addr >> 0) & 1;
+    chip.A1 = (addr >> 1) & 1;
+    chip.A2 = (addr >> 2) & 1;
+    chip.A3 = (addr >> 3) & 1;
+    chip.A4 = (addr >> 4) & 1;
+    chip.A5 = (addr >> 5) & 1;
+    chip.A6 = (addr >> 6) & 1;
+    chip.A7 = (addr >> 7) & 1;
+    chip.A8 = (addr >> 8) & 1;
+    chip.A9 = (addr >> 9) & 1;
+    chip.A10 = (addr >> 10) & 1;
+    chip.A11 = (addr >> 11) & 1;
+    chip.A12 = (addr >> 12) & 1;
+    chip.A13 = (addr >> 13) & 1;
+    chip.A14 = (addr >> 14) & 1;
+}
+
+static void drive_data(HM62256B& chip, byte data) {
+    chip.IO0 = (data >> 0) & 1;
+    chip.IO1 = (data >> 1) & 1;
+    chip.IO2 = (data >> 2) & 1;
+    chip.IO3 = (data >> 3) & 1;
+    chip.IO4 = (data >> 4) & 1;
+    chip.IO5 = (data >> 5) & 1;
+    chip.IO6 = (data >> 6) & 1;
+    chip.IO7 = (data >> 7) & 1;
+}
+
+// Address pins of the EEPROM
+static void drive_address(AT28C256& chip, word addr) {
+    chip.A_0 = (addr >> 0) & 1;
+    chip.A_1 = (addr >> 1) & 1;
+    chip.A_2 = (addr >> 2) & 1;
+    chip.A_3 = (addr >> 3) & 1;
+    chip.A_4 = (addr >> 4) & 1;
+    chip.A_5 = (addr >> 5) & 1;
+    chip.A_6 = (addr >> 6) & 1;
+    chip.A_7 = (addr >> 7) & 1;
+    chip.A_8 = (addr >> 8) & 1;
+    chip.A_9 = (addr >> 9) & 1;
+    chip.A_10 = (addr >> 10) & 1;
+    chip.A_11 = (addr >> 11) & 1;
+    chip.A_12 = (addr >> 12) & 1;
+    chip.A_13 = (addr >> 13) & 1;
+    chip.A_14 = (addr >> 14) & 1;
+}
+
+PinChecker::PinChecker(Bus& bus, const AddressDecoder& decoder, double fraction) : bus(bus), decoder(decoder) {
+    set_sample_rate(fraction);
+}
+
+void PinChecker::set_sample_rate(double fraction) {
+    if (fraction <= 0) {
+        threshold = 0;
+    } else if (fraction >= 1) {
+        threshold = 1ULL << 32;  // Above every 32 bit random number
+    } else {
+        threshold = static_cast<uint64_t>(fraction * 4294967296.0);
+    }
+}
+
+void PinChecker::add_chip(word start, word end, HM62256B& sram) { chips.push_back({start, end, &sram, nullptr}); }
+
+void PinChecker::add_chip(word start, word end, AT28C256& eeprom) { chips.push_back({start, end, nullptr, &eeprom}); }
+
+bool PinChecker::sample() {
+    accesses++;
+    if (threshold == 0) return false;
+
+    // xorshift32
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    return random < threshold;
+}
+
+const PinChecker::Chip* PinChecker::find(word addr) const {
+    for (const Chip& chip : chips) {
+        if (addr < chip.start || addr > chip.end) continue;
+
+        // A device mapped over the chip answers instead
+        const MEM_Module* module = chip.sram ? static_cast<const MEM_Module*>(chip.sram) : chip.eeprom;
+        return decoder.module_at(addr) == module ? &chip : nullptr;
+    }
+    return nullptr;
+}
+
+byte PinChecker::pin_read(const Chip& chip, word offset) {
+    // The chip drives the bus, poison it first so a chip that stays silent
+    // shows up as a mismatch instead of leaving the previous byte in place
+    byte poison = ~bus.read_data();
+    if (bus.request_bus(BusOwner::MEMORY)) {
+        bus.write_data(poison);
+        bus.release_bus(BusOwner::MEMORY);
+    }
+
+    if (chip.sram) {
+        HM62256B& sram = *chip.sram;
+        pinl_t saved = sram.PINS;
+        drive_address(sram, offset);
+        sram.CS = 0;
+        sram.OE = 0;
+        sram.WE = 1;
+        sram.write_to_bus();
+        sram.PINS = saved;
+    } else {
+        AT28C256& eeprom = *chip.eeprom;
+        pinl_t saved = eeprom.PINS;
+        drive_address(eeprom, offset);
+        eeprom.CE = 0;
+        eeprom.OE = 0;
+        eeprom.WE = 1;
+        eeprom.write_to_bus();
+        eeprom.PINS = saved;
+    }
+    return bus.read_data();
+}
+
+void PinChecker::pin_write(const Chip& chip, word offset, byte value) {
+    HM62256B& sram = *chip.sram;
+    pinl_t saved = sram.PINS;
+    drive_address(sram, offset);
+    drive_data(sram, value);
+    sram.CS = 0;
+    sram.OE = 1;
+    sram.WE = 0;
+    sram.read_from_bus();
+    sram.PINS = saved;
+}
+
+void PinChecker::record(word addr, byte fast, byte pin, bool write) {
+    mismatch_count++;
+    if (mismatches.size() < MAX_RECORDED) {
+        mismatches.push_back({cycle_counter ? *cycle_counter : 0, addr, fast, pin, write});
+    }
+}
+
+void PinChecker::check_read(word addr, byte value) {
+    if (!sample()) return;
+    const Chip* chip = find(addr);
+    if (chip == nullptr) return;  // Not a memory chip (I/O devices have no pin path)
+
+    // Status reads during an EEPROM write cycle toggle bits, a second read
+    // would legitimately differ
+    if (chip->eeprom && chip->eeprom->is_busy()) {
+        skipped++;
+        return;
+    }
+
+    sampled_reads++;
+    byte pin = pin_read(*chip, addr - chip->start);
+    if (pin != value) record(addr, value, pin, false);
+}
+
+void PinChecker::check_write(word addr, byte value) {
+    if (!sample()) return;
+    const Chip* chip = find(addr);
+    if (chip == nullptr) return;
+
+    // Repeating an EEPROM write would start another load window
+    if (chip->eeprom) {
+        skipped++;
+        return;
+    }
+
+    sampled_writes++;
+    word offset = addr - chip->start;
+
+    // The fast write must be visible on the pins
+    byte pin = pin_read(*chip, offset);
+    if (pin != value) {
+        record(addr, value, pin, true);
+        return;
+    }
+
+    // And the same write through the pins must store the same byte
+    pin_write(*chip, offset, value);
+    byte stored = chip->sram->memory[offset];
+    if (stored != value) record(addr, value, stored, true);
+}
+
+void PinChecker::report(std::ostream& out) const {
+    out << "Pin check: " << sampled_reads << " reads and " << sampled_writes << " writes sampled of " << accesses
+        << " accesses, " << skipped << " skipped, " << mismatch_count << " mismatches\n";
+
+    std::ios_base::fmtflags flags = out.flags();
+    char fill = out.fill();
+    for (const Mismatch& m : mismatches) {
+        out << "  cycle " << std::dec << m.cycle << (m.write ? " write $" : " read $") << std::hex << std::uppercase
+            << std::setfill('0') << std::setw(4) << m.addr << ": fast $" << std::setw(2) << static_cast<int>(m.fast)
+            << " pin $" << std::setw(2) << static_cast<int>(m.pin) << "\n";
+    }
+    if (mismatch_count > mismatches.size()) {
+        out << "  ... " << std::dec << mismatch_count - mismatches.size() << " more\n";
+    }
+    out.flags(flags);
+    out.fill(fill);
+}
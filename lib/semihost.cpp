@@ -0,0 +1,176 @@
+#include "semihost.h"
+
+#include <fstream>
+#include <vector>
+
+#include "log.h"
+
+Semihost::Semihost(AddressDecoder& decoder, std::ostream& console) : decoder(decoder), console(&console) {}
+
+byte Semihost::io_read(word reg) {
+    reg &= 0x0F;
+    switch (reg) {
+        case COMMAND:
+            return (error ? STATUS_ERROR : 0) | (exited ? STATUS_EXITED : 0);
+        case DATA:
+            return data;
+        case PTR_LO:
+            return pointer & 0xFF;
+        case PTR_HI:
+            return pointer >> 8;
+        case BUF_LO:
+            return buffer & 0xFF;
+        case BUF_HI:
+            return buffer >> 8;
+        case LEN_LO:
+            return length & 0xFF;
+        case LEN_HI:
+            return length >> 8;
+        default:
+            return (result >> ((reg - RESULT) * 8)) & 0xFF;
+    }
+}
+
+void Semihost::io_write(word reg, byte value) {
+    switch (reg & 0x0F) {
+        case COMMAND:
+            break;  // Below
+        case DATA:
+            data = value;
+            return;
+        case PTR_LO:
+            pointer = (pointer & 0xFF00) | value;
+            return;
+        case PTR_HI:
+            pointer = (pointer & 0x00FF) | (value << 8);
+            return;
+        case BUF_LO:
+            buffer = (buffer & 0xFF00) | value;
+            return;
+        case BUF_HI:
+            buffer = (buffer & 0x00FF) | (value << 8);
+            return;
+        case LEN_LO:
+            length = (length & 0xFF00) | value;
+            return;
+        case LEN_HI:
+            length = (length & 0x00FF) | (value << 8);
+            return;
+        default:
+            return;  // RESULT is read only
+    }
+
+    error = false;
+    switch (value) {
+        case CMD_PUTC:
+            console->put(static_cast<char>(data));
+            if (data == '\n') console->flush();
+            break;
+
+        case CMD_PRINT:
+            print();
+            break;
+
+        case CMD_EXIT:
+            exited = true;
+            code = data;
+            console->flush();
+            if (exit_handler) exit_handler(code);
+            break;
+
+        case CMD_READ_FILE:
+            read_file();
+            break;
+
+        case CMD_WRITE_FILE:
+            write_file();
+            break;
+
+        case CMD_CYCLES:
+            result = now();
+            break;
+
+        default:
+            error = true;
+            break;
+    }
+}
+
+void Semihost::print() {
+    // The string is gathered first so it reaches the console in one write
+    std::string text;
+    word addr = pointer;
+    if (length) {
+        for (word i = 0; i < length; ++i) text += static_cast<char>(decoder.read(addr++));
+    } else {
+        for (byte c; (c = decoder.read(addr)) != 0 && text.size() < 0x10000; ++addr) text += static_cast<char>(c);
+    }
+    console->write(text.data(), text.size());
+    console->flush();
+    result = text.size();
+}
+
+std::string Semihost::file_path() {
+    if (file_root.empty()) {
+        logger::error("Semihosting: file access is off (no file root set)");
+        return "";
+    }
+
+    std::string name;
+    word addr = pointer;
+    for (byte c; (c = decoder.read(addr)) != 0; ++addr) {
+        if (name.size() == MAX_NAME) return "";
+        name += static_cast<char>(c);
+    }
+
+    // Relative names below the root only
+    bool escapes = name.empty() || name[0] == '/';
+    size_t start = 0;
+    while (!escapes && start <= name.size()) {
+        size_t end = name.find('/', start);
+        if (end == std::string::npos) end = name.size();
+        if (name.compare(start, end - start, "..") == 0 && end - start == 2) escapes = true;
+        start = end + 1;
+    }
+    if (escapes) {
+        logger::error("Semihosting: refused file name \"" + name + "\"");
+        return "";
+    }
+    return file_root + "/" + name;
+}
+
+void Semihost::read_file() {
+    std::string path = file_path();
+    std::ifstream file(path, std::ios::binary);
+    if (path.empty() || !file) {
+        error = true;
+        result = 0;
+        return;
+    }
+
+    size_t limit = length ? length : 0x10000 - buffer;
+    std::vector<char> contents(limit);
+    file.read(contents.data(), limit);
+    size_t count = file.gcount();
+
+    word addr = buffer;
+    for (size_t i = 0; i < count; ++i) decoder.write(addr++, static_cast<byte>(contents[i]));
+    result = count;
+}
+
+void Semihost::write_file() {
+    std::string path = file_path();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (path.empty() || !file) {
+        error = true;
+        result = 0;
+        return;
+    }
+
+    std::vector<char> contents(length);
+    word addr = buffer;
+    for (char& c : contents) c = static_cast<char>(decoder.read(addr++));
+    file.write(contents.data(), contents.size());
+    error = !file;
+    result = error ? 0 : contents.size();
+}
@@ -0,0 +1,132 @@
+#include "shared_monitor.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include "at28c256.h"
+#include "decoder.h"
+#include "hm62256b.h"
+#include "log.h"
+
+static constexpr size_t BLOCK_SIZE = 4096;  // The block gets a page, the arrays start page aligned
+static constexpr size_t CHIP_SIZE = 32 * 1024;
+static constexpr size_t SEGMENT_SIZE = BLOCK_SIZE + 2 * CHIP_SIZE;
+
+static_assert(sizeof(SharedMonitorBlock) <= BLOCK_SIZE, "SharedMonitorBlock must fit its page");
+
+// shm_open() wants a name with one leading slash
+static std::string segment_path(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+SharedMonitor::SharedMonitor(const std::string& name) : name(segment_path(name)) {
+    // A segment left behind by a crashed run would keep readers on the old data
+    shm_unlink(this->name.c_str());
+
+    int fd = shm_open(this->name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create shared memory segment " + this->name + ": " + std::strerror(errno));
+    }
+    if (ftruncate(fd, SEGMENT_SIZE) != 0) {
+        int error = errno;
+        close(fd);
+        shm_unlink(this->name.c_str());
+        throw std::runtime_error("Cannot size shared memory segment " + this->name + ": " + std::strerror(error));
+    }
+
+    void* addr = mmap(nullptr, SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping keeps its own reference
+    if (addr == MAP_FAILED) {
+        int error = errno;
+        shm_unlink(this->name.c_str());
+        throw std::runtime_error("Cannot map shared memory segment " + this->name + ": " + std::strerror(error));
+    }
+
+    base = static_cast<byte*>(addr);
+    block = new (base) SharedMonitorBlock{};
+    block->ram_offset = BLOCK_SIZE;
+    block->rom_offset = BLOCK_SIZE + CHIP_SIZE;
+    block->version = SharedMonitorBlock::VERSION;
+
+    // Readers check the magic last, a half initialized block doesn't pass
+    std::atomic_thread_fence(std::memory_order_release);
+    block->magic = SharedMonitorBlock::MAGIC;
+}
+
+SharedMonitor::~SharedMonitor() {
+    munmap(base, SEGMENT_SIZE);
+    shm_unlink(name.c_str());
+}
+
+bool SharedMonitor::attach(HM62256B& sram, AT28C256& eeprom, const AddressDecoder& decoder) {
+    // The hash reads the chips' arrays through pointers it was given, the
+    // move would leave it hashing the old ones
+    if (decoder.has_state_hash()) {
+        logger::error("Cannot share memory in " + name + " once a state hash is attached, attach the monitor first");
+        return false;
+    }
+    if (eeprom.is_mapped()) {
+        logger::error("Cannot share a mapped EEPROM image in " + name + ", attach the monitor before mapping it");
+        return false;
+    }
+
+    if (!eeprom.use_storage(base + block->rom_offset)) return false;
+    sram.use_storage(base + block->ram_offset);
+    logger::info("Machine state shared in " + name);
+    return true;
+}
+
+SharedMonitorView::SharedMonitorView(const std::string& name) {
+    std::string path = segment_path(name);
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open shared memory segment " + path + ": " + std::strerror(errno));
+    }
+
+    void* addr = mmap(nullptr, SEGMENT_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Cannot map shared memory segment " + path + ": " + std::strerror(errno));
+    }
+
+    base = static_cast<const byte*>(addr);
+    block = reinterpret_cast<const SharedMonitorBlock*>(base);
+    if (block->magic != SharedMonitorBlock::MAGIC || block->version != SharedMonitorBlock::VERSION) {
+        munmap(const_cast<byte*>(base), SEGMENT_SIZE);
+        throw std::runtime_error("Not a machine state segment of this version: " + path);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+SharedMonitorView::~SharedMonitorView() {
+    munmap(const_cast<byte*>(base), SEGMENT_SIZE);
+}
+
+MonitorSnapshot SharedMonitorView::snapshot() const {
+    MonitorSnapshot snapshot;
+    uint64_t registers, before, after;
+    do {
+        before = block->sequence.load(std::memory_order_acquire);
+        registers = block->registers.load(std::memory_order_relaxed);
+        snapshot.cycles = block->cycles.load(std::memory_order_relaxed);
+        snapshot.skipped_cycles = block->skipped_cycles.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = block->sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    snapshot.A = registers & 0xFF;
+    snapshot.X = (registers >> 8) & 0xFF;
+    snapshot.Y = (registers >> 16) & 0xFF;
+    snapshot.SP = (registers >> 24) & 0xFF;
+    snapshot.FLAGS = (registers >> 32) & 0xFF;
+    snapshot.PC = (registers >> 40) & 0xFFFF;
+    snapshot.state = static_cast<CPU_State>(registers >> 56);
+    snapshot.sequence = before;
+    return snapshot;
+}
@@ -0,0 +1,155 @@
+#include "state_hash.h"
+
+#include <stdexcept>
+
+#include "wdc65c02.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define STATE_HASH_AVX2 1
+#endif
+
+// Seeds of the two 32-bit halves
+static constexpr uint32_t SEED_HI = 0x9E3779B9;
+static constexpr uint32_t SEED_LO = 0x7F4A7C15;
+
+// MurmurHash3 finalizer
+static inline uint32_t fmix32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85EBCA6B;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35;
+    x ^= x >> 16;
+    return x;
+}
+
+// Add / subtract packed hashes, each half wraps on its own
+static inline uint64_t add_halves(uint64_t a, uint64_t b) {
+    uint32_t hi = static_cast<uint32_t>(a >> 32) + static_cast<uint32_t>(b >> 32);
+    uint32_t lo = static_cast<uint32_t>(a) + static_cast<uint32_t>(b);
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+static inline uint64_t sub_halves(uint64_t a, uint64_t b) {
+    uint32_t hi = static_cast<uint32_t>(a >> 32) - static_cast<uint32_t>(b >> 32);
+    uint32_t lo = static_cast<uint32_t>(a) - static_cast<uint32_t>(b);
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+uint64_t StateHash::contribution(word addr, byte value) {
+    uint32_t key = (static_cast<uint32_t>(addr) << 8) | value;
+    return (static_cast<uint64_t>(fmix32(key ^ SEED_HI)) << 32) | fmix32(key ^ SEED_LO);
+}
+
+#ifdef STATE_HASH_AVX2
+__attribute__((target("avx2"))) static inline __m256i fmix32x8(__m256i x) {
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x85EBCA6B)));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 13));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0xC2B2AE35)));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    return x;
+}
+
+// Sum of the contributions of the first `count` bytes (a multiple of 8)
+__attribute__((target("avx2"))) static uint64_t sum_avx2(word start, const byte* data, size_t count) {
+    const __m256i seed_hi = _mm256_set1_epi32(static_cast<int>(SEED_HI));
+    const __m256i seed_lo = _mm256_set1_epi32(static_cast<int>(SEED_LO));
+    const __m256i stride = _mm256_set1_epi32(8);
+
+    __m256i addr = _mm256_add_epi32(_mm256_set1_epi32(start), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i hi = _mm256_setzero_si256();
+    __m256i lo = _mm256_setzero_si256();
+
+    for (size_t i = 0; i < count; i += 8) {
+        __m256i value = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data + i)));
+        __m256i key = _mm256_or_si256(_mm256_slli_epi32(addr, 8), value);
+        hi = _mm256_add_epi32(hi, fmix32x8(_mm256_xor_si256(key, seed_hi)));
+        lo = _mm256_add_epi32(lo, fmix32x8(_mm256_xor_si256(key, seed_lo)));
+        addr = _mm256_add_epi32(addr, stride);
+    }
+
+    alignas(32) uint32_t hi_lanes[8];
+    alignas(32) uint32_t lo_lanes[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(hi_lanes), hi);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lo_lanes), lo);
+
+    uint32_t hi_sum = 0;
+    uint32_t lo_sum = 0;
+    for (int lane = 0; lane < 8; ++lane) {
+        hi_sum += hi_lanes[lane];
+        lo_sum += lo_lanes[lane];
+    }
+    return (static_cast<uint64_t>(hi_sum) << 32) | lo_sum;
+}
+#endif
+
+uint64_t StateHash::sum(const Region& region) {
+    size_t count = region.end - region.start + 1;
+    size_t done = 0;
+    uint64_t total = 0;
+
+#ifdef STATE_HASH_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) {
+        done = count & ~static_cast<size_t>(7);
+        total = sum_avx2(region.start, region.data, done);
+    }
+#endif
+
+    // Whatever the vector loop left over (or everything without AVX2)
+    for (size_t i = done; i < count; ++i) {
+        total = add_halves(total, contribution(region.start + i, region.data[i]));
+    }
+    return total;
+}
+
+void StateHash::track(word start, word end, const byte* data) {
+    if (end < start || data == nullptr) throw std::invalid_argument("Invalid state hash region");
+    for (const Region& region : regions) {
+        if ((start >> 8) <= (region.end >> 8) && (end >> 8) >= (region.start >> 8)) {
+            throw std::invalid_argument("State hash regions must not share a page");
+        }
+    }
+
+    regions.push_back({start, end, data});
+
+    // The vector may have moved, point the pages at the new storage
+    for (auto& page : pages) page = nullptr;
+    for (const Region& region : regions) {
+        for (int index = region.start >> 8; index <= region.end >> 8; ++index) pages[index] = &region;
+    }
+
+    memory_hash = add_halves(memory_hash, sum(regions.back()));
+}
+
+uint64_t StateHash::rehash() {
+    uint64_t total = 0;
+    for (const Region& region : regions) total = add_halves(total, sum(region));
+    memory_hash = total;
+    return memory_hash;
+}
+
+bool StateHash::verify() {
+    uint64_t running = memory_hash;
+    return rehash() == running;
+}
+
+void StateHash::update(word addr, byte old_value, byte new_value) {
+    if (old_value == new_value) return;
+    memory_hash = add_halves(sub_halves(memory_hash, contribution(addr, old_value)), contribution(addr, new_value));
+}
+
+uint64_t StateHash::state(const WDC65C02& cpu) const {
+    // Fold the registers into the memory hash
+    uint64_t registers = (static_cast<uint64_t>(cpu.PC) << 40) | (static_cast<uint64_t>(cpu.SP) << 32) |
+                         (static_cast<uint64_t>(cpu.FLAGS) << 24) | (static_cast<uint64_t>(cpu.A) << 16) |
+                         (static_cast<uint64_t>(cpu.X) << 8) | cpu.Y;
+    uint64_t h = memory_hash ^ (registers * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
@@ -0,0 +1,399 @@
+#include "w65c22.h"
+
+#include <algorithm>
+
+// Shift register modes (ACR bits 4-2)
+static constexpr byte SR_DISABLED = 0;
+static constexpr byte SR_IN_T2 = 1;
+static constexpr byte SR_IN_PHI2 = 2;
+static constexpr byte SR_IN_CB1 = 3;
+static constexpr byte SR_OUT_FREE = 4;
+static constexpr byte SR_OUT_T2 = 5;
+static constexpr byte SR_OUT_PHI2 = 6;
+static constexpr byte SR_OUT_CB1 = 7;
+
+static inline byte sr_mode(byte acr) {
+    return (acr >> 2) & 0x07;
+}
+
+static inline bool t1_free_run(byte acr) {
+    return (acr & 0x40) != 0;
+}
+
+static inline bool t2_counts_pulses(byte acr) {
+    return (acr & 0x20) != 0;
+}
+
+static inline byte rotate_left(byte value, unsigned n) {
+    n &= 7;
+    return n == 0 ? value : static_cast<byte>((value << n) | (value >> (8 - n)));
+}
+
+void W65C22::reset() {
+    ora = orb = ddra = ddrb = 0;
+    acr = pcr = ifr = ier = 0;
+    t1_armed = t2_armed = false;
+    t1_toggles = 0;
+
+    // Edge detection starts over from the idle (high) handshake levels,
+    // and the shift register stops with no bits counted
+    ca1 = ca2 = cb1 = cb2 = true;
+    sr = 0;
+    sr_shifted = 8;
+    sr_started = 0;
+}
+
+uint64_t W65C22::shift_period() const {
+    switch (sr_mode(acr)) {
+        case SR_IN_T2:
+        case SR_OUT_FREE:
+        case SR_OUT_T2:
+            // CB1 toggles every time the T2 low latch counts out
+            return 2 * (static_cast<uint64_t>(t2_latch) + 2);
+        case SR_IN_PHI2:
+        case SR_OUT_PHI2:
+            return 2;
+        default:
+            return 0;  // Disabled, or clocked externally on CB1
+    }
+}
+
+word W65C22::t1_counter(uint64_t now) const {
+    if (now < t1_loaded) return 0xFFFF;  // Reload cycle right after a free-running roll over
+    return static_cast<word>(t1_value - (now - t1_loaded));
+}
+
+word W65C22::t2_counter(uint64_t now) const {
+    if (t2_counts_pulses(acr)) return t2_pulses;
+    return static_cast<word>(t2_value - (now - t2_loaded));
+}
+
+bool W65C22::pb7() const {
+    // PB7 goes low when T1 is loaded. One-shot mode sends it back high on
+    // the time-out, free-running mode inverts it on every roll over.
+    return t1_free_run(acr) ? (t1_toggles & 1) != 0 : t1_toggles != 0;
+}
+
+void W65C22::sync(uint64_t now) {
+    // Timer 1
+    if (t1_armed && now >= t1_fire) {
+        ifr |= IRQ_T1;
+        if (t1_free_run(acr)) {
+            // Catch up on every roll over since the last look in one go
+            uint64_t period = static_cast<uint64_t>(t1_latch) + 2;
+            uint64_t extra = (now - t1_fire) / period;
+            uint64_t last = t1_fire + extra * period;
+            t1_toggles += extra + 1;
+            t1_value = t1_latch;
+            t1_loaded = last + 1;
+            t1_fire = last + period;
+        } else {
+            t1_toggles = 1;
+            t1_armed = false;  // One-shot, the counter keeps running silently
+        }
+    }
+
+    // Timer 2 (timed mode only, pulse counting happens in `pulse_pb6`)
+    if (t2_armed && !t2_counts_pulses(acr) && now >= t2_loaded + t2_value + 1) {
+        ifr |= IRQ_T2;
+        t2_armed = false;
+    }
+
+    // Shift register
+    uint64_t period = shift_period();
+    if (period != 0 && (sr_shifted < 8 || sr_mode(acr) == SR_OUT_FREE)) {
+        uint64_t total = (now - sr_started) / period;
+        if (sr_mode(acr) != SR_OUT_FREE) total = std::min<uint64_t>(total, 8);
+        uint64_t bits = total - std::min(total, sr_shifted);
+
+        if (bits != 0) {
+            switch (sr_mode(acr)) {
+                case SR_IN_T2:
+                case SR_IN_PHI2:
+                    // CB2 is held at one level between changes, shift in copies of it
+                    sr = bits >= 8 ? (cb2 ? 0xFF : 0x00)
+                                   : static_cast<byte>((sr << bits) | (cb2 ? (1u << bits) - 1 : 0));
+                    break;
+                default:
+                    sr = rotate_left(sr, bits);  // Shifting out recirculates bit 7 into bit 0
+                    break;
+            }
+            sr_shifted = total;
+
+            if (sr_shifted == 8 && sr_mode(acr) != SR_OUT_FREE) {
+                ifr |= IRQ_SR;
+                if (listener && sr_mode(acr) >= SR_OUT_FREE) listener->shifted_out(sr);
+            }
+        }
+    }
+}
+
+void W65C22::restart_shift(uint64_t now) {
+    ifr &= ~IRQ_SR;
+    sr_started = now;
+    sr_shifted = sr_mode(acr) == SR_DISABLED ? 8 : 0;
+}
+
+uint64_t W65C22::next_event() {
+    uint64_t now = this->now();
+    sync(now);
+
+    uint64_t next = UINT64_MAX;
+    if (t1_armed) next = std::min(next, t1_fire);
+    if (t2_armed && !t2_counts_pulses(acr)) next = std::min(next, t2_loaded + t2_value + 1);
+
+    uint64_t period = shift_period();
+    if (period != 0 && sr_shifted < 8 && sr_mode(acr) != SR_OUT_FREE) {
+        next = std::min(next, sr_started + 8 * period);
+    }
+    return next;
+}
+
+bool W65C22::irq_asserted() {
+    sync(now());
+    return (ifr & ier & 0x7F) != 0;
+}
+
+byte W65C22::read_port_a() {
+    byte pins = listener ? listener->port_read(ViaPort::A) : pins_a;
+    return (ora & ddra) | (pins & ~ddra);
+}
+
+byte W65C22::read_port_b() {
+    byte pins = listener ? listener->port_read(ViaPort::B) : pins_b;
+    byte value = (orb & ddrb) | (pins & ~ddrb);
+    if (acr & 0x80) value = (value & 0x7F) | (pb7() ? 0x80 : 0x00);
+    return value;
+}
+
+void W65C22::drive_port(ViaPort port) {
+    if (listener == nullptr) return;
+
+    if (port == ViaPort::A) {
+        listener->port_written(ViaPort::A, ora, ddra);
+    } else {
+        byte value = orb;
+        byte ddr = ddrb;
+        if (acr & 0x80) {
+            // Timer 1 drives PB7 regardless of DDRB
+            value = (value & 0x7F) | (pb7() ? 0x80 : 0x00);
+            ddr |= 0x80;
+        }
+        listener->port_written(ViaPort::B, value, ddr);
+    }
+}
+
+void W65C22::clear_port_flags(ViaPort port) {
+    if (port == ViaPort::A) {
+        ifr &= ~IRQ_CA1;
+        if (!ca2_independent()) ifr &= ~IRQ_CA2;
+    } else {
+        ifr &= ~IRQ_CB1;
+        if (!cb2_independent()) ifr &= ~IRQ_CB2;
+    }
+}
+
+byte W65C22::io_read(word reg) {
+    uint64_t now = this->now();
+    sync(now);
+
+    switch (reg & 0x0F) {
+        case ORB:
+            clear_port_flags(ViaPort::B);
+            return read_port_b();
+        case ORA:
+            clear_port_flags(ViaPort::A);
+            return read_port_a();
+        case ORA_NH:
+            return read_port_a();
+        case DDRB:
+            return ddrb;
+        case DDRA:
+            return ddra;
+        case T1CL:
+            ifr &= ~IRQ_T1;
+            return t1_counter(now) & 0xFF;
+        case T1CH:
+            return t1_counter(now) >> 8;
+        case T1LL:
+            return t1_latch & 0xFF;
+        case T1LH:
+            return t1_latch >> 8;
+        case T2CL:
+            ifr &= ~IRQ_T2;
+            return t2_counter(now) & 0xFF;
+        case T2CH:
+            return t2_counter(now) >> 8;
+        case SR: {
+            byte value = sr;
+            restart_shift(now);
+            return value;
+        }
+        case ACR:
+            return acr;
+        case PCR:
+            return pcr;
+        case IFR:
+            return ifr | ((ifr & ier & 0x7F) ? IRQ_ANY : 0x00);
+        case IER:
+            return ier | 0x80;
+    }
+    return 0xFF;
+}
+
+void W65C22::io_write(word reg, byte data) {
+    uint64_t now = this->now();
+    sync(now);
+
+    switch (reg & 0x0F) {
+        case ORB:
+            orb = data;
+            clear_port_flags(ViaPort::B);
+            drive_port(ViaPort::B);
+            break;
+        case ORA:
+            ora = data;
+            clear_port_flags(ViaPort::A);
+            drive_port(ViaPort::A);
+            break;
+        case ORA_NH:
+            ora = data;
+            drive_port(ViaPort::A);
+            break;
+        case DDRB:
+            ddrb = data;
+            drive_port(ViaPort::B);
+            break;
+        case DDRA:
+            ddra = data;
+            drive_port(ViaPort::A);
+            break;
+        case T1CL:
+        case T1LL:
+            t1_latch = (t1_latch & 0xFF00) | data;
+            break;
+        case T1CH:
+            // Load the counter from the latch and start counting
+            t1_latch = (t1_latch & 0x00FF) | (data << 8);
+            t1_value = t1_latch;
+            t1_loaded = now;
+            t1_fire = now + t1_latch + 1;
+            t1_armed = true;
+            t1_toggles = 0;
+            ifr &= ~IRQ_T1;
+            if (acr & 0x80) drive_port(ViaPort::B);  // PB7 goes low
+            break;
+        case T1LH:
+            // The new latch only takes effect at the next reload
+            t1_latch = (t1_latch & 0x00FF) | (data << 8);
+            ifr &= ~IRQ_T1;
+            break;
+        case T2CL:
+            t2_latch = data;
+            break;
+        case T2CH:
+            t2_value = (data << 8) | t2_latch;
+            t2_loaded = now;
+            t2_pulses = t2_value;
+            t2_armed = true;
+            ifr &= ~IRQ_T2;
+            break;
+        case SR:
+            sr = data;
+            restart_shift(now);
+            break;
+        case ACR: {
+            // Carry the timer 2 count over when switching its clock source
+            if (t2_counts_pulses(acr) != t2_counts_pulses(data)) {
+                word count = t2_counter(now);
+                t2_value = t2_pulses = count;
+                t2_loaded = now;
+            }
+            bool pb7_changed = (acr ^ data) & 0x80;
+            acr = data;
+            if (sr_mode(acr) == SR_DISABLED) sr_shifted = 8;
+            if (pb7_changed) drive_port(ViaPort::B);
+            break;
+        }
+        case PCR:
+            pcr = data;
+            break;
+        case IFR:
+            ifr &= ~(data & 0x7F);  // Writing a 1 clears the flag
+            break;
+        case IER:
+            if (data & 0x80) {
+                ier |= data & 0x7F;
+            } else {
+                ier &= ~(data & 0x7F);
+            }
+            break;
+    }
+}
+
+void W65C22::edge(bool& line, bool level, byte flag, bool positive) {
+    if (line == level) return;
+    line = level;
+    if (level == positive) ifr |= flag;
+}
+
+void W65C22::set_ca1(bool level) {
+    sync(now());
+    edge(ca1, level, IRQ_CA1, pcr & 0x01);
+}
+
+void W65C22::set_ca2(bool level) {
+    sync(now());
+    if (pcr & 0x08) return;  // CA2 is an output
+    edge(ca2, level, IRQ_CA2, pcr & 0x04);
+}
+
+void W65C22::set_cb1(bool level) {
+    sync(now());
+    bool rising = !cb1 && level;
+    bool falling = cb1 && !level;
+
+    // External shift clock: bits go in on the rising edge, out on the falling one
+    if (sr_shifted < 8) {
+        if (sr_mode(acr) == SR_IN_CB1 && rising) {
+            sr = static_cast<byte>((sr << 1) | (cb2 ? 1 : 0));
+            sr_shifted++;
+        } else if (sr_mode(acr) == SR_OUT_CB1 && falling) {
+            sr = rotate_left(sr, 1);
+            sr_shifted++;
+        }
+        if (sr_shifted == 8) {
+            ifr |= IRQ_SR;
+            if (listener && sr_mode(acr) == SR_OUT_CB1) listener->shifted_out(sr);
+        }
+    }
+
+    edge(cb1, level, IRQ_CB1, pcr & 0x10);
+}
+
+void W65C22::set_cb2(bool level) {
+    // Bits already shifted in saw the old level
+    sync(now());
+    if (pcr & 0x80) {
+        cb2 = level;  // CB2 is an output, only the shift register cares
+        return;
+    }
+    edge(cb2, level, IRQ_CB2, pcr & 0x40);
+}
+
+void W65C22::pulse_pb6() {
+    if (!t2_counts_pulses(acr)) return;
+    t2_pulses--;
+    if (t2_pulses == 0 && t2_armed) {
+        ifr |= IRQ_T2;
+        t2_armed = false;
+    }
+}
+
+void W65C22::set_port_input(ViaPort port, byte levels) {
+    if (port == ViaPort::A) {
+        pins_a = levels;
+    } else {
+        pins_b = levels;
+    }
+}
@@ -0,0 +1,315 @@
+#include "w65c51.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include "log.h"
+
+// Terminal settings of stdin before the bridge switched it to raw mode
+static struct termios saved_tty;
+
+// Baud rates selected by control register bits 3-0, index 0 is the
+// 16x external clock which on the usual 1.8432MHz crystal is 115200
+static const double BAUD_RATES[16] = {115200.0, 50.0,   75.0,   109.92, 134.58, 150.0,  300.0,  600.0,
+                                      1200.0,   1800.0, 2400.0, 3600.0, 4800.0, 7200.0, 9600.0, 19200.0};
+
+W65C51::~W65C51() {
+    close_host();
+}
+
+void W65C51::reset() {
+    // A programmed reset clears the command register bits that enable
+    // interrupts and the receiver, the control register is kept
+    command &= 0xE0;
+    rx_full = false;
+    tx_busy = false;
+    tx_irq = false;
+}
+
+uint64_t W65C51::char_cycles() const {
+    // Start bit + data bits + optional parity + stop bits
+    unsigned bits = 1 + (8 - ((control >> 5) & 0x03)) + ((command & 0x20) ? 1 : 0) + ((control & 0x80) ? 2 : 1);
+    double cycles = clock_hz * bits / BAUD_RATES[control & 0x0F];
+    return std::max<uint64_t>(1, static_cast<uint64_t>(cycles));
+}
+
+void W65C51::sync(uint64_t now) {
+    // The transmitter finished shifting out the current character
+    if (tx_busy && now >= tx_free_at) {
+        tx_busy = false;
+        tx_irq = true;
+    }
+
+    // The receiver is disabled while DTR is off
+    if (!(command & 0x01)) return;
+
+    if (!rx_full && now >= rx_next && rx_ring.pop(rx_data)) {
+        rx_full = true;
+        rx_next = now + (throttle ? char_cycles() : 0);
+        if (command & 0x10) transmit(rx_data, now);  // Receiver echo mode
+    }
+}
+
+void W65C51::transmit(byte data, uint64_t now) {
+    // Firmware that ignores TDRE while the host lags behind loses characters,
+    // the same as overwriting the data register on the real chip
+    tx_ring.push(data);
+
+    if (throttle) {
+        tx_free_at = std::max(now, tx_free_at) + char_cycles();
+        tx_busy = true;
+        tx_irq = false;
+    } else {
+        tx_irq = true;
+    }
+}
+
+byte W65C51::io_read(word reg) {
+    uint64_t now = this->now();
+    sync(now);
+
+    switch (reg & 0x03) {
+        case DATA:
+            rx_full = false;
+            return rx_data;
+        case STATUS: {
+            byte status = 0;
+            if (rx_full) status |= STATUS_RDRF;
+            if (!tx_busy && !tx_ring.full()) status |= STATUS_TDRE;
+            if (irq_asserted()) status |= STATUS_IRQ;
+            tx_irq = false;  // Reading the status clears the transmitter interrupt
+            return status;
+        }
+        case COMMAND:
+            return command;
+        case CONTROL:
+            return control;
+    }
+    return 0xFF;
+}
+
+void W65C51::io_write(word reg, byte data) {
+    uint64_t now = this->now();
+    sync(now);
+
+    switch (reg & 0x03) {
+        case DATA:
+            transmit(data, now);
+            break;
+        case STATUS:
+            reset();  // Programmed reset, the data is ignored
+            break;
+        case COMMAND:
+            command = data;
+            break;
+        case CONTROL:
+            control = data;
+            break;
+    }
+}
+
+bool W65C51::irq_asserted() {
+    sync(now());
+    if (!(command & 0x01)) return false;  // DTR off disables interrupts
+
+    bool rx = rx_full && !(command & 0x02);
+    bool tx = tx_irq && ((command >> 2) & 0x03) == 0x01;
+    return rx || tx;
+}
+
+uint64_t W65C51::next_event() {
+    uint64_t now = this->now();
+    sync(now);
+
+    uint64_t next = UINT64_MAX;
+    if (tx_busy) next = tx_free_at;
+    if ((command & 0x01) && !rx_full && !rx_ring.empty()) next = std::min(next, std::max(now, rx_next));
+    return next;
+}
+
+bool W65C51::start_bridge(int in_fd, int out_fd) {
+    host_in = in_fd;
+    host_out = out_fd;
+    bridge_running.store(true);
+    bridge_thread = std::thread([this]() { bridge_loop(); });
+    return true;
+}
+
+bool W65C51::open_stdio() {
+    close_host();
+
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved_tty) == 0) {
+        // Hand every key to the firmware as it is typed, Ctrl-C still works
+        struct termios raw = saved_tty;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+        restore_tty = true;
+    }
+
+    return start_bridge(STDIN_FILENO, STDOUT_FILENO);
+}
+
+bool W65C51::open_pty(std::string* slave_name) {
+    close_host();
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        logger::error(std::string("Cannot create pseudo-terminal: ") + std::strerror(errno));
+        if (master >= 0) close(master);
+        return false;
+    }
+
+    // Raw line discipline, bytes pass through untouched
+    struct termios tty;
+    if (tcgetattr(master, &tty) == 0) {
+        cfmakeraw(&tty);
+        tcsetattr(master, TCSANOW, &tty);
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    const char* name = ptsname(master);
+    if (slave_name && name) *slave_name = name;
+    logger::info(std::string("ACIA serial line on ") + (name ? name : "?"));
+
+    return start_bridge(master, master);
+}
+
+bool W65C51::open_unix_socket(const std::string& path) {
+    close_host();
+
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        logger::error("UNIX socket path too long: " + path);
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        logger::error(std::string("Cannot create UNIX socket: ") + std::strerror(errno));
+        return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 1) != 0) {
+        logger::error("Cannot listen on " + path + ": " + std::strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    listen_fd = fd;
+    socket_path = path;
+    logger::info("ACIA serial line on UNIX socket " + path);
+
+    // The descriptors are filled in once a client connects
+    return start_bridge(-1, -1);
+}
+
+void W65C51::close_host() {
+    if (bridge_running.exchange(false)) {
+        bridge_thread.join();
+    }
+
+    if (host_in >= 0 && host_in != STDIN_FILENO) close(host_in);
+    if (host_out >= 0 && host_out != STDOUT_FILENO && host_out != host_in) close(host_out);
+    host_in = host_out = -1;
+
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(socket_path.c_str());
+        listen_fd = -1;
+    }
+
+    if (restore_tty) {
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved_tty);
+        restore_tty = false;
+    }
+}
+
+void W65C51::bridge_loop() {
+    byte tx_buf[1024];  // Batch of firmware output not yet written to the host
+    size_t tx_len = 0, tx_off = 0;
+    byte rx_buf[256];  // Host input not yet accepted by the RX ring
+    size_t rx_len = 0, rx_off = 0;
+
+    // A socket client goes back to listening, stdin / the pty just stop
+    auto drop_host = [&]() {
+        if (listen_fd >= 0) {
+            close(host_in);
+            host_out = -1;
+            tx_len = tx_off = 0;
+        }
+        host_in = -1;
+    };
+
+    while (bridge_running.load()) {
+        // Socket mode: wait for a client before anything else
+        if (listen_fd >= 0 && host_in < 0) {
+            pollfd pfd{listen_fd, POLLIN, 0};
+            if (poll(&pfd, 1, 10) > 0) {
+                int client = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+                if (client >= 0) host_in = host_out = client;
+            }
+            tx_ring.pop_bulk(tx_buf, sizeof(tx_buf));  // Nobody to send to, drop output
+            continue;
+        }
+
+        // Firmware -> host, one write() per batch
+        if (tx_off == tx_len) {
+            tx_len = tx_ring.pop_bulk(tx_buf, sizeof(tx_buf));
+            tx_off = 0;
+        }
+        bool tx_blocked = false;  // The host has no room, wait for it below
+        if (tx_off < tx_len && host_out >= 0) {
+            // A client that went away must not take the emulator down with SIGPIPE
+            ssize_t n = listen_fd >= 0 ? send(host_out, tx_buf + tx_off, tx_len - tx_off, MSG_NOSIGNAL)
+                                       : write(host_out, tx_buf + tx_off, tx_len - tx_off);
+            if (n > 0) {
+                tx_off += n;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                tx_blocked = true;
+            } else if (n < 0 && errno != EINTR) {
+                // Nobody on the other end, the batch is lost with it
+                tx_off = tx_len;
+                if (listen_fd >= 0) {
+                    drop_host();
+                    continue;
+                }
+            }
+        }
+
+        // Host -> firmware, only read more once the last batch was accepted
+        while (rx_off < rx_len && rx_ring.push(rx_buf[rx_off])) rx_off++;
+
+        // Don't wait while output is ready to go, but do while the host
+        // isn't taking it
+        bool tx_pending = !tx_blocked && (tx_off < tx_len || !tx_ring.empty());
+        pollfd pfds[2] = {{rx_off == rx_len ? host_in : -1, POLLIN, 0}, {tx_blocked ? host_out : -1, POLLOUT, 0}};
+        if (poll(pfds, 2, tx_pending ? 0 : (tx_blocked ? 10 : 1)) > 0 &&
+            (pfds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+            ssize_t n = read(host_in, rx_buf, sizeof(rx_buf));
+            if (n > 0) {
+                rx_len = n;
+                rx_off = 0;
+            } else if (n == 0 || (errno != EAGAIN && errno != EINTR && errno != EIO)) {
+                // End of input
+                drop_host();
+            } else if (errno == EIO) {
+                // No terminal program has the pty slave open yet
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+    }
+}
@@ -1,5 +1,6 @@
 #include "wdc65c02.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <iomanip>
@@ -7,9 +8,16 @@
 #include <sstream>
 #include <thread>
 
+#include "bcd.h"
 #include "bus.h"
+#include "coverage.h"
+#include "debugger.h"
+#include "instructions.h"
 #include "log.h"
+#include "metrics.h"
 #include "op_codes.h"
+#include "pin_checker.h"
+#include "shared_monitor.h"
 
 WDC65C02::WDC65C02(Bus& bus, AddressDecoder* decoder) : bus(bus) {
     // Clear registers
@@ -18,6 +26,7 @@ WDC65C02::WDC65C02(Bus& bus, AddressDecoder* decoder) : bus(bus) {
     PC = 0x0000;            // Will be set by reset() from vector
     SP = 0xFF;              // Stack starts at top of page 1
     FLAGS = 0x34;           // Default reset state (IRQ disabled, U=1)
+    cycles = 0;             // No clock cycles executed yet
     decoder_ptr = decoder;  // Initialize decoder pointer
 
     // Power pins
@@ -52,6 +61,9 @@ void WDC65C02::reset() {
     this->FLAGS = 0;    // Clear all flags
     this->FLAGS_I = 1;  // Set Interrupt Disable Flag (I) to 1
 
+    this->waiting = false;     // Reset ends WAI
+    this->idle.valid = false;  // No loop is being watched
+
     // R/W high to read from the memory
     this->PHI0 = 0;  // Set PHI0 to low (inactive state)
     this->SYNC = 1;  // Set SYNC to high (not in sync state)
@@ -104,6 +116,150 @@ void WDC65C02::set_decoder(AddressDecoder* decoder) {
     logger::info("CPU access to memory through address decoder established");
 }
 
+void WDC65C02::attach_irq_source(IO_Device* device) {
+    device->attach_cycle_counter(&this->cycles);
+    irq_sources.push_back(device);
+}
+
+word WDC65C02::due_interrupt() {
+    // IRQB is the wired-OR of every attached (active low) IRQ output
+    if (!irq_sources.empty()) {
+        bool asserted = false;
+        for (IO_Device* device : irq_sources) {
+            if (device->irq_asserted()) {
+                asserted = true;
+                break;
+            }
+        }
+        this->IRQB = asserted ? 0 : 1;
+    }
+
+    // NMIB is edge triggered, IRQB is level triggered and maskable
+    bool nmi_edge = this->nmi_line && this->NMIB == 0;
+    this->nmi_line = this->NMIB != 0;
+
+    if (nmi_edge) return 0xFFFA;
+    if (this->IRQB == 0 && !this->FLAGS_I) return 0xFFFE;
+    return 0;
+}
+
+void WDC65C02::interrupt(word vector) {
+    this->waiting = false;  // An interrupt ends WAI
+    this->cycles += 2;      // Two internal cycles before the stack pushes
+
+    push(this->PC >> 8);
+    push(this->PC & 0xFF);
+    push((this->FLAGS | 0x20) & ~0x10);  // B clear tells a hardware interrupt from BRK
+
+    this->FLAGS_I = 1;  // Mask further IRQs
+    this->FLAGS_D = 0;  // The 65C02 leaves decimal mode on interrupts
+
+    byte lo = read_mem(vector);
+    byte hi = read_mem(vector + 1);
+    this->PC = (hi << 8) | lo;
+}
+
+void WDC65C02::yield_bus() {
+    this->RDY = 0;  // Stalled while the master runs
+    this->cycles += bus.arbitrate();
+    this->RDY = 1;
+}
+
+void WDC65C02::branch(bool taken, byte offset) {
+    if (!taken) return;
+
+    word target = this->PC + static_cast<int8_t>(offset);
+    this->cycles++;  // Taken branches add a cycle
+    if ((target & 0xFF00) != (this->PC & 0xFF00)) {
+        this->cycles++;  // Crossing a page adds another
+    }
+    this->PC = target;
+}
+
+void WDC65C02::add_with_carry(byte value) {
+    AluResult result;
+    if (this->FLAGS_D) {
+        result = DECIMAL_ADC[decimal_index(this->A, value, this->FLAGS_C)];
+    } else {
+        result = binary_adc(this->A, value, this->FLAGS_C);
+    }
+    this->A = result.value;
+    this->FLAGS = (this->FLAGS & ~ALU_FLAGS) | result.flags;
+}
+
+void WDC65C02::subtract_with_carry(byte value) {
+    AluResult result;
+    if (this->FLAGS_D) {
+        result = DECIMAL_SBC[decimal_index(this->A, value, this->FLAGS_C)];
+    } else {
+        result = binary_sbc(this->A, value, this->FLAGS_C);
+    }
+    this->A = result.value;
+    this->FLAGS = (this->FLAGS & ~ALU_FLAGS) | result.flags;
+}
+
+void WDC65C02::set_idle_skip(bool enabled, uint64_t quantum) {
+    this->idle_skip = enabled;
+    this->idle_quantum = quantum ? quantum : 1;
+    this->idle.valid = false;
+}
+
+uint64_t WDC65C02::next_device_event() {
+    uint64_t event = decoder_ptr ? decoder_ptr->next_event() : UINT64_MAX;
+    for (IO_Device* device : irq_sources) event = std::min(event, device->next_event());
+    return event;
+}
+
+uint64_t WDC65C02::idle_target(uint64_t event) {
+    return std::min({event, this->cycles + this->idle_quantum, this->skip_limit});
+}
+
+void WDC65C02::check_idle_loop() {
+    bool repeated = idle.valid && idle.head == this->PC && idle.writes == this->writes && idle.A == this->A &&
+                    idle.X == this->X && idle.Y == this->Y && idle.SP == this->SP && idle.FLAGS == this->FLAGS;
+
+    uint64_t event = 0;
+    if (repeated) {
+        // Devices are only asked once the loop came back unchanged, which
+        // keeps ordinary loops cheap. The iteration only proves anything if
+        // no device event fell inside it.
+        event = next_device_event();
+        if (idle.event >= this->cycles) {
+            // The last iteration changed nothing, so the next ones can't
+            // either until that event. Skip the iterations whose bus
+            // accesses all happen before it, the one crossing it runs normally.
+            uint64_t period = this->cycles - idle.cycles;
+            uint64_t target = idle_target(event);
+            if (target > this->cycles) {
+                uint64_t skip = (target - this->cycles) / period * period;
+                this->cycles += skip;
+                this->skipped_cycles += skip;
+            }
+        }
+    }
+
+    idle.head = this->PC;
+    idle.cycles = this->cycles;
+    idle.writes = this->writes;
+    idle.event = event;
+    idle.A = this->A;
+    idle.X = this->X;
+    idle.Y = this->Y;
+    idle.SP = this->SP;
+    idle.FLAGS = this->FLAGS;
+    idle.valid = true;
+}
+
+void WDC65C02::push(byte val) {
+    write_mem(get_sp(), val);
+    this->SP--;
+}
+
+byte WDC65C02::pull() {
+    this->SP++;
+    return read_mem(get_sp());
+}
+
 byte WDC65C02::read_byte() {
     this->RWB = 1;                      // Set R/W to high for read operation
     this->bus.write_address(this->PC);  // Write the address to be read to the bus
@@ -159,17 +315,24 @@ byte WDC65C02::fetch_byte() {
         data = this->bus.read_data();  // Fallback to bus if no decoder
     }
 
-    this->PC++;   // Increment program counter after reading
-    return data;  // Return the read byte
+    // SYNC is high while the opcode is fetched
+    if (coverage) coverage->mark(this->SYNC ? CoverageKind::OPCODE : CoverageKind::OPERAND, this->PC);
+    if (pin_checker) pin_checker->check_read(this->PC, data);
+
+    this->cycles++;  // Every bus access takes one clock cycle
+    this->PC++;      // Increment program counter after reading
+    return data;     // Return the read byte
 }
 
 word WDC65C02::fetch_word() {
     // Check for invalid PC value (should never happen with 16-bit address)
     if (this->PC > 0xFFFE) {  // Can't read word at 0xFFFF (only byte)
-        std::stringstream ss;
-        ss << "Cannot read word at address: PC=0x" << std::hex << std::setfill('0') << std::setw(4) << this->PC
-           << " (end of memory)";
-        logger::error(ss.str());
+        if (logger::enabled) {
+            std::stringstream ss;
+            ss << "Cannot read word at address: PC=0x" << std::hex << std::setfill('0') << std::setw(4) << this->PC
+               << " (end of memory)";
+            logger::error(ss.str());
+        }
         this->state = CPU_State::HALTED;
         return 0x0000;
     }
@@ -186,6 +349,78 @@ word WDC65C02::fetch_word() {
     return (hi << 8) | lo;  // Combine high and low byte to form the word
 }
 
+byte WDC65C02::read_mem(word addr) {
+    this->RWB = 1;  // Set R/W to high for read operation
+
+    byte data = 0xFF;
+    if (decoder_ptr) {
+        data = decoder_ptr->read(addr);
+    } else if (bus.request_bus(BusOwner::CPU)) {
+        // Fall back to the pin level bus when there is no decoder
+        bus.write_address(addr);
+        data = bus.read_data();
+        bus.release_bus(BusOwner::CPU);
+    } else {
+        logger::error("Failed to get bus access for memory read");
+    }
+
+    if (coverage) coverage->mark(CoverageKind::READ, addr);
+    if (pin_checker) pin_checker->check_read(addr, data);
+
+    this->cycles++;  // Every bus access takes one clock cycle
+    return data;
+}
+
+void WDC65C02::write_mem(word addr, byte val) {
+    this->writes++;
+    if (coverage) coverage->mark(CoverageKind::WRITE, addr);
+
+    if (decoder_ptr) {
+        this->RWB = 0;  // Set to write mode
+        decoder_ptr->write(addr, val);
+        this->RWB = 1;  // Reset back to read mode
+        if (pin_checker) pin_checker->check_write(addr, val);
+        this->cycles++;
+        return;
+    }
+
+    this->cycles++;
+
+    // Fall back to the pin level bus when there is no decoder
+    if (bus.request_bus(BusOwner::CPU)) {
+        bus.write_address(addr);
+        bus.write_data(val);
+        this->RWB = 0;  // Set to write mode
+        // Signal that data is on the bus
+        this->SYNC = 0;
+        // Wait a cycle
+        this->RWB = 1;  // Reset back to read mode
+        this->SYNC = 1;
+        bus.release_bus(BusOwner::CPU);
+    } else {
+        logger::error("Failed to get bus access for memory write");
+    }
+}
+
+void WDC65C02::attach_monitor(SharedMonitor* monitor) {
+    this->monitor = monitor;
+    if (monitor) publish_state();
+}
+
+void WDC65C02::publish_state() {
+    MonitorSnapshot snapshot;
+    snapshot.A = A;
+    snapshot.X = X;
+    snapshot.Y = Y;
+    snapshot.SP = SP;
+    snapshot.FLAGS = FLAGS;
+    snapshot.PC = PC;
+    snapshot.state = state;
+    snapshot.cycles = cycles;
+    snapshot.skipped_cycles = skipped_cycles;
+    monitor->publish(snapshot);
+}
+
 void WDC65C02::boot() {
     this->state = CPU_State::POWER_ON;  // Set the CPU state to POWER_ON
     this->reset();                      // Call reset to initialize the CPU
@@ -206,184 +441,408 @@ const byte WDC65C02::get(const Register r) {
 static std::thread cpu_thread;
 static std::atomic<bool> cpu_running{false};
 
-// Execute a single instruction
-void WDC65C02::execute_instruction() {
+// Execute exactly one instruction, regardless of the clock pins
+void WDC65C02::step() {
+    step_instruction();
+
+    // Monitors see the state every instruction leaves
+    if (monitor) publish_state();
+    meter_cycles();
+}
+
+void WDC65C02::step_instruction() {
     if (state != CPU_State::RUNNING) {
         return;
     }
 
-    static bool waiting_for_clock_low = false;
-    static bool instruction_complete = true;
+    if (cycle_mode) {
+        step_cycles();
+        return;
+    }
 
-    // State machine for instruction execution synchronized with clock
-    if (this->PHI0 == 1 && !waiting_for_clock_low) {
-        // Clock is high, execute if we have a new instruction
-        if (instruction_complete) {
-            // Make sure bus has the current data
-            this->bus.write_address(this->PC);
-
-            // Fetch the opcode
-            byte opcode = fetch_byte();
-            // PC was decremented by fetch_byte()
-
-            // Execute the opcode
-            switch (opcode) {
-                case static_cast<byte>(Op::NOP): {
-                    // No Operation - just consume a cycle
-                    break;
-                }
+    // RDY held low from outside stalls the CPU
+    if (this->RDY == 0) {
+        cycles++;
+        return;
+    }
 
-                case static_cast<byte>(Op::LDA_IM): {
-                    // Load Accumulator with Immediate value
-                    byte value = fetch_byte();
-                    A = value;
-                    // Set flags
-                    FLAGS_Z = (A == 0);
-                    FLAGS_N = ((A & 0x80) != 0);
-                    break;
-                }
+    // A bus master (DMA) that wants the bus gets it first
+    if (bus.has_masters()) {
+        yield_bus();
+    }
 
-                case static_cast<byte>(Op::LDX_IM): {
-                    // Load X Register with Immediate value
-                    byte value = fetch_byte();
-                    X = value;
-                    // Set flags
-                    FLAGS_Z = (X == 0);
-                    FLAGS_N = ((X & 0x80) != 0);
-                    break;
-                }
+    // Interrupts are only taken between instructions
+    if (word vector = due_interrupt()) {
+        interrupt(vector);
+    }
 
-                case static_cast<byte>(Op::LDY_IM): {
-                    // Load Y Register with Immediate value
-                    byte value = fetch_byte();
-                    Y = value;
-                    // Set flags
-                    FLAGS_Z = (Y == 0);
-                    FLAGS_N = ((Y & 0x80) != 0);
-                    break;
-                }
+    // Nothing runs after WAI until IRQB or NMIB is pulled low
+    if (waiting) {
+        if (this->IRQB == 0) {
+            waiting = false;  // A masked IRQ resumes after the WAI without vectoring
+        } else {
+            uint64_t target = idle_skip ? idle_target(next_device_event()) : 0;
+            if (target > cycles) {
+                skipped_cycles += target - cycles;
+                cycles = target;
+            } else {
+                cycles++;
+            }
+            return;
+        }
+    }
 
-                case static_cast<byte>(Op::STA_ABS): {
-                    // Store Accumulator to Absolute address
-                    word addr = fetch_word();
-                    if (bus.request_bus(BusOwner::CPU)) {
-                        bus.write_address(addr);
-                        bus.write_data(A);
-                        this->RWB = 0;  // Set to write mode
-                        // Signal that data is on the bus
-                        this->SYNC = 0;
-                        // Wait a cycle
-                        this->RWB = 1;  // Reset back to read mode
-                        this->SYNC = 1;
-                        bus.release_bus(BusOwner::CPU);
-                    } else {
-                        logger::error("Failed to get bus access for STA_ABS");
-                    }
-                    break;
-                }
+    // Stop before the instruction when it is on a breakpoint
+    if (debugger && debugger->break_at(PC)) {
+        return;
+    }
 
-                case static_cast<byte>(Op::LDA_AB): {
-                    // Load Accumulator from Absolute address
-                    word addr = fetch_word();
-                    if (bus.request_bus(BusOwner::CPU)) {
-                        bus.write_address(addr);
-                        A = bus.read_data();
-                        // Set flags
-                        FLAGS_Z = (A == 0);
-                        FLAGS_N = ((A & 0x80) != 0);
-                        bus.release_bus(BusOwner::CPU);
-                    } else {
-                        logger::error("Failed to get bus access for LDA_AB");
-                    }
-                    break;
-                }
+    // Fetch the opcode
+    word opcode_addr = PC;
+    this->SYNC = 1;
+    byte opcode = fetch_byte();
+    this->SYNC = 0;
+    if (metrics::enabled.load(std::memory_order_relaxed)) metrics::count_opcode(opcode);
+
+    // Fetch the operand, its size comes from the instruction table
+    const InstructionInfo& info = INSTRUCTIONS[opcode];
+    word operand = 0;
+    if (info.length == 2) {
+        operand = fetch_byte();
+    } else if (info.length == 3) {
+        operand = fetch_word();
+    }
 
-                case static_cast<byte>(Op::INX): {
-                    // Increment X Register
-                    X++;
-                    // Set flags
-                    FLAGS_Z = (X == 0);
-                    FLAGS_N = ((X & 0x80) != 0);
-                    break;
-                }
+    // Execute the opcode
+    switch (opcode) {
+        case static_cast<byte>(Op::NOP): {
+            // No Operation - just consume a cycle
+            cycles++;
+            break;
+        }
 
-                case static_cast<byte>(Op::INY): {
-                    // Increment Y Register
-                    Y++;
-                    // Set flags
-                    FLAGS_Z = (Y == 0);
-                    FLAGS_N = ((Y & 0x80) != 0);
-                    break;
-                }
+        case static_cast<byte>(Op::LDA_IM): {
+            // Load Accumulator with Immediate value
+            A = operand;
+            // Set flags
+            FLAGS_Z = (A == 0);
+            FLAGS_N = ((A & 0x80) != 0);
+            break;
+        }
 
-                case static_cast<byte>(Op::DEX): {
-                    // Decrement X Register
-                    X--;
-                    // Set flags
-                    FLAGS_Z = (X == 0);
-                    FLAGS_N = ((X & 0x80) != 0);
-                    break;
-                }
+        case static_cast<byte>(Op::LDX_IM): {
+            // Load X Register with Immediate value
+            X = operand;
+            // Set flags
+            FLAGS_Z = (X == 0);
+            FLAGS_N = ((X & 0x80) != 0);
+            break;
+        }
 
-                case static_cast<byte>(Op::DEY): {
-                    // Decrement Y Register
-                    Y--;
-                    // Set flags
-                    FLAGS_Z = (Y == 0);
-                    FLAGS_N = ((Y & 0x80) != 0);
-                    break;
-                }
+        case static_cast<byte>(Op::LDY_IM): {
+            // Load Y Register with Immediate value
+            Y = operand;
+            // Set flags
+            FLAGS_Z = (Y == 0);
+            FLAGS_N = ((Y & 0x80) != 0);
+            break;
+        }
 
-                case static_cast<byte>(Op::TAX): {
-                    // Transfer Accumulator to X
-                    X = A;
-                    // Set flags
-                    FLAGS_Z = (X == 0);
-                    FLAGS_N = ((X & 0x80) != 0);
-                    break;
-                }
+        case static_cast<byte>(Op::STA_ABS): {
+            // Store Accumulator to Absolute address
+            write_mem(operand, A);
+            break;
+        }
 
-                case static_cast<byte>(Op::TAY): {
-                    // Transfer Accumulator to Y
-                    Y = A;
-                    // Set flags
-                    FLAGS_Z = (Y == 0);
-                    FLAGS_N = ((Y & 0x80) != 0);
-                    break;
-                }
+        case static_cast<byte>(Op::LDA_AB): {
+            // Load Accumulator from Absolute address
+            A = read_mem(operand);
+            // Set flags
+            FLAGS_Z = (A == 0);
+            FLAGS_N = ((A & 0x80) != 0);
+            break;
+        }
 
-                case static_cast<byte>(Op::TXA): {
-                    // Transfer X to Accumulator
-                    A = X;
-                    // Set flags
-                    FLAGS_Z = (A == 0);
-                    FLAGS_N = ((A & 0x80) != 0);
-                    break;
-                }
+        case static_cast<byte>(Op::INX): {
+            // Increment X Register
+            cycles++;  // Internal operation cycle
+            X++;
+            // Set flags
+            FLAGS_Z = (X == 0);
+            FLAGS_N = ((X & 0x80) != 0);
+            break;
+        }
 
-                case static_cast<byte>(Op::TYA): {
-                    // Transfer Y to Accumulator
-                    A = Y;
-                    // Set flags
-                    FLAGS_Z = (A == 0);
-                    FLAGS_N = ((A & 0x80) != 0);
-                    break;
-                }
+        case static_cast<byte>(Op::INY): {
+            // Increment Y Register
+            cycles++;  // Internal operation cycle
+            Y++;
+            // Set flags
+            FLAGS_Z = (Y == 0);
+            FLAGS_N = ((Y & 0x80) != 0);
+            break;
+        }
 
-                case 0x00:  // Handle BRK instruction
-                    // Force interrupt
-                    state = CPU_State::HALTED;
-                    break;
-
-                default: {
-                    std::stringstream ss;
-                    ss << "Unimplemented opcode: 0x" << std::hex << std::setfill('0') << std::setw(2) << (int)opcode
-                       << " at PC=0x" << std::hex << std::setfill('0') << std::setw(4) << (PC - 1);
-                    logger::error(ss.str());
-                    state = CPU_State::HALTED;
-                    break;
-                }
+        case static_cast<byte>(Op::DEX): {
+            // Decrement X Register
+            cycles++;  // Internal operation cycle
+            X--;
+            // Set flags
+            FLAGS_Z = (X == 0);
+            FLAGS_N = ((X & 0x80) != 0);
+            break;
+        }
+
+        case static_cast<byte>(Op::DEY): {
+            // Decrement Y Register
+            cycles++;  // Internal operation cycle
+            Y--;
+            // Set flags
+            FLAGS_Z = (Y == 0);
+            FLAGS_N = ((Y & 0x80) != 0);
+            break;
+        }
+
+        case static_cast<byte>(Op::TAX): {
+            // Transfer Accumulator to X
+            cycles++;  // Internal operation cycle
+            X = A;
+            // Set flags
+            FLAGS_Z = (X == 0);
+            FLAGS_N = ((X & 0x80) != 0);
+            break;
+        }
+
+        case static_cast<byte>(Op::TAY): {
+            // Transfer Accumulator to Y
+            cycles++;  // Internal operation cycle
+            Y = A;
+            // Set flags
+            FLAGS_Z = (Y == 0);
+            FLAGS_N = ((Y & 0x80) != 0);
+            break;
+        }
+
+        case static_cast<byte>(Op::TXA): {
+            // Transfer X to Accumulator
+            cycles++;  // Internal operation cycle
+            A = X;
+            // Set flags
+            FLAGS_Z = (A == 0);
+            FLAGS_N = ((A & 0x80) != 0);
+            break;
+        }
+
+        case static_cast<byte>(Op::TYA): {
+            // Transfer Y to Accumulator
+            cycles++;  // Internal operation cycle
+            A = Y;
+            // Set flags
+            FLAGS_Z = (A == 0);
+            FLAGS_N = ((A & 0x80) != 0);
+            break;
+        }
+
+        case static_cast<byte>(Op::ADC_IM): {
+            // Add with Carry Immediate value
+            add_with_carry(operand);
+            if (FLAGS_D) cycles++;  // Decimal correction cycle
+            break;
+        }
+
+        case static_cast<byte>(Op::ADC_ZP): {
+            // Add with Carry from Zero Page address
+            add_with_carry(read_mem(operand));
+            if (FLAGS_D) cycles++;  // Decimal correction cycle
+            break;
+        }
+
+        case static_cast<byte>(Op::ADC_AB): {
+            // Add with Carry from Absolute address
+            add_with_carry(read_mem(operand));
+            if (FLAGS_D) cycles++;  // Decimal correction cycle
+            break;
+        }
+
+        case static_cast<byte>(Op::SBC_IM): {
+            // Subtract with Carry Immediate value
+            subtract_with_carry(operand);
+            if (FLAGS_D) cycles++;  // Decimal correction cycle
+            break;
+        }
+
+        case static_cast<byte>(Op::SBC_ZP): {
+            // Subtract with Carry from Zero Page address
+            subtract_with_carry(read_mem(operand));
+            if (FLAGS_D) cycles++;  // Decimal correction cycle
+            break;
+        }
+
+        case static_cast<byte>(Op::SBC_AB): {
+            // Subtract with Carry from Absolute address
+            subtract_with_carry(read_mem(operand));
+            if (FLAGS_D) cycles++;  // Decimal correction cycle
+            break;
+        }
+
+        case static_cast<byte>(Op::CLC): {
+            // Clear Carry Flag
+            cycles++;  // Internal operation cycle
+            FLAGS_C = 0;
+            break;
+        }
+
+        case static_cast<byte>(Op::SEC): {
+            // Set Carry Flag
+            cycles++;  // Internal operation cycle
+            FLAGS_C = 1;
+            break;
+        }
+
+        case static_cast<byte>(Op::CLD): {
+            // Clear Decimal Mode
+            cycles++;  // Internal operation cycle
+            FLAGS_D = 0;
+            break;
+        }
+
+        case static_cast<byte>(Op::SED): {
+            // Set Decimal Mode
+            cycles++;  // Internal operation cycle
+            FLAGS_D = 1;
+            break;
+        }
+
+        case static_cast<byte>(Op::CLI): {
+            // Clear Interrupt Disable
+            cycles++;  // Internal operation cycle
+            FLAGS_I = 0;
+            break;
+        }
+
+        case static_cast<byte>(Op::SEI): {
+            // Set Interrupt Disable
+            cycles++;  // Internal operation cycle
+            FLAGS_I = 1;
+            break;
+        }
+
+        case static_cast<byte>(Op::RTI): {
+            // Return from Interrupt
+            cycles += 2;  // Internal cycle and dummy stack read
+            FLAGS = (pull() & ~0x10) | 0x20;
+            byte lo = pull();
+            byte hi = pull();
+            PC = (hi << 8) | lo;
+            break;
+        }
+
+        case static_cast<byte>(Op::WAI): {
+            // Wait for Interrupt
+            cycles += 2;  // Internal operation cycles
+            waiting = true;
+            break;
+        }
+
+        case static_cast<byte>(Op::JMP): {
+            // Jump to Absolute address
+            PC = operand;
+            break;
+        }
+
+        case static_cast<byte>(Op::JMPI): {
+            // Jump through the pointer at an Absolute address
+            cycles++;  // Internal operation cycle
+            byte lo = read_mem(operand);
+            byte hi = read_mem(operand + 1);
+            PC = (hi << 8) | lo;
+            break;
+        }
+
+        case static_cast<byte>(Op::JMPIX): {
+            // Jump through the pointer at an Absolute address plus X
+            cycles++;  // Internal operation cycle
+            word pointer = operand + X;
+            byte lo = read_mem(pointer);
+            byte hi = read_mem(pointer + 1);
+            PC = (hi << 8) | lo;
+            break;
+        }
+
+        case static_cast<byte>(Op::BRA):
+            branch(true, operand);
+            break;
+
+        case static_cast<byte>(Op::BPL):
+            branch(!FLAGS_N, operand);
+            break;
+
+        case static_cast<byte>(Op::BMI):
+            branch(FLAGS_N, operand);
+            break;
+
+        case static_cast<byte>(Op::BVC):
+            branch(!FLAGS_V, operand);
+            break;
+
+        case static_cast<byte>(Op::BVS):
+            branch(FLAGS_V, operand);
+            break;
+
+        case static_cast<byte>(Op::BCC):
+            branch(!FLAGS_C, operand);
+            break;
+
+        case static_cast<byte>(Op::BCS):
+            branch(FLAGS_C, operand);
+            break;
+
+        case static_cast<byte>(Op::BNE):
+            branch(!FLAGS_Z, operand);
+            break;
+
+        case static_cast<byte>(Op::BEQ):
+            branch(FLAGS_Z, operand);
+            break;
+
+        case 0x00:  // Handle BRK instruction
+            // Force interrupt
+            state = CPU_State::HALTED;
+            break;
+
+        default: {
+            if (logger::enabled) {
+                std::stringstream ss;
+                ss << "Unimplemented opcode: 0x" << std::hex << std::setfill('0') << std::setw(2) << (int)opcode
+                   << " (" << info.mnemonic << ") at PC=0x" << std::hex << std::setfill('0') << std::setw(4)
+                   << opcode_addr;
+                logger::error(ss.str());
             }
+            state = CPU_State::HALTED;
+            break;
+        }
+    }
+
+    // A backward jump may close an idle loop
+    if (idle_skip && PC <= opcode_addr && state == CPU_State::RUNNING) {
+        check_idle_loop();
+    }
+}
+
+// Execute a single instruction, synchronized with the clock on PHI0
+void WDC65C02::execute_instruction() {
+    if (state != CPU_State::RUNNING) {
+        return;
+    }
+
+    static bool waiting_for_clock_low = false;
+    static bool instruction_complete = true;
+
+    // State machine for instruction execution synchronized with clock
+    if (this->PHI0 == 1 && !waiting_for_clock_low) {
+        // Clock is high, execute if we have a new instruction
+        if (instruction_complete) {
+            step();
 
             // Mark that we need to wait for clock to go low before next instruction
             waiting_for_clock_low = true;
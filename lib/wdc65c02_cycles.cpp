@@ -0,0 +1,427 @@
+// Cycle mode of the WDC65C02: instructions run one bus cycle per `tick()`
+// from the sequences in microcode.h
+
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+#include "debugger.h"
+#include "instructions.h"
+#include "log.h"
+#include "metrics.h"
+#include "microcode.h"
+#include "op_codes.h"
+#include "pin_checker.h"
+#include "wdc65c02.h"
+
+// Whether the branch `opcode` is taken with `flags`
+static bool branch_taken(byte opcode, byte flags) {
+    switch (static_cast<Op>(opcode)) {
+        case Op::BPL:
+            return !(flags & 0x80);
+        case Op::BMI:
+            return flags & 0x80;
+        case Op::BVC:
+            return !(flags & 0x40);
+        case Op::BVS:
+            return flags & 0x40;
+        case Op::BCC:
+            return !(flags & 0x01);
+        case Op::BCS:
+            return flags & 0x01;
+        case Op::BNE:
+            return !(flags & 0x02);
+        case Op::BEQ:
+            return flags & 0x02;
+        default:
+            return true;  // BRA
+    }
+}
+
+void WDC65C02::set_cycle_mode(bool enabled) {
+    this->cycle_mode_requested = enabled;
+    if (at_instruction_boundary()) {
+        this->cycle_mode = enabled;
+    }
+}
+
+void WDC65C02::tick() {
+    if (state != CPU_State::RUNNING) {
+        return;
+    }
+
+    if (at_instruction_boundary()) {
+        if (!cycle_mode) {
+            step();
+            return;
+        }
+        begin_sequence();
+    } else if (this->RDY == 0) {
+        cycles++;  // Stalled in the middle of the instruction
+        return;
+    }
+
+    const Microcode* code = sequence.code;
+    if (code == nullptr) {
+        return;  // Stalled, waiting or on a breakpoint
+    }
+
+    run_bus_step(code->steps[sequence.index++]);
+    if (state != CPU_State::RUNNING) {
+        // Halted by a failed access, the instruction is abandoned
+        sequence.code = nullptr;
+        cycle_mode = cycle_mode_requested;
+        if (monitor) publish_state();
+        meter_cycles();
+        return;
+    }
+
+    // Leave out the conditional steps that don't happen, so the
+    // instruction ends on its last real cycle
+    code = sequence.code;  // The opcode fetch picks the instruction's sequence
+    while (sequence.index < code->length && skipped(code->steps[sequence.index])) {
+        sequence.index++;
+    }
+
+    if (sequence.index == code->length) {
+        finish_instruction();
+        sequence.code = nullptr;
+        cycle_mode = cycle_mode_requested;
+        if (monitor) publish_state();
+        meter_cycles();
+    }
+}
+
+void WDC65C02::step_cycles() {
+    // Run to the end of the instruction in progress, or through a whole
+    // one. An interrupt sequence is followed by the first instruction of
+    // the handler, as in the instruction mode.
+    bool interrupted = false;
+    do {
+        tick();
+        if (sequence.code == &INTERRUPT_MICROCODE) interrupted = true;
+    } while (state == CPU_State::RUNNING && (!at_instruction_boundary() || std::exchange(interrupted, false)));
+}
+
+void WDC65C02::begin_sequence() {
+    sequence.index = 0;
+
+    // RDY held low from outside stalls the CPU
+    if (this->RDY == 0) {
+        cycles++;
+        return;
+    }
+
+    // A bus master (DMA) that wants the bus gets it first, its cycles
+    // come before the next fetch
+    if (bus.has_masters()) {
+        yield_bus();
+    }
+
+    // Interrupts are only taken between instructions
+    if (word vector = due_interrupt()) {
+        sequence.vector = vector;
+        sequence.code = &INTERRUPT_MICROCODE;
+        waiting = false;  // An interrupt ends WAI
+        return;
+    }
+
+    // Nothing runs after WAI until IRQB or NMIB is pulled low
+    if (waiting) {
+        if (this->IRQB == 0) {
+            waiting = false;  // A masked IRQ resumes after the WAI without vectoring
+        } else {
+            cycles++;
+            return;
+        }
+    }
+
+    // Stop before the instruction when it is on a breakpoint
+    if (debugger && debugger->break_at(PC)) {
+        return;
+    }
+
+    sequence.code = &FETCH_MICROCODE;
+}
+
+bool WDC65C02::skipped(BusStep step) const {
+    switch (step) {
+        case BusStep::DECIMAL:
+            return !FLAGS_D;
+        case BusStep::BRANCH:
+            return !branch_taken(sequence.opcode, FLAGS);
+        case BusStep::BRANCH_PAGE: {
+            word target = PC + static_cast<int8_t>(sequence.operand);
+            return !branch_taken(sequence.opcode, FLAGS) || (target & 0xFF00) == (PC & 0xFF00);
+        }
+        default:
+            return false;
+    }
+}
+
+void WDC65C02::run_bus_step(BusStep step) {
+    switch (step) {
+        case BusStep::OPCODE: {
+            sequence.opcode_addr = PC;
+            this->SYNC = 1;  // Tells coverage this is an opcode
+            sequence.opcode = fetch_byte();
+            if (metrics::enabled.load(std::memory_order_relaxed)) metrics::count_opcode(sequence.opcode);
+            sequence.operand = 0;
+            sequence.code = &MICROCODE[sequence.opcode];
+            sequence.index = 1;
+            // SYNC drops for the operand fetches, the opcode cycle shows it
+            // in `last_cycle` only
+            drive_pins(sequence.opcode_addr, sequence.opcode, false);
+            last_cycle.sync = true;
+            break;
+        }
+
+        case BusStep::OPERAND: {
+            word addr = PC;
+            sequence.operand = fetch_byte();
+            drive_pins(addr, sequence.operand, false);
+            break;
+        }
+
+        case BusStep::OPERAND_HIGH: {
+            word addr = PC;
+            byte hi = fetch_byte();
+            sequence.operand |= hi << 8;
+            drive_pins(addr, hi, false);
+            break;
+        }
+
+        case BusStep::DUMMY_PC:
+        case BusStep::DECIMAL:
+        case BusStep::BRANCH:
+        case BusStep::BRANCH_PAGE:
+            drive_pins(PC, dummy_read(PC), false);
+            break;
+
+        case BusStep::READ:
+            sequence.data = read_mem(sequence.operand);
+            drive_pins(sequence.operand, sequence.data, false);
+            break;
+
+        case BusStep::WRITE:
+            write_mem(sequence.operand, A);  // STA is the only store so far
+            drive_pins(sequence.operand, A, true);
+            break;
+
+        case BusStep::POINTER_LOW:
+            sequence.pointer = sequence.operand;
+            if (sequence.opcode == static_cast<byte>(Op::JMPIX)) sequence.pointer += X;
+            sequence.data = read_mem(sequence.pointer);
+            drive_pins(sequence.pointer, sequence.data, false);
+            break;
+
+        case BusStep::POINTER_HIGH: {
+            word addr = sequence.pointer + 1;
+            byte hi = read_mem(addr);
+            PC = (hi << 8) | sequence.data;
+            drive_pins(addr, hi, false);
+            break;
+        }
+
+        case BusStep::DUMMY_STACK:
+            drive_pins(get_sp(), dummy_read(get_sp()), false);
+            break;
+
+        case BusStep::PUSH_PCH: {
+            word addr = get_sp();
+            push(PC >> 8);
+            drive_pins(addr, PC >> 8, true);
+            break;
+        }
+
+        case BusStep::PUSH_PCL: {
+            word addr = get_sp();
+            push(PC & 0xFF);
+            drive_pins(addr, PC & 0xFF, true);
+            break;
+        }
+
+        case BusStep::PUSH_P: {
+            word addr = get_sp();
+            byte flags = (FLAGS | 0x20) & ~0x10;  // B clear tells a hardware interrupt from BRK
+            push(flags);
+            drive_pins(addr, flags, true);
+            this->FLAGS_I = 1;  // Mask further IRQs
+            this->FLAGS_D = 0;  // The 65C02 leaves decimal mode on interrupts
+            break;
+        }
+
+        case BusStep::PULL_P: {
+            byte flags = pull();
+            FLAGS = (flags & ~0x10) | 0x20;
+            drive_pins(get_sp(), flags, false);
+            break;
+        }
+
+        case BusStep::PULL_PCL:
+            sequence.data = pull();
+            drive_pins(get_sp(), sequence.data, false);
+            break;
+
+        case BusStep::PULL_PCH: {
+            byte hi = pull();
+            PC = (hi << 8) | sequence.data;
+            drive_pins(get_sp(), hi, false);
+            break;
+        }
+
+        case BusStep::VECTOR_LOW:
+            sequence.data = read_mem(sequence.vector);
+            drive_pins(sequence.vector, sequence.data, false);
+            break;
+
+        case BusStep::VECTOR_HIGH: {
+            word addr = sequence.vector + 1;
+            byte hi = read_mem(addr);
+            PC = (hi << 8) | sequence.data;
+            drive_pins(addr, hi, false);
+            break;
+        }
+    }
+}
+
+void WDC65C02::finish_instruction() {
+    const Microcode* code = sequence.code;
+    if (code == &INTERRUPT_MICROCODE) return;
+
+    byte opcode = sequence.opcode;
+    byte operand = sequence.operand & 0xFF;
+    auto load = [this](byte& reg, byte value) {
+        reg = value;
+        FLAGS_Z = (value == 0);
+        FLAGS_N = ((value & 0x80) != 0);
+    };
+
+    if (!code->implemented) {
+        if (opcode != static_cast<byte>(Op::BRK) && logger::enabled) {
+            std::stringstream ss;
+            ss << "Unimplemented opcode: 0x" << std::hex << std::setfill('0') << std::setw(2) << (int)opcode << " ("
+               << INSTRUCTIONS[opcode].mnemonic << ") at PC=0x" << std::hex << std::setfill('0') << std::setw(4)
+               << sequence.opcode_addr;
+            logger::error(ss.str());
+        }
+        state = CPU_State::HALTED;
+        return;
+    }
+
+    switch (static_cast<Op>(opcode)) {
+        case Op::LDA_IM:
+            load(A, operand);
+            break;
+        case Op::LDX_IM:
+            load(X, operand);
+            break;
+        case Op::LDY_IM:
+            load(Y, operand);
+            break;
+        case Op::LDA_AB:
+            load(A, sequence.data);
+            break;
+        case Op::INX:
+            load(X, X + 1);
+            break;
+        case Op::INY:
+            load(Y, Y + 1);
+            break;
+        case Op::DEX:
+            load(X, X - 1);
+            break;
+        case Op::DEY:
+            load(Y, Y - 1);
+            break;
+        case Op::TAX:
+            load(X, A);
+            break;
+        case Op::TAY:
+            load(Y, A);
+            break;
+        case Op::TXA:
+            load(A, X);
+            break;
+        case Op::TYA:
+            load(A, Y);
+            break;
+        case Op::ADC_IM:
+            add_with_carry(operand);
+            break;
+        case Op::ADC_ZP:
+        case Op::ADC_AB:
+            add_with_carry(sequence.data);
+            break;
+        case Op::SBC_IM:
+            subtract_with_carry(operand);
+            break;
+        case Op::SBC_ZP:
+        case Op::SBC_AB:
+            subtract_with_carry(sequence.data);
+            break;
+        case Op::CLC:
+            FLAGS_C = 0;
+            break;
+        case Op::SEC:
+            FLAGS_C = 1;
+            break;
+        case Op::CLD:
+            FLAGS_D = 0;
+            break;
+        case Op::SED:
+            FLAGS_D = 1;
+            break;
+        case Op::CLI:
+            FLAGS_I = 0;
+            break;
+        case Op::SEI:
+            FLAGS_I = 1;
+            break;
+        case Op::WAI:
+            waiting = true;
+            break;
+        case Op::JMP:
+            PC = sequence.operand;
+            break;
+        case Op::BRA:
+        case Op::BPL:
+        case Op::BMI:
+        case Op::BVC:
+        case Op::BVS:
+        case Op::BCC:
+        case Op::BCS:
+        case Op::BNE:
+        case Op::BEQ:
+            if (branch_taken(opcode, FLAGS)) PC += static_cast<int8_t>(operand);
+            break;
+        default:
+            break;  // NOP, STA, JMP (ind), RTI: done by their bus cycles
+    }
+}
+
+byte WDC65C02::dummy_read(word addr) {
+    this->RWB = 1;
+
+    // A real read, devices see it, but it isn't coverage
+    byte data = 0xFF;
+    if (decoder_ptr) {
+        data = decoder_ptr->read(addr);
+    } else if (bus.request_bus(BusOwner::CPU)) {
+        bus.write_address(addr);
+        data = bus.read_data();
+        bus.release_bus(BusOwner::CPU);
+    }
+    if (pin_checker) pin_checker->check_read(addr, data);
+
+    this->cycles++;
+    return data;
+}
+
+void WDC65C02::drive_pins(word addr, byte data, bool write) {
+    this->ADDR = addr;
+    this->DATA = data;
+    this->RWB = write ? 0 : 1;
+    this->SYNC = 0;
+    last_cycle = {addr, data, write, false};
+}
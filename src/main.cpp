@@ -1,15 +1,33 @@
 #include <algorithm>  // For std::max
+#include <cerrno>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
 #include <iomanip>
+#include <iostream>
+#include <memory>
 #include <sstream>
 #include <thread>
 
 #include "at28c256.h"
 #include "bus.h"
+#include "coverage.h"
+#include "debugger.h"
 #include "decoder.h"
+#include "disassembler.h"
+#include "dma.h"
+#include "gdb_server.h"
+#include "hd44780.h"
 #include "hm62256b.h"
 #include "log.h"
+#include "metrics_writer.h"
 #include "mm_clock.h"
+#include "pin_checker.h"
+#include "semihost.h"
+#include "shared_monitor.h"
+#include "w65c22.h"
+#include "w65c51.h"
 #include "wdc65c02.h"
 
 // Enhanced test program with multiple instructions
@@ -26,49 +44,151 @@ const byte EXAMPLE_PROGRAM[] = {
     0x00               // BRK - Break (halt CPU)
 };
 
+// Logs the output pins of the VIA ports, standing in for the LEDs
+// on the breadboard build
+class PortLogger : public ViaPortListener {
+   public:
+    void port_written(ViaPort port, byte value, byte ddr) override {
+        std::stringstream ss;
+        ss << "VIA port " << (port == ViaPort::A ? 'A' : 'B') << " = 0x" << std::hex << std::setfill('0')
+           << std::setw(2) << (int)(value & ddr) << " (DDR 0x" << std::setw(2) << (int)ddr << ")";
+        logger::info(ss.str());
+    }
+};
+
+// The whole of `text` as a number, false for anything else (trailing
+// characters, out of range, NaN)
+static bool parse_double(const char* text, double& value) {
+    char* end;
+    errno = 0;
+    value = std::strtod(text, &end);
+    return end != text && *end == '\0' && errno == 0 && !std::isnan(value);
+}
+
+// The whole of `text` as an integer (decimal, 0x hex or 0 octal), false
+// for anything else
+static bool parse_long(const char* text, long& value) {
+    char* end;
+    errno = 0;
+    value = std::strtol(text, &end, 0);
+    return end != text && *end == '\0' && errno == 0;
+}
+
 void load_program(AT28C256& eeprom, const byte* program, size_t size, word start_addr = 0x8000) {
     // Calculate the local offset for the EEPROM (removing the 0x8000 base)
     word local_addr = start_addr - 0x8000;
 
-    // Load the program into EEPROM
-    logger::info("Loading program into EEPROM at 0x" + std::to_string(start_addr) + ":");
-    for (size_t i = 0; i < size; i++) {
-        eeprom.memory[local_addr + i] = program[i];
-        // Only log every few bytes to reduce output noise
-        if (i % 4 == 0 || i == size - 1) {
-            std::stringstream ss;
-            ss << "  0x" << std::hex << std::setfill('0') << std::setw(4) << (start_addr + i) << ": 0x" << std::hex
-               << std::setfill('0') << std::setw(2) << (int)program[i];
-            logger::info(ss.str());
-        }
-    }
+    // Load the program into EEPROM in one block
+    eeprom.load(program, size, local_addr);
 
     // Write reset vector at 0xFFFC to point to our program
-    byte low_byte = start_addr & 0xFF;
-    byte high_byte = (start_addr >> 8) & 0xFF;
-
-    // Write reset vector to EEPROM (at offset 0x7FFC from the base of 0x8000)
-    word reset_vector_offset = 0x7FFC;                   // 0xFFFC - 0x8000
-    eeprom.memory[reset_vector_offset] = low_byte;       // Low byte
-    eeprom.memory[reset_vector_offset + 1] = high_byte;  // High byte
+    // (at offset 0x7FFC from the base of 0x8000)
+    const byte reset_vector[] = {static_cast<byte>(start_addr & 0xFF), static_cast<byte>((start_addr >> 8) & 0xFF)};
+    eeprom.load(reset_vector, sizeof(reset_vector), 0x7FFC);
 
     std::stringstream ss;
-    ss << "Reset vector set to 0x" << std::hex << std::setfill('0') << std::setw(4) << ((high_byte << 8) | low_byte)
-       << " (0x" << std::hex << std::setfill('0') << std::setw(2) << (int)high_byte << std::setfill('0') << std::setw(2)
-       << (int)low_byte << ")";
+    ss << "Loaded " << std::dec << size << " bytes at 0x" << std::hex << std::setfill('0') << std::setw(4)
+       << start_addr << ", reset vector set to 0x" << std::setw(4) << start_addr;
     logger::info(ss.str());
-
-    // Verify reset vector was written correctly
-    byte read_low = eeprom.memory[reset_vector_offset];
-    byte read_high = eeprom.memory[reset_vector_offset + 1];
-    std::stringstream ss2;
-    ss2 << "Verified reset vector: 0x" << std::hex << std::setfill('0') << std::setw(4)
-        << ((read_high << 8) | read_low);
-    logger::info(ss2.str());
 }
 
-int main() {
+int main(int argc, char** argv) {
     logger::print("WDC65C02 Computer Simulator");
+
+    // An optional ROM image (e.g. the output of scripts/makerom.py) replaces
+    // the built-in example program. It is mapped, not copied.
+    //
+    // With `--persist` firmware writes to the EEPROM are kept in the image
+    // file, the same way the real chip keeps them across power cycles.
+    // They reach the disk on exit, and with `--persist-sync MS` also in the
+    // background at most every MS milliseconds while the firmware writes.
+    //
+    // `--serial stdio|pty|unix:PATH` bridges the ACIA to the host.
+    //
+    // `--lcd` hangs a 16x2 HD44780 off the VIA (data on port B, E / RW / RS
+    // on PA7 / PA6 / PA5) instead of logging the port writes.
+    //
+    // `--gdb PORT|unix:PATH` waits for a GDB remote protocol client and
+    // lets it drive the CPU instead of running the logged example loop.
+    //
+    // `--coverage FILE` records code and data coverage and merges it into
+    // FILE on exit, with an annotated listing of the ROM in FILE.lst.
+    //
+    // `--verify-pins FRACTION` repeats that fraction (0 to 1) of the memory
+    // accesses through the SRAM / EEPROM pins and reports any difference
+    // from the decoder on exit. The threads that mirror memory onto the bus
+    // stay off so they can't race the checker.
+    //
+    // `--semihost ADDR` maps the semihosting registers at ADDR-ADDR+15 (e.g.
+    // 0x7F00) for test firmware: console output, exit codes (returned by the
+    // emulator) and cycle counts. `--semihost-files DIR` also lets it load
+    // and save files below DIR.
+    //
+    // `--shm NAME` keeps the SRAM / EEPROM contents and the CPU registers in
+    // the POSIX shared memory segment NAME (e.g. /m6502) for dashboards and
+    // other tools to watch (see shared_monitor.h).
+    //
+    // `--metrics FILE` counts instructions, cycles, bus waits and the like
+    // and rewrites FILE every second, as JSON when it ends in .json and in
+    // the Prometheus text format otherwise.
+    const char* rom_path = nullptr;
+    RomMapping rom_mode = RomMapping::SHARED_READONLY;
+    long persist_sync_ms = 0;  // Background sync interval of a persistent image, 0 for exit only
+    std::string serial;
+    bool lcd_attached = false;
+    std::string gdb;
+    std::string coverage_path;
+    double verify_pins = -1;  // Fraction of accesses to check, negative when off
+    int semihost_addr = -1;   // Base of the semihosting registers, negative when off
+    std::string semihost_files;
+    std::string shm_name;
+    std::string metrics_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--persist") {
+            rom_mode = RomMapping::PERSISTENT;
+        } else if (arg == "--persist-sync" && i + 1 < argc) {
+            if (!parse_long(argv[++i], persist_sync_ms) || persist_sync_ms < 0) {
+                logger::error(std::string("Invalid --persist-sync interval: ") + argv[i] + " (expected milliseconds)");
+                return 1;
+            }
+        } else if (arg == "--serial" && i + 1 < argc) {
+            serial = argv[++i];
+        } else if (arg == "--gdb" && i + 1 < argc) {
+            gdb = argv[++i];
+        } else if (arg == "--coverage" && i + 1 < argc) {
+            coverage_path = argv[++i];
+        } else if (arg == "--verify-pins" && i + 1 < argc) {
+            if (!parse_double(argv[++i], verify_pins) || verify_pins < 0 || verify_pins > 1) {
+                logger::error(std::string("Invalid --verify-pins fraction: ") + argv[i] + " (expected 0 to 1)");
+                return 1;
+            }
+        } else if (arg == "--semihost" && i + 1 < argc) {
+            long addr;
+            if (!parse_long(argv[++i], addr) || addr < 0 || addr > 0xFFFF) {
+                logger::error(std::string("Invalid --semihost address: ") + argv[i] + " (expected 0x0000 to 0xFFFF)");
+                return 1;
+            }
+            semihost_addr = addr & 0xFFF0;
+        } else if (arg == "--semihost-files" && i + 1 < argc) {
+            semihost_files = argv[++i];
+        } else if (arg == "--shm" && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metrics_path = argv[++i];
+        } else if (arg == "--lcd") {
+            lcd_attached = true;
+        } else {
+            rom_path = argv[i];
+        }
+    }
+
+    // There is no image to keep the writes in
+    if (rom_mode == RomMapping::PERSISTENT && !rom_path) {
+        logger::error("--persist needs a ROM image file");
+        return 1;
+    }
+
     logger::info("Initializing components...");
 
     try {
@@ -86,23 +206,151 @@ int main() {
         // - 50.0 Hz = Very fast execution, useful for quick testing
         MM_ClockModule clock(2.0f, ClockMode::A_STABLE);
 
+        // Runtime metrics, the effective clock rate is compared to the clock's
+        MetricsWriter metrics_writer(metrics_path);
+        if (!metrics_path.empty()) {
+            metrics_writer.set_configured_clock(clock.get_speed());
+            metrics_writer.start();
+        }
+
+        // Shared memory segment for external monitors, it holds the chips'
+        // contents and so has to outlive them
+        std::unique_ptr<SharedMonitor> monitor;
+        if (!shm_name.empty()) monitor = std::make_unique<SharedMonitor>(shm_name);
+
         // Create memory modules
-        AT28C256 eeprom(system_bus);  // EEPROM for ROM (0x8000-0xFFFF)
-        HM62256B sram(system_bus);    // SRAM for RAM (0x0000-0x7FFF)
+        std::unique_ptr<AT28C256> eeprom_ptr;  // EEPROM for ROM (0x8000-0xFFFF)
+        if (rom_path && !monitor) {
+            eeprom_ptr = std::make_unique<AT28C256>(system_bus, rom_path, rom_mode);
+        } else {
+            eeprom_ptr = std::make_unique<AT28C256>(system_bus);
+        }
+        AT28C256& eeprom = *eeprom_ptr;
+        HM62256B sram(system_bus);  // SRAM for RAM (0x0000-0x7FFF)
 
         // Create address decoder and configure memory map
         AddressDecoder decoder;
         decoder.add_mapping(0x0000, 0x7FFF, &sram);    // SRAM at 0x0000-0x7FFF
         decoder.add_mapping(0x8000, 0xFFFF, &eeprom);  // EEPROM at 0x8000-0xFFFF
 
+        // W65C22 VIA at 0x6000-0x600F, shadowing that part of the SRAM
+        W65C22 via;
+        PortLogger port_logger;
+        HD44780 lcd(16, 2, clock.get_speed());
+        HD44780_ViaAdapter lcd_adapter(lcd);
+        if (lcd_attached) {
+            via.attach_listener(&lcd_adapter);
+        } else {
+            via.attach_listener(&port_logger);
+        }
+        decoder.add_device(0x6000, 0x600F, &via);
+
+        // W65C51 ACIA at 0x5000-0x5003
+        W65C51 acia(clock.get_speed());
+        decoder.add_device(0x5000, 0x5003, &acia);
+        if (serial == "stdio") {
+            acia.open_stdio();
+        } else if (serial == "pty") {
+            acia.open_pty(nullptr);
+        } else if (serial.rfind("unix:", 0) == 0) {
+            acia.open_unix_socket(serial.substr(5));
+        }
+
+        // DMA controller at 0x5100-0x5107, it takes the bus from the CPU
+        // for whole transfers
+        DMAController dma(decoder);
+        decoder.add_device(0x5100, 0x5107, &dma);
+        system_bus.add_master(&dma, 1);
+
         // Create CPU and attach to bus with decoder
         WDC65C02 cpu(system_bus);
         cpu.set_decoder(&decoder);  // Explicitly set the decoder
 
+        Coverage coverage;
+        if (!coverage_path.empty()) cpu.attach_coverage(&coverage);
+
+        // Memory lives in the shared segment from here on, and the CPU
+        // publishes its registers there after every instruction
+        if (monitor) {
+            if (!monitor->attach(sram, eeprom, decoder)) return 1;
+            // Copied into the segment rather than mapped
+            if (rom_path && !eeprom.map_image(rom_path, rom_mode)) return 1;
+            cpu.attach_monitor(monitor.get());
+        }
+
+        // Semihosting registers, CMD_EXIT halts the CPU and sets the exit code
+        Semihost semihost(decoder, std::cout);
+        if (semihost_addr >= 0) {
+            decoder.add_device(semihost_addr, semihost_addr + 0x0F, &semihost);
+            semihost.attach_cycle_counter(&cpu.cycles);
+            if (!semihost_files.empty()) semihost.set_file_root(semihost_files);
+            semihost.set_exit_handler([&cpu](int code) {
+                logger::info("Semihosting exit with code " + std::to_string(code));
+                cpu.state = CPU_State::HALTED;
+            });
+        }
+
+        PinChecker pin_checker(system_bus, decoder, verify_pins);
+        if (verify_pins >= 0) {
+            pin_checker.add_chip(0x0000, 0x7FFF, sram);
+            pin_checker.add_chip(0x8000, 0xFFFF, eeprom);
+            pin_checker.attach_cycle_counter(&cpu.cycles);
+            cpu.attach_pin_checker(&pin_checker);
+        }
+
+        // Log the pin check's counts and mismatches
+        auto report_pin_check = [&]() {
+            if (verify_pins < 0) return;
+            std::stringstream report;
+            pin_checker.report(report);
+            std::string line;
+            while (std::getline(report, line)) {
+                if (pin_checker.mismatch_total() > 0) {
+                    logger::error(line);
+                } else {
+                    logger::info(line);
+                }
+            }
+        };
+
+        // Merge this run into the coverage file and list the ROM
+        auto save_coverage = [&]() {
+            if (coverage_path.empty()) return;
+            coverage.merge_file(coverage_path);  // Earlier runs, if any
+            if (!coverage.save(coverage_path)) {
+                logger::error("Cannot write coverage to " + coverage_path);
+                return;
+            }
+            std::ofstream listing(coverage_path + ".lst");
+            coverage.report(listing, decoder, 0x8000, 0xFFFF);
+            logger::info("Coverage written to " + coverage_path);
+        };
+
+        // EEPROM write cycles are timed on the CPU's cycle counter
+        eeprom.attach_cycle_counter(&cpu.cycles, clock.get_speed());
+        eeprom.set_sync_interval(std::chrono::milliseconds(persist_sync_ms));
+
+        // VIA, ACIA and DMA IRQ outputs drive the CPU's IRQB line
+        cpu.attach_irq_source(&via);
+        cpu.attach_irq_source(&acia);
+        cpu.attach_irq_source(&dma);
+
+        // Loops waiting on the VIA / ACIA (and WAI) jump to their next event
+        cpu.set_idle_skip(true);
+
+        // The LCD's busy flag is timed on the cycle counter as well
+        if (lcd_attached) {
+            lcd.attach_cycle_counter(&cpu.cycles);
+            lcd.start_rendering();
+        }
+
         // Load example program into EEPROM - now correctly at 0x8000
         logger::header("LOADING PROGRAM DATA");
-        load_program(eeprom, EXAMPLE_PROGRAM, sizeof(EXAMPLE_PROGRAM), 0x8000);
-        logger::info("Program loaded successfully. Size: " + std::to_string(sizeof(EXAMPLE_PROGRAM)) + " bytes");
+        if (rom_path) {
+            logger::info(std::string("Mapped ROM image ") + rom_path);
+        } else {
+            load_program(eeprom, EXAMPLE_PROGRAM, sizeof(EXAMPLE_PROGRAM), 0x8000);
+        }
         logger::divider();
 
         // Start the clock module
@@ -129,9 +377,11 @@ int main() {
         clock_connect_thread.detach();
 
         // Start the memory monitoring
-        logger::info("Starting memory modules monitoring...");
-        eeprom.start_monitoring();
-        sram.start_monitoring();
+        if (verify_pins < 0) {
+            logger::info("Starting memory modules monitoring...");
+            eeprom.start_monitoring();
+            sram.start_monitoring();
+        }
 
         // Configure EEPROM pins
         eeprom.CE = 0;  // Chip Enable active (low)
@@ -150,19 +400,8 @@ int main() {
         // Manually read the reset vector through the decoder
         // This simulates what happens during the CPU's reset sequence
         word reset_vector_addr = 0xFFFC;
-        byte low_byte = 0x00;
-        byte high_byte = 0x80;  // Hardcode to 0x8000 for predictability
-
-        // Set the reset vector in EEPROM
-        word eeprom_offset = reset_vector_addr - 0x8000;  // Calculate offset in EEPROM
-        if (eeprom_offset < 32 * 1024) {
-            eeprom.memory[eeprom_offset] = low_byte;
-            eeprom.memory[eeprom_offset + 1] = high_byte;
-        }
-
-        // Now read it through the decoder to verify
-        low_byte = decoder.read(reset_vector_addr);
-        high_byte = decoder.read(reset_vector_addr + 1);
+        byte low_byte = decoder.read(reset_vector_addr);
+        byte high_byte = decoder.read(reset_vector_addr + 1);
         word program_start = (high_byte << 8) | low_byte;
 
         std::stringstream ss;
@@ -186,43 +425,59 @@ int main() {
 
         // Copy the first instruction to the bus for the CPU to fetch
         system_bus.write_address(cpu.PC);
-        byte first_instr = eeprom.memory[cpu.PC];
+        byte first_instr = decoder.read(cpu.PC);
         system_bus.write_data(first_instr);
         std::stringstream first_instr_ss;
         first_instr_ss << "Initial instruction at PC=0x0000 is 0x" << std::hex << std::setfill('0') << std::setw(2)
                        << (int)first_instr;
         logger::info(first_instr_ss.str());
 
+        if (!gdb.empty()) {
+            logger::header("GDB REMOTE DEBUGGING");
+            Debugger debugger(cpu, decoder);
+            GdbServer server(cpu, decoder, debugger);
+            bool listening = gdb.rfind("unix:", 0) == 0 ? server.listen_unix(gdb.substr(5))
+                                                         : server.listen_tcp(std::stoi(gdb));
+            if (!listening) return 1;
+            server.serve();
+            save_coverage();
+            report_pin_check();
+            logger::info("Shutting down system...");
+            return semihost.exit_code();
+        }
+
         logger::header("CONNECTING MEMORY SYSTEM");
-        // Create a connection between memory and bus/CPU through the decoder
-        // This thread ensures that memory access happens correctly for all components
-        std::thread memory_connect_thread([&system_bus, &decoder, &eeprom, &sram]() {
-            // Run silently in background
-            while (true) {
-                // Read address from bus
-                word addr = system_bus.read_address();
-
-                // Use the appropriate memory module based on the address
-                if (addr < 0x8000) {
-                    // Address is in SRAM range (0x0000-0x7FFF)
-                    byte data = sram.memory[addr];
-                    system_bus.write_data(data);
-                } else {
-                    // Address is in EEPROM range (0x8000-0xFFFF)
-                    word eeprom_addr = addr - 0x8000;
-                    if (eeprom_addr < 32 * 1024) {
-                        byte data = eeprom.memory[eeprom_addr];
+        if (verify_pins < 0) {
+            // Create a connection between memory and bus/CPU through the decoder
+            // This thread ensures that memory access happens correctly for all components
+            std::thread memory_connect_thread([&system_bus, &decoder, &eeprom, &sram]() {
+                // Run silently in background
+                while (true) {
+                    // Read address from bus
+                    word addr = system_bus.read_address();
+
+                    // Use the appropriate memory module based on the address
+                    if (addr < 0x8000) {
+                        // Address is in SRAM range (0x0000-0x7FFF)
+                        byte data = sram.memory[addr];
                         system_bus.write_data(data);
+                    } else {
+                        // Address is in EEPROM range (0x8000-0xFFFF)
+                        word eeprom_addr = addr - 0x8000;
+                        if (eeprom_addr < 32 * 1024) {
+                            byte data = eeprom.memory[eeprom_addr];
+                            system_bus.write_data(data);
+                        }
                     }
-                }
 
-                // Reduced polling frequency to lower CPU usage
-                std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            }
-        });
+                    // Reduced polling frequency to lower CPU usage
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
 
-        // Detach the thread so it runs independently
-        memory_connect_thread.detach();
+            // Detach the thread so it runs independently
+            memory_connect_thread.detach();
+        }
 
         // Start execution
         cpu.execute();
@@ -291,10 +546,12 @@ int main() {
 
                     // Log the next instruction to be executed
                     {
+                        char text[DISASM_BUFFER];
+                        disassemble(decoder, cpu.PC, text);
                         std::stringstream ss;
                         ss << "Next instruction: 0x" << std::hex << std::setfill('0') << std::setw(2)
-                           << (int)current_instr << " at PC=0x" << std::hex << std::setfill('0') << std::setw(4)
-                           << cpu.PC;
+                           << (int)current_instr << " (" << text << ") at PC=0x" << std::hex << std::setfill('0')
+                           << std::setw(4) << cpu.PC;
                         logger::info(ss.str());
                     }
                 }
@@ -390,9 +647,11 @@ int main() {
             logger::header("EXECUTION LIMIT REACHED");
             logger::info("Program did not finish. Total cycles: " + std::to_string(total_cycles));
         }
+        save_coverage();
+        report_pin_check();
         logger::header("EXECUTION COMPLETE");
         logger::info("Shutting down system...");
-        return 0;
+        return semihost.exit_code();
     } catch (const std::exception& e) {
         logger::error("Exception in main: " + std::string(e.what()));
     } catch (...) {
@@ -0,0 +1,232 @@
+// Conformance and throughput harness for the standard 6502 / 65C02
+// functional test images
+//
+// Loads each image into a flat 64K RAM behind an `AddressDecoder`, runs it
+// headless on `WDC65C02` from its start address and waits for the trap the
+// tests end in (an instruction that jumps or branches to itself). Reaching
+// the success trap passes, any other trap, a halt or running out of
+// instructions fails. Halting on an opcode the core doesn't implement yet
+// is reported on its own (UNIMPLEMENTED), apart from a failed test. Each
+// run reports the instructions, cycles and MIPS.
+//
+// The core implements a subset of the instruction set (see `microcode.h`),
+// so the known images currently stop on an unimplemented opcode within
+// their first few instructions.
+//
+// Usage:
+//   functional_test [DIR | FILE[@LOAD,START,SUCCESS] ...]
+//
+// A directory is searched for the known images below, with their usual
+// addresses. Exits with 77 (skipped for CTest) when no image is found.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "decoder.h"
+#include "instructions.h"
+#include "memory.h"
+#include "microcode.h"
+#include "wdc65c02.h"
+
+static constexpr int EXIT_SKIPPED = 77;
+static constexpr uint64_t MAX_INSTRUCTIONS = 2000000000ULL;
+static constexpr int NO_ADDRESS = -1;
+
+// Plain 64K of RAM, the images cover the whole address space
+class FlatMemory : public MEM_Module {
+   public:
+    byte memory[0x10000] = {};
+
+    word read_word(word addr) override { return memory[addr]; }
+    byte read_byte(byte addr) override { return memory[addr]; }
+    void write_word(word addr, word data) override { memory[addr] = data & 0xFF; }
+    void write_byte(byte addr, byte data) override { memory[addr] = data; }
+};
+
+struct TestImage {
+    std::string path;
+    int load;
+    int start;
+    int success;     // Trap address of a pass, NO_ADDRESS when `error_byte` decides
+    int error_byte;  // Byte that is zero on a pass, NO_ADDRESS when unused
+};
+
+// The images as assembled with their default options
+struct KnownImage {
+    const char* file;
+    int load;
+    int start;
+    int success;
+    int error_byte;
+};
+
+static constexpr KnownImage KNOWN_IMAGES[] = {
+    {"6502_functional_test.bin", 0x0000, 0x0400, 0x3469, NO_ADDRESS},
+    {"65C02_extended_opcodes_test.bin", 0x0000, 0x0400, 0x24F1, NO_ADDRESS},
+    {"6502_decimal_test.bin", 0x0200, 0x0200, NO_ADDRESS, 0x000B},
+};
+
+enum class Outcome { PASS, FAIL, UNIMPLEMENTED };
+
+static const char* const OUTCOME_NAMES[] = {"PASS", "FAIL", "UNIMPLEMENTED"};
+
+struct Result {
+    Outcome outcome = Outcome::FAIL;
+    std::string reason;
+    uint64_t instructions = 0;
+    uint64_t cycles = 0;
+    double seconds = 0;
+};
+
+static Result run_image(const TestImage& image) {
+    Result result;
+
+    static FlatMemory ram;
+    std::memset(ram.memory, 0, sizeof ram.memory);
+
+    std::ifstream file(image.path, std::ios::binary);
+    if (!file) {
+        result.reason = "cannot open image";
+        return result;
+    }
+    file.read(reinterpret_cast<char*>(ram.memory + image.load), 0x10000 - image.load);
+
+    Bus bus;
+    AddressDecoder decoder;
+    decoder.add_mapping(0x0000, 0xFFFF, &ram);
+
+    WDC65C02 cpu(bus, &decoder);
+    cpu.state = CPU_State::RUNNING;
+    cpu.PC = image.start;
+
+    auto started = std::chrono::steady_clock::now();
+    word trap = 0;
+    bool trapped = false;
+    word pc = cpu.PC;
+    while (cpu.state == CPU_State::RUNNING && result.instructions < MAX_INSTRUCTIONS) {
+        pc = cpu.PC;
+        cpu.step();
+        result.instructions++;
+        if (cpu.PC == pc) {
+            trap = pc;
+            trapped = true;
+            break;
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    result.cycles = cpu.cycles;
+
+    char reason[64];
+    if (!trapped) {
+        byte opcode = ram.memory[pc];
+        if (cpu.state == CPU_State::HALTED && !MICROCODE[opcode].implemented) {
+            // Not a verdict on the test, the core can't run it yet
+            std::snprintf(reason, sizeof reason, "unimplemented opcode $%02X (%s) at $%04X", opcode,
+                          INSTRUCTIONS[opcode].mnemonic, pc);
+            result.outcome = Outcome::UNIMPLEMENTED;
+        } else if (cpu.state != CPU_State::RUNNING) {
+            std::snprintf(reason, sizeof reason, "halted at $%04X", cpu.PC);
+        } else {
+            std::snprintf(reason, sizeof reason, "no trap after %llu instructions",
+                          static_cast<unsigned long long>(result.instructions));
+        }
+        result.reason = reason;
+        return result;
+    }
+
+    if (image.success != NO_ADDRESS && trap != image.success) {
+        std::snprintf(reason, sizeof reason, "trapped at $%04X", trap);
+        result.reason = reason;
+        return result;
+    }
+    if (image.error_byte != NO_ADDRESS && ram.memory[image.error_byte] != 0) {
+        std::snprintf(reason, sizeof reason, "error byte $%02X at $%04X", ram.memory[image.error_byte], trap);
+        result.reason = reason;
+        return result;
+    }
+
+    result.outcome = Outcome::PASS;
+    return result;
+}
+
+// FILE[@LOAD,START,SUCCESS], addresses in hex. Known images don't need
+// the addresses.
+static bool parse_image(const std::string& argument, TestImage& image) {
+    size_t at = argument.find('@');
+    image.path = argument.substr(0, at);
+
+    if (at == std::string::npos) {
+        std::string name = image.path.substr(image.path.find_last_of('/') + 1);
+        for (const KnownImage& known : KNOWN_IMAGES) {
+            if (name == known.file) {
+                image = {image.path, known.load, known.start, known.success, known.error_byte};
+                return true;
+            }
+        }
+        return false;
+    }
+
+    unsigned load, start, success;
+    if (std::sscanf(argument.c_str() + at + 1, "%x,%x,%x", &load, &start, &success) != 3 || load > 0xFFFF ||
+        start > 0xFFFF || success > 0xFFFF) {
+        return false;
+    }
+    image.load = load;
+    image.start = start;
+    image.success = success;
+    image.error_byte = NO_ADDRESS;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+    if (arguments.empty()) arguments.push_back("tests/roms");
+
+    std::vector<TestImage> images;
+    for (const std::string& argument : arguments) {
+        if (std::filesystem::is_directory(argument)) {
+            // A directory, pick up the known images in it
+            for (const KnownImage& known : KNOWN_IMAGES) {
+                std::string path = argument + "/" + known.file;
+                if (std::filesystem::is_regular_file(path)) {
+                    images.push_back({path, known.load, known.start, known.success, known.error_byte});
+                }
+            }
+            continue;
+        }
+
+        TestImage image;
+        if (!parse_image(argument, image)) {
+            std::fprintf(stderr, "Invalid image argument: %s (expected FILE[@LOAD,START,SUCCESS])\n",
+                         argument.c_str());
+            return EXIT_FAILURE;
+        }
+        images.push_back(image);
+    }
+
+    if (images.empty()) {
+        std::printf("No functional test images found, see tests/roms/README.md\n");
+        return EXIT_SKIPPED;
+    }
+
+    bool all_passed = true;
+    for (const TestImage& image : images) {
+        Result result = run_image(image);
+        bool passed = result.outcome == Outcome::PASS;
+        double mips = result.seconds > 0 ? result.instructions / result.seconds / 1e6 : 0;
+        std::printf("%s %s: %llu instructions, %llu cycles, %.3fs, %.2f MIPS%s%s\n",
+                    OUTCOME_NAMES[static_cast<int>(result.outcome)], image.path.c_str(),
+                    static_cast<unsigned long long>(result.instructions),
+                    static_cast<unsigned long long>(result.cycles), result.seconds, mips, passed ? "" : " - ",
+                    result.reason.c_str());
+        all_passed = all_passed && passed;
+    }
+
+    return all_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,286 @@
+// In-process fuzz target for the CPU core
+//
+// Each input becomes a machine: the first bytes are the initial registers,
+// the rest is split between RAM and ROM. The CPU then runs for a bounded
+// number of cycles while the harness checks after every instruction that
+//
+//  - the PC moved past the instruction (or anywhere, for jumps, branches,
+//    calls and returns),
+//  - SP moved by what the instruction pushes or pulls,
+//  - the cycle count advanced,
+//  - the decoder only handed the memory modules offsets inside them.
+//
+// Anything else aborts, which the fuzzer reports as a crash (on top of the
+// sanitizers' findings). The machine is built once; between inputs only
+// the memory pages the previous input dirtied are restored, so an input
+// costs about as much as the instructions it runs.
+//
+// Input layout:
+//   A X Y SP FLAGS PCL PCH RAM_PAGES image...
+// The first RAM_PAGES * 256 bytes of the image (RAM_PAGES up to 64) go to
+// RAM at 0x0000, the remainder to ROM at 0x8000.
+//
+// Memory map: RAM 0x0000-0x3FFF, 128 bytes of scratch RAM at 0x4000-0x407F
+// (half a page, for the decoder's split page path), ROM 0x8000-0xFFFF. The
+// rest is unmapped, for the decoder's error path.
+//
+// Built against libFuzzer with -DM6502_LIBFUZZER=ON (Clang). Otherwise
+// `main()` below replays inputs:
+//   m6502_fuzz [FILE | DIR ...]   run each file (every file in a DIR)
+//   m6502_fuzz -runs=N            run N random inputs from a fixed seed
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "decoder.h"
+#include "instructions.h"
+#include "log.h"
+#include "memory.h"
+#include "wdc65c02.h"
+
+static constexpr uint64_t CYCLE_BUDGET = 4096;  // Cycles per input
+static constexpr size_t HEADER_SIZE = 8;
+static constexpr int MAX_RAM_PAGES = 64;
+static constexpr int ANY = -1000;  // Expected change that isn't checked
+
+// RAM or ROM that remembers which pages were changed since the last
+// `restore()`
+class FuzzMemory : public MEM_Module {
+   private:
+    std::vector<byte> data;
+    byte fill;
+    bool writable;
+    const char* name;
+    bool dirty[256] = {};
+    std::vector<byte> dirty_pages;
+
+    void mark(word offset) {
+        byte page = offset >> 8;
+        if (!dirty[page]) {
+            dirty[page] = true;
+            dirty_pages.push_back(page);
+        }
+    }
+
+    void check(word offset) const {
+        if (offset >= data.size()) {
+            std::fprintf(stderr, "%s: decoder passed offset 0x%04X beyond its 0x%zX bytes\n", name, offset,
+                         data.size());
+            std::abort();
+        }
+    }
+
+   public:
+    FuzzMemory(const char* name, size_t size, byte fill, bool writable)
+        : data(size, fill), fill(fill), writable(writable), name(name) {}
+
+    size_t size() const { return data.size(); }
+
+    // Copy an image in from the host side (ROM included)
+    void load(const byte* image, size_t size) {
+        if (size > data.size()) size = data.size();
+        std::memcpy(data.data(), image, size);
+        for (size_t offset = 0; offset < size; offset += 256) mark(offset);
+    }
+
+    // Back to all `fill`, touching only the dirty pages
+    void restore() {
+        for (byte page : dirty_pages) {
+            size_t start = page * 256;
+            std::memset(data.data() + start, fill, std::min<size_t>(256, data.size() - start));
+            dirty[page] = false;
+        }
+        dirty_pages.clear();
+    }
+
+    word read_word(word addr) override {
+        check(addr);
+        return data[addr];
+    }
+
+    byte read_byte(byte addr) override { return read_word(addr); }
+
+    void write_word(word addr, word value) override {
+        check(addr);
+        if (!writable) return;
+        data[addr] = value & 0xFF;
+        mark(addr);
+    }
+
+    void write_byte(byte addr, byte value) override { write_word(addr, value); }
+};
+
+// How each opcode moves the PC and SP when it doesn't halt
+struct Expectation {
+    int pc;  // Bytes past the opcode, or ANY
+    int sp;  // Change of SP, or ANY
+};
+
+static bool is(const char* mnemonic, const char* name) { return std::strcmp(mnemonic, name) == 0; }
+
+static Expectation expectation(const InstructionInfo& info) {
+    const char* m = info.mnemonic;
+    Expectation e = {info.length, 0};
+
+    if (info.mode == AddrMode::REL || info.mode == AddrMode::ZPR || is(m, "JMP")) e.pc = ANY;
+    if (is(m, "JSR")) e = {ANY, -2};
+    if (is(m, "RTS")) e = {ANY, 2};
+    if (is(m, "RTI")) e = {ANY, 3};
+    if (is(m, "BRK")) e = {ANY, -3};
+    if (is(m, "PHA") || is(m, "PHP") || is(m, "PHX") || is(m, "PHY")) e.sp = -1;
+    if (is(m, "PLA") || is(m, "PLP") || is(m, "PLX") || is(m, "PLY")) e.sp = 1;
+    if (is(m, "TXS")) e.sp = ANY;
+    return e;
+}
+
+struct Machine {
+    Bus bus;
+    FuzzMemory ram{"RAM", 0x4000, 0x00, true};
+    FuzzMemory scratch{"scratch RAM", 0x80, 0x00, true};
+    FuzzMemory rom{"ROM", 0x8000, 0xFF, false};
+    AddressDecoder decoder;
+    Expectation expected[256];
+
+    Machine() {
+        decoder.add_mapping(0x0000, 0x3FFF, &ram);
+        decoder.add_mapping(0x4000, 0x407F, &scratch);
+        decoder.add_mapping(0x8000, 0xFFFF, &rom);
+        for (int opcode = 0; opcode < 256; ++opcode) expected[opcode] = expectation(INSTRUCTIONS[opcode]);
+    }
+};
+
+static void fail(const char* what, word opcode_addr, byte opcode, const WDC65C02& cpu) {
+    std::fprintf(stderr, "%s after %s ($%02X) at $%04X: PC=$%04X SP=$%02X cycles=%llu\n", what,
+                 INSTRUCTIONS[opcode].mnemonic, opcode, opcode_addr, cpu.PC, cpu.SP,
+                 static_cast<unsigned long long>(cpu.cycles));
+    std::abort();
+}
+
+static void run_input(Machine& machine, const uint8_t* input, size_t size) {
+    machine.ram.restore();
+    machine.scratch.restore();
+    machine.rom.restore();
+
+    byte header[HEADER_SIZE] = {};
+    std::memcpy(header, input, std::min(size, HEADER_SIZE));
+    const byte* image = input + std::min(size, HEADER_SIZE);
+    size_t image_size = size > HEADER_SIZE ? size - HEADER_SIZE : 0;
+
+    size_t ram_size = std::min<size_t>(image_size, (header[7] % (MAX_RAM_PAGES + 1)) * 256);
+    machine.ram.load(image, ram_size);
+    machine.rom.load(image + ram_size, image_size - ram_size);
+
+    // A fresh CPU is only a handful of fields
+    WDC65C02 cpu(machine.bus, &machine.decoder);
+    cpu.A = header[0];
+    cpu.X = header[1];
+    cpu.Y = header[2];
+    cpu.SP = header[3];
+    cpu.FLAGS = header[4];
+    cpu.PC = header[5] | (header[6] << 8);
+    cpu.state = CPU_State::RUNNING;
+    cpu.set_idle_skip(true, 1024);
+    cpu.skip_limit = CYCLE_BUDGET;
+
+    while (cpu.state == CPU_State::RUNNING && cpu.cycles < CYCLE_BUDGET) {
+        word pc = cpu.PC;
+        byte sp = cpu.SP;
+        uint64_t cycles = cpu.cycles;
+        bool waiting = cpu.is_waiting();
+        byte opcode = machine.decoder.read(pc);
+
+        cpu.step();
+
+        if (cpu.cycles <= cycles) fail("Cycle count didn't advance", pc, opcode, cpu);
+        if (cpu.state != CPU_State::RUNNING || waiting) continue;
+
+        const Expectation& e = machine.expected[opcode];
+        if (e.pc != ANY && cpu.PC != static_cast<word>(pc + e.pc)) fail("PC out of step", pc, opcode, cpu);
+        if (e.sp != ANY && cpu.SP != static_cast<byte>(sp + e.sp)) fail("SP out of step", pc, opcode, cpu);
+    }
+}
+
+static Machine& machine() {
+    static Machine* instance = [] {
+        logger::enabled = false;  // Error paths are the point, not their output
+        return new Machine();
+    }();
+    return *instance;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    run_input(machine(), data, size);
+    return 0;
+}
+
+#ifndef M6502_LIBFUZZER
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+static bool run_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t runs = 0;
+    size_t files = 0;
+    auto started = std::chrono::steady_clock::now();
+
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument.rfind("-runs=", 0) == 0) {
+            runs = std::strtoull(argument.c_str() + 6, nullptr, 10);
+        } else if (std::filesystem::is_directory(argument)) {
+            for (const auto& entry : std::filesystem::directory_iterator(argument)) {
+                if (entry.is_regular_file() && run_file(entry.path().string())) files++;
+            }
+        } else if (run_file(argument)) {
+            files++;
+        } else {
+            return EXIT_FAILURE;
+        }
+    }
+    if (argc == 1) runs = 100000;
+
+    // Random inputs, up to 4K with a header biased towards the ROM
+    uint32_t random = 0x6502;
+    std::vector<uint8_t> input;
+    for (uint64_t run = 0; run < runs; ++run) {
+        auto next = [&random] {
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            return random;
+        };
+        input.resize(HEADER_SIZE + next() % 4096);
+        for (size_t i = 0; i < input.size(); i += 4) {
+            uint32_t bytes = next();
+            std::memcpy(input.data() + i, &bytes, std::min<size_t>(4, input.size() - i));
+        }
+        input[6] = 0x80 | input[6];  // PC in the ROM
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    uint64_t total = runs + files;
+    std::printf("%llu inputs in %.2fs (%.0f execs/s), no invariant broken\n", static_cast<unsigned long long>(total),
+                seconds, seconds > 0 ? total / seconds : 0);
+    return EXIT_SUCCESS;
+}
+
+#endif  // M6502_LIBFUZZER